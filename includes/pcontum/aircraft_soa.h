@@ -0,0 +1,348 @@
+#ifndef AIRCRAFT_SOA_H
+#define AIRCRAFT_SOA_H
+
+#include <pcontum/flight_model.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__)
+#define PCONTUM_SIMD_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PCONTUM_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+// The state of thousands of aircraft, stored field-by-field (structure of arrays) so the
+// per-tick kinematics can run 4 (SSE2) or 8 (AVX2) aircraft per instruction.
+//
+// step() runs the controls per aircraft (they are branchy and cheap) and the motion integration in SIMD.
+// stepScalar() is the reference path: it steps every aircraft through stepFlight() and is bit-for-bit
+// identical to the single-aircraft model. The SIMD path computes the same kinematics analytically
+// (no glm::rotate chain, one sincos per angle), so it matches the reference to float rounding only.
+class AircraftStateSoA
+{
+public:
+    std::vector<float> posX, posY, posZ;
+    std::vector<float> pitch, yaw, roll, speed;
+    std::vector<float> lastPitch, pitchRate, cobraStartTime;
+    std::vector<int32_t> cobra, touchingGround, pressingS; // 0 or 1
+    std::vector<FlightInput> inputs;                       // controls applied by the next step
+    std::vector<float> groundHeight;                       // surface under each aircraft for the next step
+
+    double time = 0.0; // shared simulation clock
+
+    size_t size() const { return posX.size(); }
+
+    // appends an aircraft; its clock is the container's, the camera orbit is not stored
+    size_t add(const FlightState &s)
+    {
+        posX.push_back(s.position.x);
+        posY.push_back(s.position.y);
+        posZ.push_back(s.position.z);
+        pitch.push_back(s.pitch);
+        yaw.push_back(s.yaw);
+        roll.push_back(s.roll);
+        speed.push_back(s.speed);
+        lastPitch.push_back(s.lastPitch);
+        pitchRate.push_back(s.pitchRate);
+        cobraStartTime.push_back(s.cobraStartTime);
+        cobra.push_back(s.cobra ? 1 : 0);
+        touchingGround.push_back(s.touchingGround ? 1 : 0);
+        pressingS.push_back(s.pressingS ? 1 : 0);
+        inputs.push_back(FlightInput());
+        groundHeight.push_back(0.0f);
+        movement.push_back(0.0f);
+        return size() - 1;
+    }
+
+    FlightState get(size_t i) const
+    {
+        FlightState s;
+        s.position = glm::vec3(posX[i], posY[i], posZ[i]);
+        s.pitch = pitch[i];
+        s.yaw = yaw[i];
+        s.roll = roll[i];
+        s.speed = speed[i];
+        s.lastPitch = lastPitch[i];
+        s.pitchRate = pitchRate[i];
+        s.cobraStartTime = cobraStartTime[i];
+        s.cobra = cobra[i] != 0;
+        s.touchingGround = touchingGround[i] != 0;
+        s.pressingS = pressingS[i] != 0;
+        s.time = time;
+        return s;
+    }
+
+    void set(size_t i, const FlightState &s)
+    {
+        posX[i] = s.position.x;
+        posY[i] = s.position.y;
+        posZ[i] = s.position.z;
+        pitch[i] = s.pitch;
+        yaw[i] = s.yaw;
+        roll[i] = s.roll;
+        speed[i] = s.speed;
+        lastPitch[i] = s.lastPitch;
+        pitchRate[i] = s.pitchRate;
+        cobraStartTime[i] = s.cobraStartTime;
+        cobra[i] = s.cobra ? 1 : 0;
+        touchingGround[i] = s.touchingGround ? 1 : 0;
+        pressingS[i] = s.pressingS ? 1 : 0;
+    }
+
+    // reference path, identical to calling stepFlight() on each aircraft
+    void stepScalar(float dt)
+    {
+        for (size_t i = 0; i < size(); ++i)
+        {
+            FlightState s = get(i);
+            stepFlight(s, inputs[i], dt, groundHeight[i]);
+            set(i, s);
+        }
+        time += dt;
+    }
+
+    // batch path: scalar controls, vectorized motion integration
+    void step(float dt)
+    {
+        for (size_t i = 0; i < size(); ++i)
+        {
+            FlightState s = get(i);
+            movement[i] = applyControls(s, inputs[i], dt);
+            set(i, s);
+        }
+
+        size_t simdEnd = 0;
+#if defined(PCONTUM_SIMD_AVX2)
+        simdEnd = integrateMotionBatch<Avx2>(dt);
+#elif defined(PCONTUM_SIMD_SSE2)
+        simdEnd = integrateMotionBatch<Sse2>(dt);
+#endif
+        for (size_t i = simdEnd; i < size(); ++i)
+        {
+            FlightState s = get(i);
+            integrateMotion(s, movement[i], dt, groundHeight[i]);
+            set(i, s);
+        }
+        time += dt;
+    }
+
+    // name of the instruction set step() was compiled for
+    static const char *simdName()
+    {
+#if defined(PCONTUM_SIMD_AVX2)
+        return "AVX2";
+#elif defined(PCONTUM_SIMD_SSE2)
+        return "SSE2";
+#else
+        return "scalar";
+#endif
+    }
+
+private:
+    std::vector<float> movement; // per-aircraft forward distance returned by applyControls()
+
+#if defined(PCONTUM_SIMD_AVX2)
+    struct Avx2
+    {
+        typedef __m256 f;
+        typedef __m256i i;
+        static const size_t width = 8;
+        static f set1(float v) { return _mm256_set1_ps(v); }
+        static f load(const float *p) { return _mm256_loadu_ps(p); }
+        static void store(float *p, f v) { _mm256_storeu_ps(p, v); }
+        static f add(f a, f b) { return _mm256_add_ps(a, b); }
+        static f sub(f a, f b) { return _mm256_sub_ps(a, b); }
+        static f mul(f a, f b) { return _mm256_mul_ps(a, b); }
+        static f div(f a, f b) { return _mm256_div_ps(a, b); }
+        static f and_(f a, f b) { return _mm256_and_ps(a, b); }
+        static f andnot(f a, f b) { return _mm256_andnot_ps(a, b); }
+        static f or_(f a, f b) { return _mm256_or_ps(a, b); }
+        static f xor_(f a, f b) { return _mm256_xor_ps(a, b); }
+        static f cmpgt(f a, f b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+        static f cmplt(f a, f b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+        static f cmple(f a, f b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+        static i iset1(int v) { return _mm256_set1_epi32(v); }
+        static i iload(const int32_t *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+        static void istore(int32_t *p, i v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+        static i iadd(i a, i b) { return _mm256_add_epi32(a, b); }
+        static i isub(i a, i b) { return _mm256_sub_epi32(a, b); }
+        static i iand(i a, i b) { return _mm256_and_si256(a, b); }
+        static i iandnot(i a, i b) { return _mm256_andnot_si256(a, b); }
+        static i icmpeq(i a, i b) { return _mm256_cmpeq_epi32(a, b); }
+        static i icmpgt(i a, i b) { return _mm256_cmpgt_epi32(a, b); }
+        static i ishl29(i a) { return _mm256_slli_epi32(a, 29); }
+        static i cvtt(f a) { return _mm256_cvttps_epi32(a); }
+        static f cvt(i a) { return _mm256_cvtepi32_ps(a); }
+        static f castf(i a) { return _mm256_castsi256_ps(a); }
+        static i casti(f a) { return _mm256_castps_si256(a); }
+    };
+#endif
+
+#if defined(PCONTUM_SIMD_AVX2) || defined(PCONTUM_SIMD_SSE2)
+    struct Sse2
+    {
+        typedef __m128 f;
+        typedef __m128i i;
+        static const size_t width = 4;
+        static f set1(float v) { return _mm_set1_ps(v); }
+        static f load(const float *p) { return _mm_loadu_ps(p); }
+        static void store(float *p, f v) { _mm_storeu_ps(p, v); }
+        static f add(f a, f b) { return _mm_add_ps(a, b); }
+        static f sub(f a, f b) { return _mm_sub_ps(a, b); }
+        static f mul(f a, f b) { return _mm_mul_ps(a, b); }
+        static f div(f a, f b) { return _mm_div_ps(a, b); }
+        static f and_(f a, f b) { return _mm_and_ps(a, b); }
+        static f andnot(f a, f b) { return _mm_andnot_ps(a, b); }
+        static f or_(f a, f b) { return _mm_or_ps(a, b); }
+        static f xor_(f a, f b) { return _mm_xor_ps(a, b); }
+        static f cmpgt(f a, f b) { return _mm_cmpgt_ps(a, b); }
+        static f cmplt(f a, f b) { return _mm_cmplt_ps(a, b); }
+        static f cmple(f a, f b) { return _mm_cmple_ps(a, b); }
+        static i iset1(int v) { return _mm_set1_epi32(v); }
+        static i iload(const int32_t *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+        static void istore(int32_t *p, i v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+        static i iadd(i a, i b) { return _mm_add_epi32(a, b); }
+        static i isub(i a, i b) { return _mm_sub_epi32(a, b); }
+        static i iand(i a, i b) { return _mm_and_si128(a, b); }
+        static i iandnot(i a, i b) { return _mm_andnot_si128(a, b); }
+        static i icmpeq(i a, i b) { return _mm_cmpeq_epi32(a, b); }
+        static i icmpgt(i a, i b) { return _mm_cmpgt_epi32(a, b); }
+        static i ishl29(i a) { return _mm_slli_epi32(a, 29); }
+        static i cvtt(f a) { return _mm_cvttps_epi32(a); }
+        static f cvt(i a) { return _mm_cvtepi32_ps(a); }
+        static f castf(i a) { return _mm_castsi128_ps(a); }
+        static i casti(f a) { return _mm_castps_si128(a); }
+    };
+
+    // mask ? b : a
+    template <class V>
+    static typename V::f select(typename V::f mask, typename V::f a, typename V::f b)
+    {
+        return V::or_(V::and_(mask, b), V::andnot(mask, a));
+    }
+
+    // Cephes-style sin/cos for |x| up to a few thousand radians (angles here stay within a turn or two)
+    template <class V>
+    static void sincos(typename V::f x, typename V::f &s, typename V::f &c)
+    {
+        typedef typename V::f f;
+        typedef typename V::i i;
+        const f signMask = V::castf(V::iset1(static_cast<int>(0x80000000u)));
+
+        f signSin = V::and_(x, signMask);
+        x = V::andnot(signMask, x);
+
+        i j = V::cvtt(V::mul(x, V::set1(1.27323954473516f))); // 4 / pi
+        j = V::iand(V::iadd(j, V::iset1(1)), V::iset1(~1));
+        f y = V::cvt(j);
+
+        f swapSignSin = V::castf(V::ishl29(V::iand(j, V::iset1(4))));
+        f polyMask = V::castf(V::icmpeq(V::iand(j, V::iset1(2)), V::iset1(0)));
+        f signCos = V::castf(V::ishl29(V::iandnot(V::isub(j, V::iset1(2)), V::iset1(4))));
+        signSin = V::xor_(signSin, swapSignSin);
+
+        // extended precision modular arithmetic: x - y * pi/4
+        x = V::add(x, V::mul(y, V::set1(-0.78515625f)));
+        x = V::add(x, V::mul(y, V::set1(-2.4187564849853515625e-4f)));
+        x = V::add(x, V::mul(y, V::set1(-3.77489497744594108e-8f)));
+        f z = V::mul(x, x);
+
+        f cosPoly = V::set1(2.443315711809948e-5f);
+        cosPoly = V::add(V::mul(cosPoly, z), V::set1(-1.388731625493765e-3f));
+        cosPoly = V::add(V::mul(cosPoly, z), V::set1(4.166664568298827e-2f));
+        cosPoly = V::mul(V::mul(cosPoly, z), z);
+        cosPoly = V::sub(cosPoly, V::mul(z, V::set1(0.5f)));
+        cosPoly = V::add(cosPoly, V::set1(1.0f));
+
+        f sinPoly = V::set1(-1.9515295891e-4f);
+        sinPoly = V::add(V::mul(sinPoly, z), V::set1(8.3321608736e-3f));
+        sinPoly = V::add(V::mul(sinPoly, z), V::set1(-1.6666654611e-1f));
+        sinPoly = V::add(V::mul(V::mul(sinPoly, z), x), x);
+
+        s = V::xor_(select<V>(polyMask, cosPoly, sinPoly), signSin);
+        c = V::xor_(select<V>(polyMask, sinPoly, cosPoly), signCos);
+    }
+
+    // the SIMD twin of integrateMotion(); returns the first index it did not process
+    template <class V>
+    size_t integrateMotionBatch(float dt)
+    {
+        typedef typename V::f f;
+        typedef typename V::i i;
+
+        const f zero = V::set1(0.0f);
+        const f one = V::set1(1.0f);
+        const f clearance = V::set1(FLIGHT_GROUND_CLEARANCE);
+        const f levelOffMargin = V::set1(FLIGHT_LEVEL_OFF_MARGIN);
+        const f degToRad = V::set1(glm::radians(1.0f));
+        const f gravityStep = V::set1(9.8f * dt * 0.5f);
+        const f vdt = V::set1(dt);
+        const f cobraSin = V::set1(std::sin(glm::radians(10.0f)));
+        const f cobraCos = V::set1(std::cos(glm::radians(10.0f)));
+        const i izero = V::iset1(0);
+        const i ione = V::iset1(1);
+
+        size_t n = size() - size() % V::width;
+        for (size_t k = 0; k < n; k += V::width)
+        {
+            f px = V::load(&posX[k]);
+            f py = V::load(&posY[k]);
+            f pz = V::load(&posZ[k]);
+            f p = V::load(&pitch[k]);
+            f r = V::load(&roll[k]);
+            f spd = V::load(&speed[k]);
+            f move = V::load(&movement[k]);
+
+            // Yerçekimi etkisi
+            py = V::sub(py, V::and_(V::cmpgt(spd, zero), gravityStep));
+
+            // forward = R(yaw) * R(pitch) * R(roll) * (0, 0, -1); roll does not move the nose axis
+            f sy, cy, sp, cp;
+            sincos<V>(V::mul(V::load(&yaw[k]), degToRad), sy, cy);
+            sincos<V>(V::mul(p, degToRad), sp, cp);
+            px = V::sub(px, V::mul(V::mul(sy, cp), move));
+            py = V::add(py, V::mul(sp, move));
+            pz = V::sub(pz, V::mul(V::mul(cy, cp), move));
+
+            // ground contact
+            f contact = V::add(V::load(&groundHeight[k]), clearance);
+            f touching = V::cmple(py, contact);
+            py = select<V>(touching, py, contact);
+
+            f notPressingS = V::castf(V::icmpeq(V::iload(&pressingS[k]), izero));
+            f levelOffHeight = V::add(contact, levelOffMargin);
+            f levelOff = V::and_(V::and_(V::cmplt(py, levelOffHeight), V::cmpgt(py, contact)), notPressingS);
+            p = V::andnot(levelOff, p);
+            r = V::andnot(levelOff, r);
+
+            V::store(&pitchRate[k], V::div(V::sub(p, V::load(&lastPitch[k])), vdt));
+            V::store(&lastPitch[k], p);
+
+            // second forward step uses the (possibly levelled) pitch, or the fixed cobra pitch
+            f cobraMask = V::castf(V::icmpgt(V::iload(&cobra[k]), izero));
+            sp = select<V>(levelOff, sp, zero);
+            cp = select<V>(levelOff, cp, one);
+            sp = select<V>(cobraMask, sp, cobraSin);
+            cp = select<V>(cobraMask, cp, cobraCos);
+            f distance = V::mul(spd, vdt);
+            px = V::sub(px, V::mul(V::mul(sy, cp), distance));
+            py = V::add(py, V::mul(sp, distance));
+            pz = V::sub(pz, V::mul(V::mul(cy, cp), distance));
+
+            V::store(&posX[k], px);
+            V::store(&posY[k], py);
+            V::store(&posZ[k], pz);
+            V::store(&pitch[k], p);
+            V::store(&roll[k], r);
+            V::istore(&touchingGround[k], V::iand(V::casti(touching), ione));
+        }
+        return n;
+    }
+#endif
+};
+
+#endif
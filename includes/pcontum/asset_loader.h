@@ -0,0 +1,307 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <stb_image.h>
+
+#include <pcontum/mesh_cache.h>
+#include <pcontum/model_data.h>
+#include <pcontum/packed_model.h>
+#include <pcontum/scene_model.h>
+#include <pcontum/thread_pool.h>
+
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Asynchronous asset loading: model loading (mesh cache or Assimp) and image decoding run on ThreadPool workers, the main thread
+// only creates GL objects. Textures are streamed through a small ring of pixel unpack buffers so that one
+// upload doesn't wait for the previous one. update() is called once per frame with a time budget so the
+// window can keep drawing a progress frame while the rest is still loading.
+
+// decoded 8-bit image, owned until it is uploaded
+struct ImageData
+{
+    int width = 0;
+    int height = 0;
+    int components = 0;
+    unsigned char *pixels = nullptr;
+};
+
+class AssetLoader
+{
+public:
+    explicit AssetLoader(ThreadPool &pool) : pool(pool) {}
+
+    ~AssetLoader()
+    {
+        // let in-flight jobs finish before their results go away
+        for (auto &model : models)
+            if (model->parse.valid())
+                model->parse.wait();
+        for (auto &model : packedModels)
+            if (model->pack.valid())
+                model->pack.wait();
+        for (auto &entry : textures)
+        {
+            if (entry.second.decode.valid())
+                stbi_image_free(entry.second.decode.get().pixels);
+        }
+        release();
+    }
+
+    // deletes the loader's GL objects; must run while the context is still current, so the owner calls it
+    // before glfwTerminate() and the destructor only catches what is left
+    void release()
+    {
+        for (auto &model : packedModels)
+            model->result.release();
+        if (!pbos.empty())
+            glDeleteBuffers(static_cast<GLsizei>(pbos.size()), pbos.data());
+        pbos.clear();
+        nextPbo = 0;
+    }
+
+    // starts parsing a model; the returned SceneModel gets its meshes once loading has finished
+    SceneModel *loadModel(const std::string &path)
+    {
+        std::unique_ptr<PendingModel> model(new PendingModel);
+        model->parse = pool.submit([path] { return loadModelData(path); });
+        models.push_back(std::move(model));
+        return &models.back()->result;
+    }
+
+    // like loadModel(), but the diffuse textures are packed into texture arrays and the meshes merged per
+    // array on the worker (see packed_model.h); the result is usable once loading has finished
+    PackedModel *loadPackedModel(const std::string &path)
+    {
+        std::unique_ptr<PendingPackedModel> model(new PendingPackedModel);
+        model->pack = pool.submit([path] { return packModel(loadModelData(path)); });
+        packedModels.push_back(std::move(model));
+        return &packedModels.back()->result;
+    }
+
+    // starts decoding an image; the texture name is valid right away, its contents arrive with update()
+    unsigned int loadTexture(const std::string &path)
+    {
+        auto found = textures.find(path);
+        if (found != textures.end())
+            return found->second.id;
+
+        PendingTexture &texture = textures[path];
+        glGenTextures(1, &texture.id);
+        texture.decode = pool.submit([path] {
+            ImageData image;
+            // read unflipped like loadTexturef()/Model did; the thread-local setting keeps the IBL bake's
+            // global stbi_set_flip_vertically_on_load(true) on the main thread from leaking in
+            stbi_set_flip_vertically_on_load_thread(false);
+            image.pixels = stbi_load(path.c_str(), &image.width, &image.height, &image.components, 0);
+            return image;
+        });
+        return texture.id;
+    }
+
+    // main-thread work for one frame: finishes parsed models and uploads decoded images until the budget
+    // is spent. Returns true once everything requested so far is on the GPU.
+    bool update(double budgetSeconds)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto overBudget = [&] {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > budgetSeconds;
+        };
+
+        for (auto &model : models)
+        {
+            if (model->parse.valid() && ready(model->parse))
+            {
+                model->data = model->parse.get();
+                model->result.directory = model->data.directory;
+                model->result.animation = std::move(model->data.animation);
+                // request every texture now so their decodes overlap with the mesh uploads below
+                for (MeshData &mesh : model->data.meshes)
+                    for (Texture &texture : mesh.textures)
+                        texture.id = loadTexture(model->data.directory + '/' + texture.path);
+            }
+            // a few meshes per frame; with a mesh cache the buffers are filled straight from the mapping
+            while (!model->parse.valid() && model->nextMesh < model->data.meshes.size() && !overBudget())
+            {
+                MeshData &mesh = model->data.meshes[model->nextMesh++];
+                model->result.meshes.emplace_back();
+                SceneMesh &sceneMesh = model->result.meshes.back();
+                sceneMesh.upload(mesh.vertexData, mesh.vertexCount, mesh.quantization, mesh.indexData, mesh.indexCount,
+                                 mesh.lodIndexData, mesh.lodIndexCount);
+                sceneMesh.textures = mesh.textures;
+                sceneMesh.lods = mesh.lods;
+            }
+            if (!model->parse.valid() && model->nextMesh > 0 && model->nextMesh == model->data.meshes.size())
+            {
+                // everything is on the GPU, drop the CPU copies (or unmap the cache)
+                model->data.meshes.clear();
+                model->data.mapping.reset();
+                model->nextMesh = 0;
+            }
+        }
+
+        for (auto &model : packedModels)
+        {
+            if (!overBudget() && model->pack.valid() && ready(model->pack))
+            {
+                PackedModelData data = model->pack.get();
+                model->result.upload(data);
+                model->result.collision = std::move(data.collision);
+            }
+        }
+
+        for (auto &entry : textures)
+        {
+            if (overBudget())
+                break;
+            PendingTexture &texture = entry.second;
+            if (texture.decode.valid() && ready(texture.decode))
+            {
+                ImageData image = texture.decode.get();
+                if (image.pixels)
+                    upload(texture.id, image);
+                else
+                    std::cout << "Texture failed to load at path: " << entry.first << std::endl;
+                stbi_image_free(image.pixels);
+                texture.uploaded = true;
+            }
+        }
+        return done();
+    }
+
+    bool done() const
+    {
+        for (const auto &model : models)
+            if (model->parse.valid() || model->nextMesh < model->data.meshes.size())
+                return false;
+        for (const auto &model : packedModels)
+            if (model->pack.valid())
+                return false;
+        for (const auto &entry : textures)
+            if (!entry.second.uploaded)
+                return false;
+        return true;
+    }
+
+    // fraction of finished work; models announce their textures only after parsing, so this never goes back
+    float progress()
+    {
+        size_t total = 0, finished = 0;
+        for (const auto &model : models)
+        {
+            total += 1 + model->data.meshes.size();
+            finished += (model->parse.valid() ? 0 : 1) + model->nextMesh;
+        }
+        for (const auto &model : packedModels)
+        {
+            total++;
+            finished += model->pack.valid() ? 0 : 1;
+        }
+        for (const auto &entry : textures)
+        {
+            total++;
+            finished += entry.second.uploaded ? 1 : 0;
+        }
+        float current = total ? float(finished) / float(total) : 1.0f;
+        shownProgress = std::max(shownProgress, current);
+        return shownProgress;
+    }
+
+private:
+    struct PendingModel
+    {
+        std::future<ModelData> parse;
+        ModelData data;
+        size_t nextMesh = 0;
+        SceneModel result;
+    };
+
+    struct PendingPackedModel
+    {
+        std::future<PackedModelData> pack;
+        PackedModel result;
+    };
+
+    struct PendingTexture
+    {
+        unsigned int id = 0;
+        std::future<ImageData> decode;
+        bool uploaded = false;
+    };
+
+    static const size_t PBO_COUNT = 4;
+
+    ThreadPool &pool;
+    std::vector<std::unique_ptr<PendingModel>> models;
+    std::vector<std::unique_ptr<PendingPackedModel>> packedModels;
+    std::map<std::string, PendingTexture> textures;
+    std::vector<unsigned int> pbos;
+    size_t nextPbo = 0;
+    float shownProgress = 0.0f;
+
+    template <typename T>
+    static bool ready(const std::future<T> &future)
+    {
+        return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    // same texture setup as TextureFromFile()/loadTexturef(), with the pixels going through a PBO
+    void upload(unsigned int id, const ImageData &image)
+    {
+        if (pbos.empty())
+        {
+            pbos.resize(PBO_COUNT);
+            glGenBuffers(static_cast<GLsizei>(PBO_COUNT), pbos.data());
+        }
+
+        GLenum format = GL_RGB;
+        if (image.components == 1)
+            format = GL_RED;
+        else if (image.components == 3)
+            format = GL_RGB;
+        else if (image.components == 4)
+            format = GL_RGBA;
+        size_t size = size_t(image.width) * image.height * image.components;
+
+        // orphan the buffer so the driver can hand out fresh storage while the old upload is still in flight
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos[nextPbo]);
+        nextPbo = (nextPbo + 1) % PBO_COUNT;
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (mapped)
+        {
+            std::memcpy(mapped, image.pixels, size);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+        else
+        {
+            // no mapping, fall back to a plain client-memory upload
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+
+        glBindTexture(GL_TEXTURE_2D, id);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // stb rows are tightly packed
+        glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE,
+                     mapped ? nullptr : image.pixels);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+};
+
+#endif
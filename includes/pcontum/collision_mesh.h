@@ -0,0 +1,519 @@
+#ifndef COLLISION_MESH_H
+#define COLLISION_MESH_H
+
+#include <glm/glm.hpp>
+
+#include <pcontum/culling.h>
+#include <pcontum/model_data.h>
+#include <pcontum/thread_pool.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// The triangles of a model kept on the CPU in a 4-wide BVH for ray casts and closest-point
+// queries. The tree is built once in model space when the model loads; the model's world transform is
+// applied to the queries instead of the triangles, so a moving model costs nothing to update. The
+// transform has to be rigid plus a uniform scale (like the carrier's); distances are in world units.
+//
+// Nodes hold four child boxes as an AabbPacket4, like Bvh4 in culling.h, and a ray or a point is tested
+// against all four with one SIMD pass. Leaves hold up to COLLISION_LEAF_TRIANGLES triangles, stored
+// in leaf order as a corner and two edges, ready for the ray test. Queries only read the tree, so
+// batches are split over a thread pool.
+
+const size_t COLLISION_LEAF_TRIANGLES = 4;
+const uint32_t COLLISION_NO_TRIANGLE = 0xffffffffu;
+
+struct CollisionRay
+{
+    glm::vec3 origin = glm::vec3(0.0f);
+    glm::vec3 direction = glm::vec3(0.0f, -1.0f, 0.0f); // unit length
+    float maxDistance = std::numeric_limits<float>::max();
+};
+
+struct CollisionHit
+{
+    float distance = std::numeric_limits<float>::max();
+    glm::vec3 point = glm::vec3(0.0f);
+    glm::vec3 normal = glm::vec3(0.0f); // unit, facing the ray
+    uint32_t triangle = COLLISION_NO_TRIANGLE; // index in build order
+
+    bool hit() const { return triangle != COLLISION_NO_TRIANGLE; }
+};
+
+struct CollisionPoint
+{
+    float distance = std::numeric_limits<float>::max();
+    glm::vec3 point = glm::vec3(0.0f);
+    uint32_t triangle = COLLISION_NO_TRIANGLE;
+
+    bool found() const { return triangle != COLLISION_NO_TRIANGLE; }
+};
+
+// bit i set when the ray enters box i before maxT; entry receives the entry distances
+inline int rayTest4(const AabbPacket4 &boxes, const glm::vec3 &origin, const glm::vec3 &inverseDirection, float maxT,
+                    float entry[4])
+{
+#ifdef PCONTUM_CULL_SSE
+    __m128 tNear = _mm_setzero_ps();
+    __m128 tFar = _mm_set1_ps(maxT);
+    const float *mins[3] = { boxes.minX, boxes.minY, boxes.minZ };
+    const float *maxs[3] = { boxes.maxX, boxes.maxY, boxes.maxZ };
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        __m128 o = _mm_set1_ps(origin[axis]);
+        __m128 inverse = _mm_set1_ps(inverseDirection[axis]);
+        __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(mins[axis]), o), inverse);
+        __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(maxs[axis]), o), inverse);
+        tNear = _mm_max_ps(tNear, _mm_min_ps(t0, t1));
+        tFar = _mm_min_ps(tFar, _mm_max_ps(t0, t1));
+    }
+    _mm_storeu_ps(entry, tNear);
+    return _mm_movemask_ps(_mm_cmple_ps(tNear, tFar));
+#else
+    int mask = 0;
+    const float *mins[3] = { boxes.minX, boxes.minY, boxes.minZ };
+    const float *maxs[3] = { boxes.maxX, boxes.maxY, boxes.maxZ };
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        float tNear = 0.0f, tFar = maxT;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float t0 = (mins[axis][lane] - origin[axis]) * inverseDirection[axis];
+            float t1 = (maxs[axis][lane] - origin[axis]) * inverseDirection[axis];
+            tNear = std::max(tNear, std::min(t0, t1));
+            tFar = std::min(tFar, std::max(t0, t1));
+        }
+        entry[lane] = tNear;
+        if (tNear <= tFar)
+            mask |= 1 << lane;
+    }
+    return mask;
+#endif
+}
+
+// squared distance from point to each of the four boxes (0 inside)
+inline void pointDistance4(const AabbPacket4 &boxes, const glm::vec3 &point, float distanceSquared[4])
+{
+#ifdef PCONTUM_CULL_SSE
+    __m128 sum = _mm_setzero_ps();
+    const float *mins[3] = { boxes.minX, boxes.minY, boxes.minZ };
+    const float *maxs[3] = { boxes.maxX, boxes.maxY, boxes.maxZ };
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        __m128 p = _mm_set1_ps(point[axis]);
+        __m128 below = _mm_sub_ps(_mm_load_ps(mins[axis]), p);
+        __m128 above = _mm_sub_ps(p, _mm_load_ps(maxs[axis]));
+        __m128 d = _mm_max_ps(_mm_max_ps(below, above), _mm_setzero_ps());
+        sum = _mm_add_ps(sum, _mm_mul_ps(d, d));
+    }
+    _mm_storeu_ps(distanceSquared, sum);
+#else
+    const float *mins[3] = { boxes.minX, boxes.minY, boxes.minZ };
+    const float *maxs[3] = { boxes.maxX, boxes.maxY, boxes.maxZ };
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        float sum = 0.0f;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float d = std::max(std::max(mins[axis][lane] - point[axis], point[axis] - maxs[axis][lane]), 0.0f);
+            sum += d * d;
+        }
+        distanceSquared[lane] = sum;
+    }
+#endif
+}
+
+// closest point of triangle (a, b, c) to p (Ericson, Real-Time Collision Detection 5.1.5)
+inline glm::vec3 closestPointOnTriangle(const glm::vec3 &p, const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c)
+{
+    glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+    float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+        return a;
+    glm::vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3)
+        return b;
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return a + ab * (d1 / (d1 - d3));
+    glm::vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6)
+        return c;
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return a + ac * (d2 / (d2 - d6));
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+    float denominator = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+class CollisionMesh
+{
+public:
+    // appends a triangle list in model space; build() makes it queryable
+    void addTriangles(const glm::vec3 *positions, const unsigned int *indices, size_t indexCount)
+    {
+        for (size_t i = 0; i + 2 < indexCount; i += 3)
+        {
+            Triangle triangle;
+            triangle.a = positions[indices[i]];
+            triangle.edge1 = positions[indices[i + 1]] - triangle.a;
+            triangle.edge2 = positions[indices[i + 2]] - triangle.a;
+            // degenerate triangles can't be hit and only make the tree bigger
+            if (glm::dot(glm::cross(triangle.edge1, triangle.edge2), glm::cross(triangle.edge1, triangle.edge2)) > 0.0f)
+            {
+                triangle.source = static_cast<uint32_t>(sourceCount);
+                triangles.push_back(triangle);
+            }
+            sourceCount++;
+        }
+    }
+
+    void build()
+    {
+        nodes.clear();
+        if (triangles.empty())
+            return;
+        std::vector<Aabb> boxes(triangles.size());
+        for (size_t i = 0; i < triangles.size(); ++i)
+        {
+            const Triangle &t = triangles[i];
+            boxes[i].expand(t.a);
+            boxes[i].expand(t.a + t.edge1);
+            boxes[i].expand(t.a + t.edge2);
+        }
+        std::vector<uint32_t> order(triangles.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = static_cast<uint32_t>(i);
+        buildNode(boxes, order, 0, order.size(), bounds);
+
+        std::vector<Triangle> sorted(triangles.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            sorted[i] = triangles[order[i]];
+        triangles.swap(sorted);
+    }
+
+    // model space to world space; rigid plus uniform scale
+    void setTransform(const glm::mat4 &world)
+    {
+        toWorld = world;
+        toModel = glm::inverse(world);
+        scale = glm::length(glm::vec3(world[0]));
+    }
+
+    bool empty() const { return nodes.empty(); }
+    size_t triangleCount() const { return triangles.size(); }
+    size_t nodeCount() const { return nodes.size(); }
+    const Aabb &modelBounds() const { return bounds; }
+
+    // nearest hit along the ray within its maxDistance, from either side of a triangle; false on a miss
+    bool raycast(const CollisionRay &ray, CollisionHit &hit) const
+    {
+        hit = CollisionHit();
+        if (nodes.empty())
+            return false;
+        // the ray parameter is the same in both spaces, so maxDistance carries over as is
+        glm::vec3 origin = glm::vec3(toModel * glm::vec4(ray.origin, 1.0f));
+        glm::vec3 direction = glm::vec3(toModel * glm::vec4(ray.direction, 0.0f));
+        glm::vec3 inverse;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            // a tiny stand-in for zero keeps the slab test free of 0 * inf
+            float d = direction[axis];
+            inverse[axis] = 1.0f / (std::fabs(d) > 1e-20f ? d : (d < 0.0f ? -1e-20f : 1e-20f));
+        }
+
+        float best = ray.maxDistance;
+        uint32_t bestTriangle = COLLISION_NO_TRIANGLE;
+        uint32_t stack[STACK_SIZE];
+        float stackEntry[STACK_SIZE];
+        int top = 0;
+        stack[top] = 0;
+        stackEntry[top++] = 0.0f;
+        while (top > 0)
+        {
+            --top;
+            if (stackEntry[top] > best)
+                continue;
+            const Node &node = nodes[stack[top]];
+            float entry[4];
+            int mask = rayTest4(node.bounds, origin, inverse, best, entry) & ((1 << node.count) - 1);
+
+            // leaves right away, inner nodes pushed farthest first so the nearest is visited next
+            int pending[4];
+            int pendingCount = 0;
+            for (int lane = 0; lane < node.count; ++lane)
+            {
+                if (!(mask & (1 << lane)))
+                    continue;
+                if (node.triangles[lane] > 0)
+                {
+                    for (uint32_t i = 0; i < node.triangles[lane]; ++i)
+                    {
+                        uint32_t index = static_cast<uint32_t>(node.child[lane]) + i;
+                        if (intersect(triangles[index], origin, direction, best))
+                            bestTriangle = index;
+                    }
+                }
+                else
+                {
+                    pending[pendingCount++] = lane;
+                }
+            }
+            sortFarthestFirst(pending, pendingCount, entry);
+            for (int i = 0; i < pendingCount && top < STACK_SIZE; ++i)
+            {
+                stack[top] = static_cast<uint32_t>(node.child[pending[i]]);
+                stackEntry[top++] = entry[pending[i]];
+            }
+        }
+        if (bestTriangle == COLLISION_NO_TRIANGLE)
+            return false;
+
+        const Triangle &triangle = triangles[bestTriangle];
+        glm::vec3 normal = glm::normalize(glm::mat3(toWorld) * glm::cross(triangle.edge1, triangle.edge2));
+        hit.distance = best;
+        hit.point = ray.origin + ray.direction * best;
+        hit.normal = glm::dot(normal, ray.direction) > 0.0f ? -normal : normal;
+        hit.triangle = triangle.source;
+        return true;
+    }
+
+    // nearest surface point within maxDistance of point; false if there is none
+    bool closestPoint(const glm::vec3 &point, float maxDistance, CollisionPoint &result) const
+    {
+        result = CollisionPoint();
+        if (nodes.empty())
+            return false;
+        glm::vec3 p = glm::vec3(toModel * glm::vec4(point, 1.0f));
+        float limit = maxDistance / scale;
+        float best = limit < std::sqrt(std::numeric_limits<float>::max()) ? limit * limit : std::numeric_limits<float>::max();
+        uint32_t bestTriangle = COLLISION_NO_TRIANGLE;
+        glm::vec3 bestPoint(0.0f);
+
+        uint32_t stack[STACK_SIZE];
+        float stackDistance[STACK_SIZE];
+        int top = 0;
+        stack[top] = 0;
+        stackDistance[top++] = 0.0f;
+        while (top > 0)
+        {
+            --top;
+            if (stackDistance[top] > best)
+                continue;
+            const Node &node = nodes[stack[top]];
+            float distance[4];
+            pointDistance4(node.bounds, p, distance);
+
+            int pending[4];
+            int pendingCount = 0;
+            for (int lane = 0; lane < node.count; ++lane)
+            {
+                if (distance[lane] > best)
+                    continue;
+                if (node.triangles[lane] > 0)
+                {
+                    for (uint32_t i = 0; i < node.triangles[lane]; ++i)
+                    {
+                        uint32_t index = static_cast<uint32_t>(node.child[lane]) + i;
+                        const Triangle &t = triangles[index];
+                        glm::vec3 q = closestPointOnTriangle(p, t.a, t.a + t.edge1, t.a + t.edge2);
+                        float d = glm::dot(q - p, q - p);
+                        if (d <= best)
+                        {
+                            best = d;
+                            bestTriangle = index;
+                            bestPoint = q;
+                        }
+                    }
+                }
+                else
+                {
+                    pending[pendingCount++] = lane;
+                }
+            }
+            sortFarthestFirst(pending, pendingCount, distance);
+            for (int i = 0; i < pendingCount && top < STACK_SIZE; ++i)
+            {
+                stack[top] = static_cast<uint32_t>(node.child[pending[i]]);
+                stackDistance[top++] = distance[pending[i]];
+            }
+        }
+        if (bestTriangle == COLLISION_NO_TRIANGLE)
+            return false;
+        result.distance = std::sqrt(best) * scale;
+        result.point = glm::vec3(toWorld * glm::vec4(bestPoint, 1.0f));
+        result.triangle = triangles[bestTriangle].source;
+        return true;
+    }
+
+    // batches: one result per query; with a pool, large batches are split over its threads. Not from
+    // inside a pool job (see ThreadPool::parallelFor).
+    void raycast(const CollisionRay *rays, size_t count, CollisionHit *hits, ThreadPool *pool = nullptr) const
+    {
+        forEach(count, pool, [&](size_t i) { raycast(rays[i], hits[i]); });
+    }
+
+    void closestPoint(const glm::vec3 *points, size_t count, float maxDistance, CollisionPoint *results,
+                      ThreadPool *pool = nullptr) const
+    {
+        forEach(count, pool, [&](size_t i) { closestPoint(points[i], maxDistance, results[i]); });
+    }
+
+private:
+    // 4-wide nodes split a range into four, so the depth stays small; three lanes per level wait on the
+    // stack at most
+    static const int STACK_SIZE = 96;
+    static const size_t PARALLEL_GRAIN = 64;
+
+    struct Triangle
+    {
+        glm::vec3 a;
+        glm::vec3 edge1;
+        glm::vec3 edge2;
+        uint32_t source = 0;
+    };
+
+    struct Node
+    {
+        AabbPacket4 bounds;
+        int32_t child[4];      // first triangle of a leaf lane, node index otherwise
+        uint32_t triangles[4]; // triangle count of a leaf lane, 0 for an inner one
+        int count = 0;
+    };
+
+    std::vector<Triangle> triangles;
+    std::vector<Node> nodes;
+    size_t sourceCount = 0;
+    Aabb bounds;
+    glm::mat4 toWorld = glm::mat4(1.0f);
+    glm::mat4 toModel = glm::mat4(1.0f);
+    float scale = 1.0f;
+
+    // Möller-Trumbore, both sides; shortens best on a nearer hit
+    static bool intersect(const Triangle &t, const glm::vec3 &origin, const glm::vec3 &direction, float &best)
+    {
+        glm::vec3 p = glm::cross(direction, t.edge2);
+        float determinant = glm::dot(t.edge1, p);
+        if (std::fabs(determinant) < 1e-12f)
+            return false;
+        float inverse = 1.0f / determinant;
+        glm::vec3 s = origin - t.a;
+        float u = glm::dot(s, p) * inverse;
+        if (u < 0.0f || u > 1.0f)
+            return false;
+        glm::vec3 q = glm::cross(s, t.edge1);
+        float v = glm::dot(direction, q) * inverse;
+        if (v < 0.0f || u + v > 1.0f)
+            return false;
+        float distance = glm::dot(t.edge2, q) * inverse;
+        if (distance < 0.0f || distance >= best)
+            return false;
+        best = distance;
+        return true;
+    }
+
+    // at most four lanes: an insertion sort, by key descending, so the nearest lane is pushed last
+    static void sortFarthestFirst(int *lanes, int count, const float *key)
+    {
+        for (int i = 1; i < count; ++i)
+        {
+            int lane = lanes[i];
+            int j = i;
+            for (; j > 0 && key[lanes[j - 1]] < key[lane]; --j)
+                lanes[j] = lanes[j - 1];
+            lanes[j] = lane;
+        }
+    }
+
+    template <typename F>
+    static void forEach(size_t count, ThreadPool *pool, F &&query)
+    {
+        if (pool && count > PARALLEL_GRAIN)
+        {
+            pool->parallelFor(count, PARALLEL_GRAIN, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i)
+                    query(i);
+            });
+            return;
+        }
+        for (size_t i = 0; i < count; ++i)
+            query(i);
+    }
+
+    // same split as Bvh4::buildNode, but ranges of up to COLLISION_LEAF_TRIANGLES end in a leaf lane
+    int32_t buildNode(const std::vector<Aabb> &boxes, std::vector<uint32_t> &order, size_t begin, size_t end, Aabb &nodeBounds)
+    {
+        int32_t index = static_cast<int32_t>(nodes.size());
+        nodes.emplace_back();
+
+        Aabb centroids;
+        for (size_t i = begin; i < end; ++i)
+            centroids.expand(boxes[order[i]].center());
+        glm::vec3 extent = centroids.max - centroids.min;
+        int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        std::sort(order.begin() + begin, order.begin() + end, [&](uint32_t a, uint32_t b) {
+            return boxes[a].center()[axis] < boxes[b].center()[axis];
+        });
+
+        size_t count = end - begin;
+        int parts = count <= COLLISION_LEAF_TRIANGLES ? 1 : 4;
+        for (int part = 0; part < parts; ++part)
+        {
+            size_t partBegin = begin + count * part / parts;
+            size_t partEnd = begin + count * (part + 1) / parts;
+            Aabb partBounds;
+            int32_t child;
+            uint32_t leafTriangles = 0;
+            if (partEnd - partBegin <= COLLISION_LEAF_TRIANGLES)
+            {
+                for (size_t i = partBegin; i < partEnd; ++i)
+                    partBounds.expand(boxes[order[i]]);
+                child = static_cast<int32_t>(partBegin);
+                leafTriangles = static_cast<uint32_t>(partEnd - partBegin);
+            }
+            else
+            {
+                child = buildNode(boxes, order, partBegin, partEnd, partBounds);
+            }
+            nodes[index].bounds.set(part, partBounds);
+            nodes[index].child[part] = child;
+            nodes[index].triangles[part] = leafTriangles;
+            nodeBounds.expand(partBounds);
+        }
+        nodes[index].count = parts;
+        for (int part = parts; part < 4; ++part)
+        {
+            nodes[index].bounds.set(part, Aabb());
+            nodes[index].child[part] = -1;
+            nodes[index].triangles[part] = 0;
+        }
+        return index;
+    }
+};
+
+// the full-detail triangles of every mesh of a parsed (or cached) model, in model space
+inline CollisionMesh buildCollisionMesh(const ModelData &model)
+{
+    CollisionMesh collision;
+    std::vector<glm::vec3> positions;
+    for (const MeshData &mesh : model.meshes)
+    {
+        positions.resize(mesh.vertexCount);
+        for (size_t i = 0; i < mesh.vertexCount; ++i)
+            positions[i] = unpackPosition(mesh.vertexData[i], mesh.quantization);
+        collision.addTriangles(positions.data(), mesh.indexData, mesh.indexCount);
+    }
+    collision.build();
+    return collision;
+}
+
+#endif
@@ -0,0 +1,302 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define PCONTUM_CULL_SSE
+#include <xmmintrin.h>
+#endif
+
+// Frustum culling: axis-aligned boxes per mesh, a 4-wide BVH over their world-space boxes and a
+// frustum test that checks four boxes against a plane per instruction. Only the plane's "positive"
+// corner is tested, so a box is rejected when it is completely behind one plane; boxes that straddle a
+// frustum corner can pass, which is the usual conservative answer.
+
+struct Aabb
+{
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+
+    bool empty() const { return min.x > max.x; }
+    glm::vec3 center() const { return (min + max) * 0.5f; }
+
+    void expand(const glm::vec3 &point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void expand(const Aabb &box)
+    {
+        min = glm::min(min, box.min);
+        max = glm::max(max, box.max);
+    }
+};
+
+// bounds of anything with a Position member (Vertex)
+template <typename V>
+inline Aabb boundsOf(const V *vertices, size_t count)
+{
+    Aabb box;
+    for (size_t i = 0; i < count; ++i)
+        box.expand(vertices[i].Position);
+    return box;
+}
+
+// world-space box of a transformed box (Arvo): every matrix entry moves min and max independently
+inline Aabb transformAabb(const Aabb &box, const glm::mat4 &transform)
+{
+    if (box.empty())
+        return box;
+    Aabb result;
+    result.min = result.max = glm::vec3(transform[3]);
+    for (int column = 0; column < 3; ++column)
+    {
+        for (int row = 0; row < 3; ++row)
+        {
+            float a = transform[column][row] * box.min[column];
+            float b = transform[column][row] * box.max[column];
+            result.min[row] += std::min(a, b);
+            result.max[row] += std::max(a, b);
+        }
+    }
+    return result;
+}
+
+// six planes (xyz normal pointing inside, w distance) of projection * view
+struct Frustum
+{
+    glm::vec4 planes[6];
+};
+
+inline Frustum extractFrustum(const glm::mat4 &viewProjection)
+{
+    // Gribb & Hartmann: rows of the clip matrix; glm is column-major, so row i is m[0][i], m[1][i] ...
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; ++i)
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+    Frustum frustum;
+    frustum.planes[0] = rows[3] + rows[0]; // left
+    frustum.planes[1] = rows[3] - rows[0]; // right
+    frustum.planes[2] = rows[3] + rows[1]; // bottom
+    frustum.planes[3] = rows[3] - rows[1]; // top
+    frustum.planes[4] = rows[3] + rows[2]; // near
+    frustum.planes[5] = rows[3] - rows[2]; // far
+    for (glm::vec4 &plane : frustum.planes)
+        plane = plane * (1.0f / glm::length(glm::vec3(plane)));
+    return frustum;
+}
+
+// four boxes, one component per array, so a plane tests all of them at once
+struct AabbPacket4
+{
+    alignas(16) float minX[4];
+    alignas(16) float minY[4];
+    alignas(16) float minZ[4];
+    alignas(16) float maxX[4];
+    alignas(16) float maxY[4];
+    alignas(16) float maxZ[4];
+
+    void set(int lane, const Aabb &box)
+    {
+        minX[lane] = box.min.x;
+        minY[lane] = box.min.y;
+        minZ[lane] = box.min.z;
+        maxX[lane] = box.max.x;
+        maxY[lane] = box.max.y;
+        maxZ[lane] = box.max.z;
+    }
+};
+
+// bit i set when box i is at least partly inside
+inline int frustumTest4(const Frustum &frustum, const AabbPacket4 &boxes)
+{
+#ifdef PCONTUM_CULL_SSE
+    __m128 outside = _mm_setzero_ps();
+    for (const glm::vec4 &plane : frustum.planes)
+    {
+        // the corner furthest along the normal is picked per plane, not per box, so it is a pointer choice
+        __m128 x = _mm_load_ps(plane.x >= 0.0f ? boxes.maxX : boxes.minX);
+        __m128 y = _mm_load_ps(plane.y >= 0.0f ? boxes.maxY : boxes.minY);
+        __m128 z = _mm_load_ps(plane.z >= 0.0f ? boxes.maxZ : boxes.minZ);
+        __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_mul_ps(y, _mm_set1_ps(plane.y))),
+                                     _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+        outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+    }
+    return ~_mm_movemask_ps(outside) & 0xf;
+#else
+    int visible = 0xf;
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        for (const glm::vec4 &plane : frustum.planes)
+        {
+            float x = plane.x >= 0.0f ? boxes.maxX[lane] : boxes.minX[lane];
+            float y = plane.y >= 0.0f ? boxes.maxY[lane] : boxes.minY[lane];
+            float z = plane.z >= 0.0f ? boxes.maxZ[lane] : boxes.minZ[lane];
+            if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f)
+            {
+                visible &= ~(1 << lane);
+                break;
+            }
+        }
+    }
+    return visible;
+#endif
+}
+
+struct CullStats
+{
+    size_t boxesTested = 0; // BVH nodes and items that went through the frustum test
+    size_t items = 0;
+    size_t culled = 0;
+
+    CullStats &operator+=(const CullStats &other)
+    {
+        boxesTested += other.boxesTested;
+        items += other.items;
+        culled += other.culled;
+        return *this;
+    }
+};
+
+// a flat list of boxes (moving objects), four per test
+inline void cullBoxes(const Frustum &frustum, const std::vector<Aabb> &boxes, std::vector<uint32_t> &visible,
+                      CullStats &stats)
+{
+    size_t before = visible.size();
+    for (size_t first = 0; first < boxes.size(); first += 4)
+    {
+        int lanes = static_cast<int>(std::min<size_t>(4, boxes.size() - first));
+        AabbPacket4 packet;
+        for (int lane = 0; lane < 4; ++lane)
+            packet.set(lane, boxes[first + std::min(lane, lanes - 1)]);
+        int mask = frustumTest4(frustum, packet);
+        for (int lane = 0; lane < lanes; ++lane)
+            if (mask & (1 << lane))
+                visible.push_back(static_cast<uint32_t>(first + lane));
+    }
+    stats.boxesTested += boxes.size();
+    stats.items += boxes.size();
+    stats.culled += boxes.size() - (visible.size() - before);
+}
+
+// 4-wide BVH over static world-space boxes: every node holds the boxes of up to four children, which are
+// either inner nodes or single items, so one frustumTest4 decides a whole node
+class Bvh4
+{
+public:
+    void build(const std::vector<Aabb> &items)
+    {
+        nodes.clear();
+        itemCount = items.size();
+        if (items.empty())
+            return;
+        std::vector<uint32_t> order(items.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = static_cast<uint32_t>(i);
+        Aabb bounds;
+        buildNode(items, order, 0, order.size(), bounds);
+    }
+
+    // appends the visible items; culled subtrees are skipped whole
+    void cull(const Frustum &frustum, std::vector<uint32_t> &visible, CullStats &stats) const
+    {
+        size_t before = visible.size();
+        if (!nodes.empty())
+        {
+            stack.clear();
+            stack.push_back(0);
+            while (!stack.empty())
+            {
+                const Node &node = nodes[stack.back()];
+                stack.pop_back();
+                int mask = frustumTest4(frustum, node.bounds) & ((1 << node.count) - 1);
+                stats.boxesTested += node.count;
+                for (int lane = 0; lane < node.count; ++lane)
+                {
+                    if (!(mask & (1 << lane)))
+                        continue;
+                    if (node.child[lane] >= 0)
+                        stack.push_back(static_cast<uint32_t>(node.child[lane]));
+                    else
+                        visible.push_back(static_cast<uint32_t>(~node.child[lane]));
+                }
+            }
+        }
+        stats.items += itemCount;
+        stats.culled += itemCount - (visible.size() - before);
+    }
+
+    size_t nodeCount() const { return nodes.size(); }
+
+private:
+    struct Node
+    {
+        AabbPacket4 bounds;
+        int32_t child[4]; // >= 0: inner node, < 0: ~item
+        int count = 0;
+    };
+
+    std::vector<Node> nodes;
+    size_t itemCount = 0;
+    mutable std::vector<uint32_t> stack;
+
+    // builds the node for order[begin, end) and returns its index; bounds receives the union of the range
+    int32_t buildNode(const std::vector<Aabb> &items, std::vector<uint32_t> &order, size_t begin, size_t end, Aabb &bounds)
+    {
+        int32_t index = static_cast<int32_t>(nodes.size());
+        nodes.emplace_back();
+
+        // split along the longest axis of the centroids into up to four equal parts
+        Aabb centroids;
+        for (size_t i = begin; i < end; ++i)
+            centroids.expand(items[order[i]].center());
+        glm::vec3 extent = centroids.max - centroids.min;
+        int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        std::sort(order.begin() + begin, order.begin() + end, [&](uint32_t a, uint32_t b) {
+            return items[a].center()[axis] < items[b].center()[axis];
+        });
+
+        size_t count = end - begin;
+        int parts = static_cast<int>(std::min<size_t>(4, count));
+        for (int part = 0; part < parts; ++part)
+        {
+            size_t partBegin = begin + count * part / parts;
+            size_t partEnd = begin + count * (part + 1) / parts;
+            Aabb partBounds;
+            int32_t child;
+            if (partEnd - partBegin == 1)
+            {
+                partBounds = items[order[partBegin]];
+                child = ~static_cast<int32_t>(order[partBegin]);
+            }
+            else
+            {
+                child = buildNode(items, order, partBegin, partEnd, partBounds);
+            }
+            // nodes may have grown, so index again instead of holding a reference
+            nodes[index].bounds.set(part, partBounds);
+            nodes[index].child[part] = child;
+            bounds.expand(partBounds);
+        }
+        nodes[index].count = parts;
+        // unused lanes are masked off in cull()
+        for (int part = parts; part < 4; ++part)
+        {
+            nodes[index].bounds.set(part, Aabb());
+            nodes[index].child[part] = -1;
+        }
+        return index;
+    }
+};
+
+#endif
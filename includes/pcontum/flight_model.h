@@ -0,0 +1,259 @@
+#ifndef FLIGHT_MODEL_H
+#define FLIGHT_MODEL_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// The flight model advances one airplane's state in fixed steps, without any window, GL or GLFW dependency.
+// The same code drives the windowed game and the headless benchmark, so both see identical physics.
+
+// height of the airplane's origin above the surface under it while it rests on the ground or the deck
+const float FLIGHT_GROUND_CLEARANCE = 1.0f;
+// below this much more than the rest height the wings level off unless the pilot is pulling up (S)
+const float FLIGHT_LEVEL_OFF_MARGIN = 0.5f;
+
+// pilot input for a single tick, sampled from the keyboard or from a scripted track
+struct FlightInput
+{
+    bool pitchDown = false;    // W
+    bool pitchUp = false;      // S
+    bool rollLeft = false;     // A
+    bool rollRight = false;    // D
+    bool throttleUp = false;   // '+' / '='
+    bool throttleDown = false; // '-'
+    bool stop = false;         // F
+    bool cobra = false;        // C
+    bool cameraUp = false;     // arrow keys orbit the chase camera
+    bool cameraDown = false;
+    bool cameraLeft = false;
+    bool cameraRight = false;
+};
+
+// everything the flight model needs to carry from one tick to the next
+struct FlightState
+{
+    glm::vec3 position = glm::vec3(-102.815f, 1.0f, -59.034f);
+    glm::vec3 cameraOffset = glm::vec3(0.0f, 8.0f, 0.0f); // orbit angles of the chase camera (degrees)
+
+    float pitch = 0.0f; // x-axis rotation
+    float yaw = 0.0f;   // y-axis rotation
+    float roll = 0.0f;  // z-axis rotation
+    float speed = 1.0f;
+
+    bool cobra = false;
+    bool touchingGround = false;
+    bool pressingS = false;
+
+    float lastPitch = 0.0f;
+    float pitchRate = 0.0f; // degrees per second, measured over the last tick
+    float cobraStartTime = 0.0f;
+
+    double time = 0.0; // simulated seconds
+};
+
+// W/S (or vertical mouse motion) pitches the nose, banked turns bleed into yaw.
+// direction is +1 for nose down (W), -1 for nose up (S).
+inline void steerPitch(float &zpitch, float &zyaw, float zroll, int direction, float rotationSpeed)
+{
+    float pitchcalc = (rotationSpeed * (1.0f - (std::fabs(zroll) / 90.0f)));
+    float yawcalc = (rotationSpeed * ((zroll) / 90.0f));
+
+    if (direction == 1) {
+        if (zroll == 0.0f) {
+            zpitch -= rotationSpeed;
+        } else {
+            zpitch -= pitchcalc;
+            zyaw -= yawcalc;
+        }
+    } else if (direction == -1) {
+        if (zroll == 0.0f) {
+            zpitch += rotationSpeed;
+        } else {
+            zpitch += pitchcalc;
+            zyaw += yawcalc;
+        }
+    }
+}
+
+// applies the throttle, stick, cobra and camera inputs of one tick.
+// returns the distance to fly along the nose this tick, captured before the inputs change speed or cobra.
+inline float applyControls(FlightState &s, const FlightInput &in, float dt)
+{
+    float movementSpeed = s.speed * dt;
+    float rotationSpeed = 50.0f * dt;
+    if (s.cobra)
+        movementSpeed *= 0.05f;
+    float cameraMoveSpeed = 50.0f * dt; // Kamera hareket hızı
+
+    // Hızlandırma ve yavaşlatma
+    if (in.throttleUp)
+        s.speed += 10.0f * dt;
+    if (in.throttleDown)
+        s.speed = glm::max(s.speed - 10.0f * dt, 0.0f);
+
+    // Uçağı durdurma
+    if (in.stop)
+        s.speed = 0.0f;
+
+    float zroll = std::fmod(s.roll, 360.0f);
+    float zpitch = std::fmod(s.pitch + 180.0f, 360.0f) - 180.0f;
+    float zyaw = std::fmod(s.yaw, 360.0f);
+
+    int wscalc = 0;
+    if (in.pitchDown)
+        wscalc = 1;
+    else if (in.pitchUp)
+        wscalc = -1;
+    s.pressingS = (wscalc == -1);
+
+    steerPitch(zpitch, zyaw, zroll, wscalc, rotationSpeed);
+
+    zpitch = std::clamp(zpitch, -179.0f, 179.0f);
+
+    s.pitch = zpitch;
+    s.yaw = zyaw;
+    s.roll = zroll;
+
+    if ((((s.pitch > 89.0f && s.pitch < 129.0f) && s.pitchRate >= 40.0f) || in.cobra) && s.cobra == false) {
+        s.cobra = true;
+        s.cobraStartTime = static_cast<float>(s.time);
+    }
+    else if ((s.pitch < 89.0f && s.pitch > 10.0f && s.cobra == true) || (s.pitch > 130.0f && s.cobra == true)) {
+        s.cobra = false;
+    }
+
+    if (s.cobra && (s.time - s.cobraStartTime >= 3.0f))
+        s.cobra = false;
+
+    if (in.rollRight) {
+        if (s.touchingGround)
+            s.yaw -= rotationSpeed;
+        else
+            s.roll -= (rotationSpeed * 1.5f);
+    }
+    if (in.rollLeft) {
+        if (s.touchingGround)
+            s.yaw += rotationSpeed;
+        else
+            s.roll += (rotationSpeed * 1.5f);
+    }
+
+    // Kamera offsetini uçak konumundan bağımsız değiştir
+    if (in.cameraUp)
+        s.cameraOffset.y += cameraMoveSpeed;
+    if (in.cameraDown)
+        s.cameraOffset.y -= cameraMoveSpeed;
+    if (in.cameraLeft)
+        s.cameraOffset.x -= cameraMoveSpeed;
+    if (in.cameraRight)
+        s.cameraOffset.x += cameraMoveSpeed;
+
+    return movementSpeed;
+}
+
+// airplane orientation built from the current yaw/pitch/roll angles
+inline glm::quat flightRotation(const FlightState &s)
+{
+    glm::quat yawQuat = glm::angleAxis(glm::radians(s.yaw), glm::vec3(0, 1, 0));     // Yaw (yön)
+    glm::quat pitchQuat = glm::angleAxis(glm::radians(s.pitch), glm::vec3(1, 0, 0)); // Pitch (burun yukarı/aşağı)
+    glm::quat rollQuat = glm::angleAxis(glm::radians(s.roll), glm::vec3(0, 0, 1));   // Roll (yan yatma)
+    return glm::normalize(yawQuat * pitchQuat * rollQuat);
+}
+
+// gravity, forward motion and ground contact for one tick. groundHeight is the surface under the
+// airplane (the sea, the terrain or the carrier's deck); the caller queries it, so the model itself stays
+// free of geometry.
+inline void integrateMotion(FlightState &s, float movementSpeed, float dt, float groundHeight = 0.0f)
+{
+    // Pozisyon güncelle
+    glm::mat4 rotationMatrix = glm::rotate(glm::mat4(1.0f), glm::radians(s.yaw), glm::vec3(0.0f, 1.0f, 0.0f));
+    rotationMatrix = glm::rotate(rotationMatrix, glm::radians(s.pitch), glm::vec3(1.0f, 0.0f, 0.0f));
+    rotationMatrix = glm::rotate(rotationMatrix, glm::radians(s.roll), glm::vec3(0.0f, 0.0f, 1.0f));
+    if (s.speed > 0.0f)
+        s.position.y -= (9.8f * dt * 0.5f); // Yerçekimi etkisi
+    glm::vec3 forward = glm::vec3(rotationMatrix * glm::vec4(0.0f, 0.0f, -1.0f, 0.0f));
+    s.position += forward * movementSpeed;
+
+    float contactHeight = groundHeight + FLIGHT_GROUND_CLEARANCE;
+    if (s.position.y <= contactHeight) {
+        s.position.y = contactHeight;
+        s.touchingGround = true;
+    } else {
+        s.touchingGround = false;
+    }
+
+    if ((s.position.y < contactHeight + FLIGHT_LEVEL_OFF_MARGIN && s.position.y > contactHeight) && s.pressingS == false) {
+        s.roll = 0.0f;
+        s.pitch = 0.0f;
+    }
+
+    // saniyelik pitch değişimi, sabit adım süresine göre
+    s.pitchRate = (s.pitch - s.lastPitch) / dt;
+    s.lastPitch = s.pitch;
+
+    glm::quat finalRotation = flightRotation(s);
+    if (s.cobra)
+    {
+        // Cobra manevrası: burun sabit 10 derecede tutulur
+        glm::quat yawQuat = glm::angleAxis(glm::radians(s.yaw), glm::vec3(0, 1, 0));
+        glm::quat cobraPitchQuat = glm::angleAxis(glm::radians(10.0f), glm::vec3(1, 0, 0));
+        glm::quat rollQuat = glm::angleAxis(glm::radians(s.roll), glm::vec3(0, 0, 1));
+        finalRotation = glm::normalize(yawQuat * cobraPitchQuat * rollQuat);
+    }
+    glm::vec3 forward2 = finalRotation * glm::vec3(0.0f, 0.0f, -1.0f);
+    s.position += forward2 * (s.speed * dt);
+
+    s.time += dt;
+}
+
+// one complete fixed tick of the flight model
+inline void stepFlight(FlightState &s, const FlightInput &in, float dt, float groundHeight = 0.0f)
+{
+    float movementSpeed = applyControls(s, in, dt);
+    integrateMotion(s, movementSpeed, dt, groundHeight);
+}
+
+// mouse look: vertical motion steers like W/S, horizontal motion rolls the airplane
+inline void applyMouseInput(FlightState &s, float xoffset, float yoffset)
+{
+    float zroll = std::fmod(s.roll, 360.0f);
+    float zpitch = std::fmod(s.pitch + 180.0f, 360.0f) - 180.0f;
+    float zyaw = std::fmod(s.yaw, 360.0f);
+
+    int direction = (yoffset > 0.0f) ? 1 : (yoffset < 0.0f) ? -1 : 0;
+    steerPitch(zpitch, zyaw, zroll, direction, std::fabs(yoffset));
+
+    s.pitch = zpitch;
+    s.yaw = zyaw;
+
+    // Mouse ile uçağın yönünü değiştir
+    s.roll += xoffset;
+}
+
+// FNV-1a over the bit patterns of the state, used to compare runs for determinism
+inline uint64_t flightChecksum(const FlightState &s)
+{
+    uint64_t hash = 1469598103934665603ull;
+    auto mix = [&hash](const void *data, size_t size) {
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    };
+    float values[] = { s.position.x, s.position.y, s.position.z, s.cameraOffset.x, s.cameraOffset.y, s.cameraOffset.z,
+                       s.pitch, s.yaw, s.roll, s.speed, s.lastPitch, s.pitchRate, s.cobraStartTime };
+    unsigned char flags[] = { s.cobra, s.touchingGround, s.pressingS };
+    mix(values, sizeof(values));
+    mix(flags, sizeof(flags));
+    mix(&s.time, sizeof(s.time));
+    return hash;
+}
+
+#endif
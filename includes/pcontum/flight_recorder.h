@@ -0,0 +1,434 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <pcontum/flight_model.h>
+#include <pcontum/mapped_file.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Every simulation tick's input and resulting state, for replaying a flight exactly.
+// The flight model is deterministic (see flightChecksum), so the inputs alone reproduce a run; the
+// recorded state and checksum are there to show where a replay diverges.
+//
+// The file is append-only and written in chunks. Each chunk starts with a keyframe (the full state before
+// its first tick), so a seek replays at most one chunk of ticks. Closing the recorder appends an index of
+// the chunks and a footer; a file cut short by a crash has neither and is read by walking the chunks.
+//
+//   FlightRecordingHeader
+//   chunk: FlightChunkHeader (with the keyframe), FlightTickRecord[tickCount]
+//   ...
+//   FlightChunkIndex[chunkCount]
+//   FlightRecordingFooter
+
+const uint32_t FLIGHT_RECORDING_VERSION = 2;
+
+struct FlightRecordingHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t tickRecordSize;
+    uint32_t chunkTicks; // ticks per chunk (and so between keyframes); the last chunk may be shorter
+    double tickSeconds;
+};
+
+// every field of FlightState, so a replay can restart from it bit for bit
+struct FlightKeyframe
+{
+    float position[3];
+    float cameraOffset[3];
+    float pitch, yaw, roll, speed;
+    float lastPitch, pitchRate, cobraStartTime;
+    uint8_t cobra, touchingGround, pressingS, padding;
+    double time;
+};
+
+struct FlightChunkHeader
+{
+    char magic[4];
+    uint32_t tickCount;
+    uint64_t firstTick;
+    FlightKeyframe keyframe;
+};
+
+enum FlightTickFlags
+{
+    FLIGHT_TICK_COBRA = 1,
+    FLIGHT_TICK_TOUCHING_GROUND = 2,
+    FLIGHT_TICK_PRESSING_S = 4,
+};
+
+struct FlightTickRecord
+{
+    uint32_t buttons;  // packFlightInput()
+    float mouse[2];    // mouse offsets applied before the step
+    uint32_t flags;    // FlightTickFlags, after the step
+    float position[3]; // state after the step
+    float pitch, yaw, roll, speed;
+    float cameraOffset[3];
+    float groundHeight; // surface under the airplane the step was given, so a replay needs no geometry
+    uint32_t padding;
+    uint64_t checksum;  // flightChecksum() after the step
+};
+
+struct FlightChunkIndex
+{
+    uint64_t firstTick;
+    uint64_t offset;
+};
+
+struct FlightRecordingFooter
+{
+    uint64_t indexOffset;
+    uint32_t chunkCount;
+    char magic[4];
+};
+
+static_assert(sizeof(FlightKeyframe) == 64, "FlightKeyframe is written as is");
+static_assert(sizeof(FlightTickRecord) == 72, "FlightTickRecord is written as is");
+
+// the controls and mouse motion of one tick, and the ground height queried for it
+struct FlightTickInput
+{
+    FlightInput controls;
+    float mouseX = 0.0f;
+    float mouseY = 0.0f;
+    float groundHeight = 0.0f;
+};
+
+// one tick as the game, the recorder and the replay all run it: mouse first (only if it moved, since
+// applyMouseInput also wraps the angles), then the fixed step
+inline void stepFlightTick(FlightState &s, const FlightTickInput &input, float dt)
+{
+    if (input.mouseX != 0.0f || input.mouseY != 0.0f)
+        applyMouseInput(s, input.mouseX, input.mouseY);
+    stepFlight(s, input.controls, dt, input.groundHeight);
+}
+
+// one bit per button, in FlightInput's order
+inline uint32_t packFlightInput(const FlightInput &in)
+{
+    const bool buttons[] = { in.pitchDown, in.pitchUp, in.rollLeft, in.rollRight, in.throttleUp, in.throttleDown,
+                             in.stop, in.cobra, in.cameraUp, in.cameraDown, in.cameraLeft, in.cameraRight };
+    uint32_t packed = 0;
+    for (uint32_t i = 0; i < sizeof(buttons) / sizeof(buttons[0]); ++i)
+        if (buttons[i])
+            packed |= 1u << i;
+    return packed;
+}
+
+inline FlightInput unpackFlightInput(uint32_t packed)
+{
+    FlightInput in;
+    bool *fields[] = { &in.pitchDown, &in.pitchUp, &in.rollLeft, &in.rollRight, &in.throttleUp, &in.throttleDown,
+                       &in.stop, &in.cobra, &in.cameraUp, &in.cameraDown, &in.cameraLeft, &in.cameraRight };
+    for (uint32_t i = 0; i < sizeof(fields) / sizeof(fields[0]); ++i)
+        *fields[i] = (packed >> i) & 1u;
+    return in;
+}
+
+inline FlightKeyframe flightKeyframe(const FlightState &s)
+{
+    FlightKeyframe key = {};
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        key.position[axis] = s.position[axis];
+        key.cameraOffset[axis] = s.cameraOffset[axis];
+    }
+    key.pitch = s.pitch;
+    key.yaw = s.yaw;
+    key.roll = s.roll;
+    key.speed = s.speed;
+    key.lastPitch = s.lastPitch;
+    key.pitchRate = s.pitchRate;
+    key.cobraStartTime = s.cobraStartTime;
+    key.cobra = s.cobra;
+    key.touchingGround = s.touchingGround;
+    key.pressingS = s.pressingS;
+    key.time = s.time;
+    return key;
+}
+
+inline FlightState flightStateFromKeyframe(const FlightKeyframe &key)
+{
+    FlightState s;
+    s.position = glm::vec3(key.position[0], key.position[1], key.position[2]);
+    s.cameraOffset = glm::vec3(key.cameraOffset[0], key.cameraOffset[1], key.cameraOffset[2]);
+    s.pitch = key.pitch;
+    s.yaw = key.yaw;
+    s.roll = key.roll;
+    s.speed = key.speed;
+    s.lastPitch = key.lastPitch;
+    s.pitchRate = key.pitchRate;
+    s.cobraStartTime = key.cobraStartTime;
+    s.cobra = key.cobra != 0;
+    s.touchingGround = key.touchingGround != 0;
+    s.pressingS = key.pressingS != 0;
+    s.time = key.time;
+    return s;
+}
+
+inline FlightTickRecord flightTickRecord(const FlightTickInput &input, const FlightState &after)
+{
+    FlightTickRecord record = {};
+    record.buttons = packFlightInput(input.controls);
+    record.mouse[0] = input.mouseX;
+    record.mouse[1] = input.mouseY;
+    record.groundHeight = input.groundHeight;
+    if (after.cobra)
+        record.flags |= FLIGHT_TICK_COBRA;
+    if (after.touchingGround)
+        record.flags |= FLIGHT_TICK_TOUCHING_GROUND;
+    if (after.pressingS)
+        record.flags |= FLIGHT_TICK_PRESSING_S;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        record.position[axis] = after.position[axis];
+        record.cameraOffset[axis] = after.cameraOffset[axis];
+    }
+    record.pitch = after.pitch;
+    record.yaw = after.yaw;
+    record.roll = after.roll;
+    record.speed = after.speed;
+    record.checksum = flightChecksum(after);
+    return record;
+}
+
+// writer side; ticks are buffered and go out one whole chunk at a time
+class FlightRecorder
+{
+public:
+    FlightRecorder() {}
+    ~FlightRecorder() { close(); }
+
+    FlightRecorder(const FlightRecorder &) = delete;
+    FlightRecorder &operator=(const FlightRecorder &) = delete;
+
+    // chunkTicks: ticks between keyframes, 240 is one second of the game's fixed step
+    bool open(const std::string &path, double tickSeconds, uint32_t chunkTicks = 240)
+    {
+        close();
+        file.open(path, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+        FlightRecordingHeader header = {};
+        std::memcpy(header.magic, "PFLR", 4);
+        header.version = FLIGHT_RECORDING_VERSION;
+        header.tickRecordSize = sizeof(FlightTickRecord);
+        header.chunkTicks = std::max<uint32_t>(chunkTicks, 1);
+        header.tickSeconds = tickSeconds;
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        chunkSize = header.chunkTicks;
+        offset = sizeof(header);
+        ticks = 0;
+        pending.clear();
+        index.clear();
+        return static_cast<bool>(file);
+    }
+
+    bool isOpen() const { return file.is_open(); }
+
+    // one tick: the state before it (kept as the keyframe when a chunk starts), its input and the result
+    void record(const FlightState &before, const FlightTickInput &input, const FlightState &after)
+    {
+        if (!file.is_open())
+            return;
+        if (pending.empty())
+            keyframe = flightKeyframe(before);
+        pending.push_back(flightTickRecord(input, after));
+        ticks++;
+        if (pending.size() == chunkSize)
+            writeChunk();
+    }
+
+    uint64_t recordedTicks() const { return ticks; }
+
+    // writes the partial chunk, the index and the footer
+    void close()
+    {
+        if (!file.is_open())
+            return;
+        writeChunk();
+        FlightRecordingFooter footer = {};
+        footer.indexOffset = offset;
+        footer.chunkCount = static_cast<uint32_t>(index.size());
+        std::memcpy(footer.magic, "PFIX", 4);
+        if (!index.empty())
+            file.write(reinterpret_cast<const char *>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(FlightChunkIndex)));
+        file.write(reinterpret_cast<const char *>(&footer), sizeof(footer));
+        file.close();
+    }
+
+private:
+    std::ofstream file;
+    uint32_t chunkSize = 240;
+    uint64_t offset = 0;
+    uint64_t ticks = 0;
+    FlightKeyframe keyframe = {};
+    std::vector<FlightTickRecord> pending;
+    std::vector<FlightChunkIndex> index;
+
+    void writeChunk()
+    {
+        if (pending.empty())
+            return;
+        FlightChunkHeader chunk = {};
+        std::memcpy(chunk.magic, "PCHK", 4);
+        chunk.tickCount = static_cast<uint32_t>(pending.size());
+        chunk.firstTick = ticks - pending.size();
+        chunk.keyframe = keyframe;
+        file.write(reinterpret_cast<const char *>(&chunk), sizeof(chunk));
+        file.write(reinterpret_cast<const char *>(pending.data()), static_cast<std::streamsize>(pending.size() * sizeof(FlightTickRecord)));
+        index.push_back(FlightChunkIndex{ chunk.firstTick, offset });
+        offset += sizeof(chunk) + pending.size() * sizeof(FlightTickRecord);
+        pending.clear();
+        // a crash loses at most the chunk being filled
+        file.flush();
+    }
+};
+
+// reader side: the recording mapped read-only, ticks read in place
+class FlightRecording
+{
+public:
+    // false if the file is missing, of another version or has no whole chunk
+    bool open(const std::string &path)
+    {
+        chunks.clear();
+        tickTotal = 0;
+        if (!mapping.open(path) || mapping.size() < sizeof(FlightRecordingHeader))
+            return false;
+        std::memcpy(&header, mapping.data(), sizeof(header));
+        if (std::memcmp(header.magic, "PFLR", 4) != 0 || header.version != FLIGHT_RECORDING_VERSION ||
+            header.tickRecordSize != sizeof(FlightTickRecord))
+            return false;
+        if (!readIndex())
+            scanChunks();
+        for (const FlightChunkIndex &chunk : chunks)
+            tickTotal = chunk.firstTick + chunkHeader(chunk).tickCount;
+        return !chunks.empty();
+    }
+
+    uint64_t tickCount() const { return tickTotal; }
+    double tickSeconds() const { return header.tickSeconds; }
+    uint32_t chunkTicks() const { return header.chunkTicks; }
+    size_t chunkCount() const { return chunks.size(); }
+    // false if the index was missing (the recorder didn't close) and the chunks were walked instead
+    bool indexed() const { return hasIndex; }
+
+    const FlightTickRecord &tick(uint64_t tick) const
+    {
+        const FlightChunkIndex &chunk = chunkFor(tick);
+        return ticksOf(chunk)[tick - chunk.firstTick];
+    }
+
+    FlightTickInput input(uint64_t tick) const
+    {
+        const FlightTickRecord &record = this->tick(tick);
+        FlightTickInput in;
+        in.controls = unpackFlightInput(record.buttons);
+        in.mouseX = record.mouse[0];
+        in.mouseY = record.mouse[1];
+        in.groundHeight = record.groundHeight;
+        return in;
+    }
+
+    // the state before tick: the nearest keyframe at or before it, then the recorded inputs up to it.
+    // tick == tickCount() gives the final state.
+    FlightState seek(uint64_t tick) const
+    {
+        tick = std::min(tick, tickTotal);
+        const FlightChunkIndex &chunk = chunkFor(tick == tickTotal && tick > 0 ? tick - 1 : tick);
+        FlightState state = flightStateFromKeyframe(chunkHeader(chunk).keyframe);
+        float dt = static_cast<float>(header.tickSeconds);
+        for (uint64_t t = chunk.firstTick; t < tick; ++t)
+            stepFlightTick(state, input(t), dt);
+        return state;
+    }
+
+private:
+    MappedFile mapping;
+    FlightRecordingHeader header = {};
+    std::vector<FlightChunkIndex> chunks;
+    uint64_t tickTotal = 0;
+    bool hasIndex = false;
+
+    const FlightChunkHeader &chunkHeader(const FlightChunkIndex &chunk) const
+    {
+        return *reinterpret_cast<const FlightChunkHeader *>(mapping.data() + chunk.offset);
+    }
+
+    const FlightTickRecord *ticksOf(const FlightChunkIndex &chunk) const
+    {
+        return reinterpret_cast<const FlightTickRecord *>(mapping.data() + chunk.offset + sizeof(FlightChunkHeader));
+    }
+
+    // the last chunk starting at or before tick
+    const FlightChunkIndex &chunkFor(uint64_t tick) const
+    {
+        auto after = std::upper_bound(chunks.begin(), chunks.end(), tick,
+                                      [](uint64_t t, const FlightChunkIndex &chunk) { return t < chunk.firstTick; });
+        return after == chunks.begin() ? chunks.front() : *(after - 1);
+    }
+
+    // a whole, well-formed chunk at offset
+    bool validChunk(uint64_t offset, uint64_t expectedTick) const
+    {
+        uint64_t size = mapping.size();
+        if (offset > size || size - offset < sizeof(FlightChunkHeader))
+            return false;
+        const FlightChunkHeader &chunk = *reinterpret_cast<const FlightChunkHeader *>(mapping.data() + offset);
+        return std::memcmp(chunk.magic, "PCHK", 4) == 0 && chunk.tickCount > 0 && chunk.firstTick == expectedTick &&
+               chunk.tickCount <= (size - offset - sizeof(FlightChunkHeader)) / sizeof(FlightTickRecord);
+    }
+
+    bool readIndex()
+    {
+        hasIndex = false;
+        uint64_t size = mapping.size();
+        if (size < sizeof(FlightRecordingHeader) + sizeof(FlightRecordingFooter))
+            return false;
+        FlightRecordingFooter footer;
+        std::memcpy(&footer, mapping.data() + size - sizeof(footer), sizeof(footer));
+        if (std::memcmp(footer.magic, "PFIX", 4) != 0 || footer.indexOffset > size - sizeof(footer) ||
+            footer.chunkCount > (size - sizeof(footer) - footer.indexOffset) / sizeof(FlightChunkIndex))
+            return false;
+        chunks.resize(footer.chunkCount);
+        if (footer.chunkCount > 0)
+            std::memcpy(chunks.data(), mapping.data() + footer.indexOffset, footer.chunkCount * sizeof(FlightChunkIndex));
+        uint64_t expectedTick = 0;
+        for (const FlightChunkIndex &chunk : chunks)
+        {
+            if (chunk.firstTick != expectedTick || !validChunk(chunk.offset, expectedTick))
+            {
+                chunks.clear();
+                return false;
+            }
+            expectedTick += chunkHeader(chunk).tickCount;
+        }
+        hasIndex = true;
+        return true;
+    }
+
+    // recovery path: chunks follow each other from the header until one is torn or missing
+    void scanChunks()
+    {
+        chunks.clear();
+        uint64_t offset = sizeof(FlightRecordingHeader);
+        uint64_t tick = 0;
+        while (validChunk(offset, tick))
+        {
+            FlightChunkIndex chunk{ tick, offset };
+            chunks.push_back(chunk);
+            uint32_t count = chunkHeader(chunk).tickCount;
+            tick += count;
+            offset += sizeof(FlightChunkHeader) + static_cast<uint64_t>(count) * sizeof(FlightTickRecord);
+        }
+    }
+};
+
+#endif
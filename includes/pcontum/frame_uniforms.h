@@ -0,0 +1,85 @@
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <pcontum/shader_program.h>
+
+// The camera values all of a frame's programs share, in one std140 uniform
+// block that is written once per frame and bound to a fixed binding point. Every shader that needs them
+// declares the same block:
+//
+//   layout (std140) uniform FrameUniforms
+//   {
+//       mat4 view;
+//       mat4 projection;      // airplanes and sky
+//       mat4 worldProjection; // carrier and terrain (farther far plane)
+//       vec4 camPos;          // xyz
+//   };
+//
+// GLSL 3.30 has no layout(binding = N), so attach() points each program's block at the binding point.
+// Point lights are not in here; they are assigned to view clusters every frame (light_clusters.h).
+
+const GLuint FRAME_UNIFORMS_BINDING = 0;
+
+// std140 gives mat4 and vec4 their natural size and 16-byte alignment, so this is the layout as is
+struct FrameUniforms
+{
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    glm::mat4 worldProjection = glm::mat4(1.0f);
+    glm::vec4 camPos = glm::vec4(0.0f);
+};
+
+static_assert(sizeof(FrameUniforms) == 3 * 64 + 16, "FrameUniforms must match the std140 block");
+
+class FrameUniformBuffer
+{
+public:
+    FrameUniformBuffer()
+    {
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, buffer);
+    }
+
+    ~FrameUniformBuffer() { release(); }
+
+    // deletes the buffer; called by the owner while the GL context is still current
+    void release()
+    {
+        if (buffer)
+            glDeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+
+    FrameUniformBuffer(const FrameUniformBuffer &) = delete;
+    FrameUniformBuffer &operator=(const FrameUniformBuffer &) = delete;
+
+    // false if the program doesn't declare the block (or doesn't use any of it)
+    static bool attach(const ShaderProgram &shader)
+    {
+        GLuint index = glGetUniformBlockIndex(shader.ID, "FrameUniforms");
+        if (index == GL_INVALID_INDEX)
+            return false;
+        glUniformBlockBinding(shader.ID, index, FRAME_UNIFORMS_BINDING);
+        return true;
+    }
+
+    // once per frame, before the first draw that reads it
+    void update(const FrameUniforms &data)
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+private:
+    unsigned int buffer = 0;
+};
+
+#endif
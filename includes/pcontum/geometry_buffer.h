@@ -0,0 +1,174 @@
+#ifndef GEOMETRY_BUFFER_H
+#define GEOMETRY_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/mesh.h>
+
+#include <pcontum/scene_model.h>
+#include <pcontum/vertex_format.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// Static meshes are suballocated into one vertex buffer, one layer
+// buffer and one index buffer behind a single VAO. Indices stay mesh-local; a range is drawn with its
+// baseVertex, so meshes can be copied in as they are. Storage grows by doubling and the old contents are
+// copied over on the GPU. Vertices stay in the compact format, each range with its own quantization.
+
+struct GeometryRange
+{
+    unsigned int firstIndex = 0;
+    unsigned int indexCount = 0;
+    int baseVertex = 0;
+    VertexQuantization quantization; // of the mesh the range came from
+};
+
+class GeometryBuffer
+{
+public:
+    // same slot PackedModel uses for the texture array layer
+    static const unsigned int LAYER_LOCATION = 14;
+
+    explicit GeometryBuffer(size_t vertexCapacity = 1 << 16, size_t indexCapacity = 1 << 18)
+    {
+        glGenVertexArrays(1, &vertexArray);
+        allocate(vertexCapacity, indexCapacity);
+    }
+
+    GeometryBuffer(const GeometryBuffer &) = delete;
+    GeometryBuffer &operator=(const GeometryBuffer &) = delete;
+
+    ~GeometryBuffer() { release(); }
+
+    // deletes the VAO and buffers; called by the owner while the GL context is still current
+    void release()
+    {
+        if (!vertexArray)
+            return;
+        glDeleteVertexArrays(1, &vertexArray);
+        unsigned int buffers[] = { vertexBuffer, layerBuffer, indexBuffer };
+        glDeleteBuffers(3, buffers);
+        vertexArray = vertexBuffer = layerBuffer = indexBuffer = 0;
+    }
+
+    // copies an already uploaded mesh buffer to buffer, without a round trip through client memory.
+    // layers is an optional per-vertex int buffer such as PackedModel's. The simplified levels come along;
+    // the returned range is the full mesh, lodRange() gives the others.
+    GeometryRange add(const SceneMesh &mesh, unsigned int layers = 0)
+    {
+        GeometryRange range = reserve(mesh.vertexCount, mesh.bufferIndexCount);
+        range.indexCount = mesh.indexCount;
+        range.quantization = mesh.quantization;
+        copy(mesh.VBO, vertexBuffer, range.baseVertex * sizeof(PackedVertex), mesh.vertexCount * sizeof(PackedVertex));
+        copy(mesh.EBO, indexBuffer, range.firstIndex * sizeof(unsigned int), mesh.bufferIndexCount * sizeof(unsigned int));
+        if (layers)
+        {
+            copy(layers, layerBuffer, range.baseVertex * sizeof(int), mesh.vertexCount * sizeof(int));
+        }
+        else
+        {
+            std::vector<int> noLayers(mesh.vertexCount, -1);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, layerBuffer);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, range.baseVertex * sizeof(int), noLayers.size() * sizeof(int), noLayers.data());
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+        return range;
+    }
+
+    // range of a simplified level of a mesh added with add(const SceneMesh &); level 0 is the full mesh
+    static GeometryRange lodRange(const GeometryRange &mesh, const SceneMesh &source, int level)
+    {
+        if (level <= 0 || source.lods.empty())
+            return mesh;
+        const MeshLod &lod = source.lods[std::min<size_t>(level, source.lods.size()) - 1];
+        GeometryRange range = mesh;
+        range.firstIndex += lod.firstIndex;
+        range.indexCount = lod.indexCount;
+        return range;
+    }
+
+    unsigned int VAO() const { return vertexArray; }
+    size_t vertexCount() const { return usedVertices; }
+    size_t indexCount() const { return usedIndices; }
+
+private:
+    unsigned int vertexArray = 0;
+    unsigned int vertexBuffer = 0;
+    unsigned int layerBuffer = 0;
+    unsigned int indexBuffer = 0;
+    size_t vertexCapacity = 0;
+    size_t indexCapacity = 0;
+    size_t usedVertices = 0;
+    size_t usedIndices = 0;
+
+    static void copy(unsigned int source, unsigned int target, size_t targetOffset, size_t size)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, source);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, target);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, targetOffset, size);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    GeometryRange reserve(size_t numVertices, size_t numIndices)
+    {
+        if (usedVertices + numVertices > vertexCapacity || usedIndices + numIndices > indexCapacity)
+        {
+            size_t vertices = vertexCapacity, indices = indexCapacity;
+            while (usedVertices + numVertices > vertices)
+                vertices *= 2;
+            while (usedIndices + numIndices > indices)
+                indices *= 2;
+            allocate(vertices, indices);
+        }
+        GeometryRange range;
+        range.baseVertex = static_cast<int>(usedVertices);
+        range.firstIndex = static_cast<unsigned int>(usedIndices);
+        range.indexCount = static_cast<unsigned int>(numIndices);
+        usedVertices += numVertices;
+        usedIndices += numIndices;
+        return range;
+    }
+
+    // (re)creates the buffers at the given capacity, keeps what was already added and rebuilds the VAO
+    void allocate(size_t vertices, size_t indices)
+    {
+        unsigned int oldVertices = vertexBuffer, oldLayers = layerBuffer, oldIndices = indexBuffer;
+        glGenBuffers(1, &vertexBuffer);
+        glGenBuffers(1, &layerBuffer);
+        glGenBuffers(1, &indexBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, vertexBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, vertices * sizeof(PackedVertex), nullptr, GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, layerBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, vertices * sizeof(int), nullptr, GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, indexBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, indices * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        if (oldVertices)
+        {
+            copy(oldVertices, vertexBuffer, 0, usedVertices * sizeof(PackedVertex));
+            copy(oldLayers, layerBuffer, 0, usedVertices * sizeof(int));
+            copy(oldIndices, indexBuffer, 0, usedIndices * sizeof(unsigned int));
+            unsigned int buffers[] = { oldVertices, oldLayers, oldIndices };
+            glDeleteBuffers(3, buffers);
+        }
+        vertexCapacity = vertices;
+        indexCapacity = indices;
+
+        // same attribute layout as SceneMesh::upload(), plus the layer stream
+        glBindVertexArray(vertexArray);
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        setupPackedVertexAttributes();
+        glBindBuffer(GL_ARRAY_BUFFER, layerBuffer);
+        glEnableVertexAttribArray(LAYER_LOCATION);
+        glVertexAttribIPointer(LAYER_LOCATION, 1, GL_INT, sizeof(int), (void*)0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+};
+
+#endif
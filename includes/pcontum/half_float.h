@@ -0,0 +1,85 @@
+#ifndef HALF_FLOAT_H
+#define HALF_FLOAT_H
+
+#include <cstdint>
+#include <cstring>
+
+// IEEE 754 binary16 (half float) conversions, shared by the IBL cache (RGB16F texels) and
+// the compact vertex format (texture coordinates).
+
+inline uint16_t floatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    uint32_t exponent = (bits >> 23) & 0xffu;
+    uint32_t mantissa = bits & 0x7fffffu;
+
+    if (exponent == 0xffu) // inf / nan
+        return static_cast<uint16_t>(sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+
+    int e = static_cast<int>(exponent) - 127 + 15;
+    if (e >= 31)
+        return static_cast<uint16_t>(sign | 0x7c00u);
+    if (e <= 0)
+    {
+        // subnormal half, or zero
+        if (e < -10)
+            return static_cast<uint16_t>(sign);
+        mantissa |= 0x800000u;
+        uint32_t shift = static_cast<uint32_t>(14 - e);
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1u);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1u)))
+            half++;
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    // round to nearest even; a carry out of the mantissa correctly bumps the exponent
+    uint32_t half = (static_cast<uint32_t>(e) << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1fffu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u)))
+        half++;
+    return static_cast<uint16_t>(sign | half);
+}
+
+inline float halfToFloat(uint16_t value)
+{
+    uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+    uint32_t exponent = (value >> 10) & 0x1fu;
+    uint32_t mantissa = value & 0x3ffu;
+    uint32_t bits;
+
+    if (exponent == 0)
+    {
+        if (mantissa == 0)
+        {
+            bits = sign;
+        }
+        else
+        {
+            exponent = 127 - 15 + 1;
+            while (!(mantissa & 0x400u))
+            {
+                mantissa <<= 1;
+                exponent--;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3ffu) << 13);
+        }
+    }
+    else if (exponent == 31)
+    {
+        bits = sign | 0x7f800000u | (mantissa << 13);
+    }
+    else
+    {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+#endif
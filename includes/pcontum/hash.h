@@ -0,0 +1,38 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// FNV-1a, 64 bit: cheap content hashing for cache keys
+const uint64_t FNV_OFFSET_BASIS = 1469598103934665603ull;
+
+inline void fnv1a(uint64_t &hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+}
+
+// mixes the whole file into hash; false if it can't be read
+inline bool fnv1aFile(uint64_t &hash, const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    std::vector<char> chunk(1 << 16);
+    while (file)
+    {
+        file.read(chunk.data(), chunk.size());
+        fnv1a(hash, chunk.data(), static_cast<size_t>(file.gcount()));
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,558 @@
+#ifndef IBL_BAKE_CPU_H
+#define IBL_BAKE_CPU_H
+
+#include <pcontum/ibl_cache.h>
+#include <pcontum/thread_pool.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PCONTUM_IBL_SSE2
+#include <emmintrin.h>
+#endif
+
+// The bake passes of 2.2.2.equirectangular_to_cubemap.fs, 2.2.2.irradiance_convolution.fs,
+// 2.2.2.prefilter.fs and 2.2.2.brdf.fs on the CPU, spread over a ThreadPool.
+// Cubemaps follow the GL layout the capture FBO produces (faces +X,-X,+Y,-Y,+Z,-Z, rows bottom-up), so the
+// results drop straight into an IblCache and can be compared texel by texel with a GPU bake.
+// Sampling emulates GL_LINEAR_MIPMAP_LINEAR with GL_TEXTURE_CUBE_MAP_SEAMLESS; where the shaders rely on
+// implicit derivatives (irradiance) the CPU picks the equivalent fixed lod.
+
+const float IBL_PI = 3.14159265359f;
+const uint32_t IBL_SAMPLE_COUNT = 1024; // SAMPLE_COUNT of prefilter.fs and brdf.fs
+
+// float RGB cubemap with its mip chain
+struct CpuCubemap
+{
+    uint32_t size = 0;
+    std::vector<std::vector<float>> levels; // levels[mip]: 6 faces of s x s RGB texels
+
+    void allocate(uint32_t faceSize, uint32_t levelCount)
+    {
+        size = faceSize;
+        levels.resize(levelCount);
+        for (uint32_t mip = 0; mip < levelCount; ++mip)
+            levels[mip].assign(size_t(6) * levelSize(mip) * levelSize(mip) * 3, 0.0f);
+    }
+
+    uint32_t levelSize(uint32_t mip) const { return std::max(size >> mip, 1u); }
+    uint32_t levelCount() const { return static_cast<uint32_t>(levels.size()); }
+
+    float *texel(uint32_t mip, uint32_t face, uint32_t x, uint32_t y)
+    {
+        uint32_t s = levelSize(mip);
+        return levels[mip].data() + ((size_t(face) * s + y) * s + x) * 3;
+    }
+    const float *texel(uint32_t mip, uint32_t face, uint32_t x, uint32_t y) const
+    {
+        uint32_t s = levelSize(mip);
+        return levels[mip].data() + ((size_t(face) * s + y) * s + x) * 3;
+    }
+};
+
+// number of mips in a full chain down to 1x1
+inline uint32_t fullMipCount(uint32_t size)
+{
+    uint32_t count = 1;
+    while (size > 1)
+    {
+        size >>= 1;
+        count++;
+    }
+    return count;
+}
+
+// direction through face coordinates (a, b) in [-1, 1]; matches captureViews[] and the GL face selection rules
+inline glm::vec3 cubeFaceDirection(uint32_t face, float a, float b)
+{
+    switch (face)
+    {
+    case 0: return glm::vec3(1.0f, -b, -a);
+    case 1: return glm::vec3(-1.0f, -b, a);
+    case 2: return glm::vec3(a, 1.0f, b);
+    case 3: return glm::vec3(a, -1.0f, -b);
+    case 4: return glm::vec3(a, -b, 1.0f);
+    default: return glm::vec3(-a, -b, -1.0f);
+    }
+}
+
+// direction of the centre of texel (x, y); x or y may lie one texel off the face
+inline glm::vec3 cubeTexelDirection(uint32_t face, int x, int y, uint32_t size)
+{
+    float a = (x + 0.5f) / size * 2.0f - 1.0f;
+    float b = (y + 0.5f) / size * 2.0f - 1.0f;
+    return cubeFaceDirection(face, a, b);
+}
+
+// GL cube map face selection: major axis picks the face, (a, b) are sc/|ma| and tc/|ma|
+inline uint32_t cubeFaceCoords(const glm::vec3 &d, float &a, float &b)
+{
+    float ax = std::fabs(d.x), ay = std::fabs(d.y), az = std::fabs(d.z);
+    if (ax >= ay && ax >= az)
+    {
+        a = (d.x > 0.0f ? -d.z : d.z) / ax;
+        b = -d.y / ax;
+        return d.x > 0.0f ? 0 : 1;
+    }
+    if (ay >= az)
+    {
+        a = d.x / ay;
+        b = (d.y > 0.0f ? d.z : -d.z) / ay;
+        return d.y > 0.0f ? 2 : 3;
+    }
+    a = (d.z > 0.0f ? d.x : -d.x) / az;
+    b = -d.y / az;
+    return d.z > 0.0f ? 4 : 5;
+}
+
+// texel fetch that follows the edge onto the neighbouring face, like GL_TEXTURE_CUBE_MAP_SEAMLESS
+inline const float *fetchCubeTexel(const CpuCubemap &cube, uint32_t mip, uint32_t face, int x, int y)
+{
+    int s = static_cast<int>(cube.levelSize(mip));
+    if (x >= 0 && y >= 0 && x < s && y < s)
+        return cube.texel(mip, face, x, y);
+
+    float a, b;
+    uint32_t neighbour = cubeFaceCoords(cubeTexelDirection(face, x, y, s), a, b);
+    int nx = std::clamp(static_cast<int>((a * 0.5f + 0.5f) * s), 0, s - 1);
+    int ny = std::clamp(static_cast<int>((b * 0.5f + 0.5f) * s), 0, s - 1);
+    return cube.texel(mip, neighbour, nx, ny);
+}
+
+inline glm::vec3 sampleCubeBilinear(const CpuCubemap &cube, uint32_t mip, const glm::vec3 &dir)
+{
+    float a, b;
+    uint32_t face = cubeFaceCoords(dir, a, b);
+    float s = static_cast<float>(cube.levelSize(mip));
+    float x = (a * 0.5f + 0.5f) * s - 0.5f;
+    float y = (b * 0.5f + 0.5f) * s - 0.5f;
+    int x0 = static_cast<int>(std::floor(x));
+    int y0 = static_cast<int>(std::floor(y));
+    float fx = x - x0;
+    float fy = y - y0;
+
+    const float *t00 = fetchCubeTexel(cube, mip, face, x0, y0);
+    const float *t10 = fetchCubeTexel(cube, mip, face, x0 + 1, y0);
+    const float *t01 = fetchCubeTexel(cube, mip, face, x0, y0 + 1);
+    const float *t11 = fetchCubeTexel(cube, mip, face, x0 + 1, y0 + 1);
+    glm::vec3 result;
+    for (int c = 0; c < 3; ++c)
+    {
+        float bottom = t00[c] + (t10[c] - t00[c]) * fx;
+        float top = t01[c] + (t11[c] - t01[c]) * fx;
+        result[c] = bottom + (top - bottom) * fy;
+    }
+    return result;
+}
+
+// textureLod() with GL_LINEAR_MIPMAP_LINEAR
+inline glm::vec3 sampleCube(const CpuCubemap &cube, const glm::vec3 &dir, float lod)
+{
+    float maxLod = static_cast<float>(cube.levelCount() - 1);
+    lod = std::clamp(lod, 0.0f, maxLod);
+    uint32_t mip = static_cast<uint32_t>(lod);
+    float blend = lod - mip;
+    glm::vec3 result = sampleCubeBilinear(cube, mip, dir);
+    if (blend > 0.0f && mip + 1 < cube.levelCount())
+        result += (sampleCubeBilinear(cube, mip + 1, dir) - result) * blend;
+    return result;
+}
+
+// glGenerateMipmap: 2x2 box filter per face
+inline void generateCubeMipmaps(CpuCubemap &cube, ThreadPool &pool)
+{
+    for (uint32_t mip = 1; mip < cube.levelCount(); ++mip)
+    {
+        uint32_t s = cube.levelSize(mip);
+        uint32_t parent = cube.levelSize(mip - 1);
+        pool.parallelFor(size_t(6) * s, 8, [&](size_t begin, size_t end) {
+            for (size_t row = begin; row < end; ++row)
+            {
+                uint32_t face = static_cast<uint32_t>(row / s);
+                uint32_t y = static_cast<uint32_t>(row % s);
+                for (uint32_t x = 0; x < s; ++x)
+                {
+                    uint32_t px = std::min(x * 2, parent - 1), px1 = std::min(x * 2 + 1, parent - 1);
+                    uint32_t py = std::min(y * 2, parent - 1), py1 = std::min(y * 2 + 1, parent - 1);
+                    const float *t00 = cube.texel(mip - 1, face, px, py);
+                    const float *t10 = cube.texel(mip - 1, face, px1, py);
+                    const float *t01 = cube.texel(mip - 1, face, px, py1);
+                    const float *t11 = cube.texel(mip - 1, face, px1, py1);
+                    float *out = cube.texel(mip, face, x, y);
+                    for (int c = 0; c < 3; ++c)
+                        out[c] = 0.25f * (t00[c] + t10[c] + t01[c] + t11[c]);
+                }
+            }
+        });
+    }
+}
+
+// 2.2.2.equirectangular_to_cubemap.fs; hdr rows are bottom-up (stbi flip on load), clamp-to-edge bilinear
+inline CpuCubemap equirectangularToCubemap(const float *hdr, int width, int height, int components,
+                                           uint32_t size, ThreadPool &pool)
+{
+    CpuCubemap cube;
+    cube.allocate(size, fullMipCount(size));
+
+    auto fetch = [&](int x, int y) {
+        x = std::clamp(x, 0, width - 1);
+        y = std::clamp(y, 0, height - 1);
+        return hdr + (size_t(y) * width + x) * components;
+    };
+
+    pool.parallelFor(size_t(6) * size, 8, [&](size_t begin, size_t end) {
+        for (size_t row = begin; row < end; ++row)
+        {
+            uint32_t face = static_cast<uint32_t>(row / size);
+            uint32_t y = static_cast<uint32_t>(row % size);
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                glm::vec3 v = glm::normalize(cubeTexelDirection(face, x, y, size));
+                float u = std::atan2(v.z, v.x) * 0.1591f + 0.5f;
+                float t = std::asin(v.y) * 0.3183f + 0.5f;
+
+                float fx = u * width - 0.5f;
+                float fy = t * height - 0.5f;
+                int x0 = static_cast<int>(std::floor(fx));
+                int y0 = static_cast<int>(std::floor(fy));
+                fx -= x0;
+                fy -= y0;
+                const float *t00 = fetch(x0, y0), *t10 = fetch(x0 + 1, y0);
+                const float *t01 = fetch(x0, y0 + 1), *t11 = fetch(x0 + 1, y0 + 1);
+                float *out = cube.texel(0, face, x, y);
+                for (int c = 0; c < 3; ++c)
+                {
+                    float bottom = t00[c] + (t10[c] - t00[c]) * fx;
+                    float top = t01[c] + (t11[c] - t01[c]) * fx;
+                    out[c] = bottom + (top - bottom) * fy;
+                }
+            }
+        }
+    });
+
+    generateCubeMipmaps(cube, pool);
+    return cube;
+}
+
+// 2.2.2.irradiance_convolution.fs. The shader's hemisphere samples don't depend on the normal, so they are
+// generated once; the GPU picks the source mip from derivatives, here that is the size ratio of the two maps.
+inline CpuCubemap convolveIrradiance(const CpuCubemap &environment, uint32_t size, ThreadPool &pool)
+{
+    struct HemisphereSample
+    {
+        glm::vec3 tangent;
+        float weight;
+    };
+    std::vector<HemisphereSample> samples;
+    float sampleDelta = 0.025f;
+    for (float phi = 0.0f; phi < 2.0f * IBL_PI; phi += sampleDelta)
+    {
+        for (float theta = 0.0f; theta < 0.5f * IBL_PI; theta += sampleDelta)
+        {
+            glm::vec3 tangentSample(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta));
+            samples.push_back({ tangentSample, std::cos(theta) * std::sin(theta) });
+        }
+    }
+    float lod = std::log2(static_cast<float>(environment.size) / static_cast<float>(size));
+
+    CpuCubemap irradiance;
+    irradiance.allocate(size, 1);
+    pool.parallelFor(size_t(6) * size * size, 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            uint32_t face = static_cast<uint32_t>(i / (size_t(size) * size));
+            uint32_t y = static_cast<uint32_t>((i / size) % size);
+            uint32_t x = static_cast<uint32_t>(i % size);
+
+            glm::vec3 N = glm::normalize(cubeTexelDirection(face, x, y, size));
+            glm::vec3 up(0.0f, 1.0f, 0.0f);
+            glm::vec3 right = glm::normalize(glm::cross(up, N));
+            up = glm::normalize(glm::cross(N, right));
+
+            glm::vec3 sum(0.0f);
+            for (const HemisphereSample &s : samples)
+            {
+                glm::vec3 sampleVec = s.tangent.x * right + s.tangent.y * up + s.tangent.z * N;
+                sum += sampleCube(environment, sampleVec, lod) * s.weight;
+            }
+            glm::vec3 result = IBL_PI * sum * (1.0f / static_cast<float>(samples.size()));
+            float *out = irradiance.texel(0, face, x, y);
+            out[0] = result.x;
+            out[1] = result.y;
+            out[2] = result.z;
+        }
+    });
+    return irradiance;
+}
+
+inline float radicalInverseVdC(uint32_t bits)
+{
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return float(bits) * 2.3283064365386963e-10f; // / 0x100000000
+}
+
+// ImportanceSampleGGX() before the tangent frame is applied
+inline glm::vec3 ggxHalfVectorTangent(uint32_t i, float roughness)
+{
+    float a = roughness * roughness;
+    float phi = 2.0f * IBL_PI * (float(i) / float(IBL_SAMPLE_COUNT));
+    float xiY = radicalInverseVdC(i);
+    float cosTheta = std::sqrt((1.0f - xiY) / (1.0f + (a * a - 1.0f) * xiY));
+    float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+    return glm::vec3(std::cos(phi) * sinTheta, std::sin(phi) * sinTheta, cosTheta);
+}
+
+// 2.2.2.prefilter.fs for every mip. With V = R = N the reflected direction, NdotL and the source lod of each
+// sample are the same for every texel, so only the tangent frame is per texel.
+inline CpuCubemap prefilterEnvironment(const CpuCubemap &environment, uint32_t size, uint32_t levelCount, ThreadPool &pool)
+{
+    struct PrefilterSample
+    {
+        glm::vec3 L; // tangent space
+        float NdotL;
+        float lod;
+    };
+
+    CpuCubemap prefilter;
+    prefilter.allocate(size, levelCount);
+    float resolution = static_cast<float>(environment.size);
+    float saTexel = 4.0f * IBL_PI / (6.0f * resolution * resolution);
+
+    for (uint32_t mip = 0; mip < levelCount; ++mip)
+    {
+        float roughness = (levelCount > 1) ? float(mip) / float(levelCount - 1) : 0.0f;
+        std::vector<PrefilterSample> samples;
+        for (uint32_t i = 0; i < IBL_SAMPLE_COUNT; ++i)
+        {
+            glm::vec3 H = ggxHalfVectorTangent(i, roughness);
+            glm::vec3 L = glm::normalize(2.0f * H.z * H - glm::vec3(0.0f, 0.0f, 1.0f));
+            float NdotL = std::max(L.z, 0.0f);
+            if (NdotL <= 0.0f)
+                continue;
+
+            float lod = 0.0f;
+            if (roughness != 0.0f)
+            {
+                float a = roughness * roughness;
+                float a2 = a * a;
+                float NdotH = std::max(H.z, 0.0f);
+                float denom = NdotH * NdotH * (a2 - 1.0f) + 1.0f;
+                float D = a2 / (IBL_PI * denom * denom);
+                float pdf = D * NdotH / (4.0f * NdotH) + 0.0001f; // HdotV == NdotH when V == N
+                float saSample = 1.0f / (float(IBL_SAMPLE_COUNT) * pdf + 0.0001f);
+                lod = 0.5f * std::log2(saSample / saTexel);
+            }
+            samples.push_back({ L, NdotL, lod });
+        }
+
+        uint32_t s = prefilter.levelSize(mip);
+        pool.parallelFor(size_t(6) * s * s, 16, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                uint32_t face = static_cast<uint32_t>(i / (size_t(s) * s));
+                uint32_t y = static_cast<uint32_t>((i / s) % s);
+                uint32_t x = static_cast<uint32_t>(i % s);
+
+                glm::vec3 N = glm::normalize(cubeTexelDirection(face, x, y, s));
+                glm::vec3 up = std::fabs(N.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+                glm::vec3 tangent = glm::normalize(glm::cross(up, N));
+                glm::vec3 bitangent = glm::cross(N, tangent);
+
+                glm::vec3 color(0.0f);
+                float totalWeight = 0.0f;
+                for (const PrefilterSample &sample : samples)
+                {
+                    glm::vec3 L = tangent * sample.L.x + bitangent * sample.L.y + N * sample.L.z;
+                    color += sampleCube(environment, L, sample.lod) * sample.NdotL;
+                    totalWeight += sample.NdotL;
+                }
+                color = color / totalWeight;
+                float *out = prefilter.texel(mip, face, x, y);
+                out[0] = color.x;
+                out[1] = color.y;
+                out[2] = color.z;
+            }
+        });
+    }
+    return prefilter;
+}
+
+// per-sample terms of IntegrateBRDF() that don't depend on the texel
+struct BrdfSamples
+{
+    std::vector<float> xiY, cosPhi, sinPhi;
+
+    BrdfSamples()
+    {
+        for (uint32_t i = 0; i < IBL_SAMPLE_COUNT; ++i)
+        {
+            float phi = 2.0f * IBL_PI * (float(i) / float(IBL_SAMPLE_COUNT));
+            xiY.push_back(radicalInverseVdC(i));
+            cosPhi.push_back(std::cos(phi));
+            sinPhi.push_back(std::sin(phi));
+        }
+    }
+};
+
+// IntegrateBRDF() of 2.2.2.brdf.fs. With N = +Z the tangent frame is fixed: H = (sinPhi, -cosPhi, 0) sinTheta + (0, 0, cosTheta).
+inline glm::vec2 integrateBrdfScalar(float NdotV, float roughness, const BrdfSamples &samples)
+{
+    float a = roughness * roughness;
+    float k = a / 2.0f; // GeometrySchlickGGX k for IBL
+    float Vx = std::sqrt(1.0f - NdotV * NdotV);
+    float Vz = NdotV;
+    float ggxV = NdotV / (NdotV * (1.0f - k) + k);
+
+    float A = 0.0f, B = 0.0f;
+    for (uint32_t i = 0; i < IBL_SAMPLE_COUNT; ++i)
+    {
+        float y = samples.xiY[i];
+        float cosTheta = std::sqrt((1.0f - y) / (1.0f + (a * a - 1.0f) * y));
+        float sinTheta = std::sqrt(std::max(1.0f - cosTheta * cosTheta, 0.0f));
+        float Hx = samples.sinPhi[i] * sinTheta;
+        float Hy = -samples.cosPhi[i] * sinTheta;
+        float Hz = cosTheta;
+
+        float VdotHRaw = Vx * Hx + Vz * Hz;
+        float Lx = 2.0f * VdotHRaw * Hx - Vx;
+        float Ly = 2.0f * VdotHRaw * Hy;
+        float Lz = 2.0f * VdotHRaw * Hz - Vz;
+        float NdotL = std::max(Lz / std::sqrt(Lx * Lx + Ly * Ly + Lz * Lz), 0.0f);
+        float NdotH = std::max(Hz, 0.0f);
+        float VdotH = std::max(VdotHRaw, 0.0f);
+
+        if (NdotL > 0.0f)
+        {
+            float G = NdotL / (NdotL * (1.0f - k) + k) * ggxV;
+            float G_Vis = (G * VdotH) / (NdotH * NdotV);
+            float t = 1.0f - VdotH;
+            float Fc = t * t * t * t * t;
+            A += (1.0f - Fc) * G_Vis;
+            B += Fc * G_Vis;
+        }
+    }
+    return glm::vec2(A, B) / float(IBL_SAMPLE_COUNT);
+}
+
+#ifdef PCONTUM_IBL_SSE2
+// same as integrateBrdfScalar(), four samples per instruction
+inline glm::vec2 integrateBrdf(float NdotV, float roughness, const BrdfSamples &samples)
+{
+    float a = roughness * roughness;
+    float k = a / 2.0f;
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 a2m1 = _mm_set1_ps(a * a - 1.0f);
+    const __m128 kv = _mm_set1_ps(k);
+    const __m128 oneMinusK = _mm_set1_ps(1.0f - k);
+    const __m128 Vx = _mm_set1_ps(std::sqrt(1.0f - NdotV * NdotV));
+    const __m128 Vz = _mm_set1_ps(NdotV);
+    const __m128 ggxVOverNdotV = _mm_set1_ps((NdotV / (NdotV * (1.0f - k) + k)) / NdotV);
+
+    __m128 A = zero, B = zero;
+    for (uint32_t i = 0; i < IBL_SAMPLE_COUNT; i += 4)
+    {
+        __m128 y = _mm_loadu_ps(&samples.xiY[i]);
+        __m128 cosTheta = _mm_sqrt_ps(_mm_div_ps(_mm_sub_ps(one, y), _mm_add_ps(one, _mm_mul_ps(a2m1, y))));
+        __m128 sinTheta = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(one, _mm_mul_ps(cosTheta, cosTheta)), zero));
+        __m128 Hx = _mm_mul_ps(_mm_loadu_ps(&samples.sinPhi[i]), sinTheta);
+        __m128 Hy = _mm_sub_ps(zero, _mm_mul_ps(_mm_loadu_ps(&samples.cosPhi[i]), sinTheta));
+        __m128 Hz = cosTheta;
+
+        __m128 VdotHRaw = _mm_add_ps(_mm_mul_ps(Vx, Hx), _mm_mul_ps(Vz, Hz));
+        __m128 twoVdotH = _mm_mul_ps(two, VdotHRaw);
+        __m128 Lx = _mm_sub_ps(_mm_mul_ps(twoVdotH, Hx), Vx);
+        __m128 Ly = _mm_mul_ps(twoVdotH, Hy);
+        __m128 Lz = _mm_sub_ps(_mm_mul_ps(twoVdotH, Hz), Vz);
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(Lx, Lx), _mm_mul_ps(Ly, Ly)), _mm_mul_ps(Lz, Lz)));
+        __m128 NdotL = _mm_max_ps(_mm_div_ps(Lz, length), zero);
+        __m128 NdotH = _mm_max_ps(Hz, zero);
+        __m128 VdotH = _mm_max_ps(VdotHRaw, zero);
+
+        __m128 ggxL = _mm_div_ps(NdotL, _mm_add_ps(_mm_mul_ps(NdotL, oneMinusK), kv));
+        __m128 G_Vis = _mm_div_ps(_mm_mul_ps(_mm_mul_ps(ggxL, ggxVOverNdotV), VdotH), NdotH);
+        __m128 t = _mm_sub_ps(one, VdotH);
+        __m128 t2 = _mm_mul_ps(t, t);
+        __m128 Fc = _mm_mul_ps(_mm_mul_ps(t2, t2), t);
+
+        __m128 valid = _mm_cmpgt_ps(NdotL, zero);
+        A = _mm_add_ps(A, _mm_and_ps(valid, _mm_mul_ps(_mm_sub_ps(one, Fc), G_Vis)));
+        B = _mm_add_ps(B, _mm_and_ps(valid, _mm_mul_ps(Fc, G_Vis)));
+    }
+
+    float a4[4], b4[4];
+    _mm_storeu_ps(a4, A);
+    _mm_storeu_ps(b4, B);
+    return glm::vec2((a4[0] + a4[1]) + (a4[2] + a4[3]), (b4[0] + b4[1]) + (b4[2] + b4[3])) / float(IBL_SAMPLE_COUNT);
+}
+#else
+inline glm::vec2 integrateBrdf(float NdotV, float roughness, const BrdfSamples &samples)
+{
+    return integrateBrdfScalar(NdotV, roughness, samples);
+}
+#endif
+
+// 2.2.2.brdf.fs over the whole LUT: x is NdotV, y is roughness, RG per texel
+inline std::vector<float> integrateBrdfLut(uint32_t size, ThreadPool &pool)
+{
+    BrdfSamples samples;
+    std::vector<float> lut(size_t(size) * size * 2);
+    pool.parallelFor(size, 4, [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; ++y)
+        {
+            float roughness = (y + 0.5f) / size;
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                glm::vec2 ab = integrateBrdf((x + 0.5f) / size, roughness, samples);
+                lut[(y * size + x) * 2 + 0] = ab.x;
+                lut[(y * size + x) * 2 + 1] = ab.y;
+            }
+        }
+    });
+    return lut;
+}
+
+// converts the first levelCount mips of a CPU cubemap to the cache's half-float layout
+inline IblImage cubemapToIblImage(const CpuCubemap &cube, uint32_t levelCount)
+{
+    IblImage image;
+    image.cubemap = 1;
+    image.channels = 3;
+    image.width = cube.size;
+    image.height = cube.size;
+    image.levels.resize(std::min(levelCount, cube.levelCount()));
+    for (uint32_t mip = 0; mip < image.levels.size(); ++mip)
+    {
+        const std::vector<float> &source = cube.levels[mip];
+        image.levels[mip].resize(source.size());
+        for (size_t i = 0; i < source.size(); ++i)
+            image.levels[mip][i] = floatToHalf(source[i]);
+    }
+    return image;
+}
+
+inline IblImage brdfLutToIblImage(const std::vector<float> &lut, uint32_t size)
+{
+    IblImage image;
+    image.cubemap = 0;
+    image.channels = 2;
+    image.width = size;
+    image.height = size;
+    image.levels.resize(1);
+    image.levels[0].resize(lut.size());
+    for (size_t i = 0; i < lut.size(); ++i)
+        image.levels[0][i] = floatToHalf(lut[i]);
+    return image;
+}
+
+#endif
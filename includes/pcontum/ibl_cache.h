@@ -0,0 +1,145 @@
+#ifndef IBL_CACHE_H
+#define IBL_CACHE_H
+
+#include <pcontum/half_float.h>
+#include <pcontum/hash.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// The baked environment, irradiance, prefilter and BRDF LUT textures in one binary file.
+// The container is GL-free so that the windowed demo and headless tools read and write the same format.
+//
+// Layout (native little-endian):
+//   char[4] "PIBL", uint32 version, uint64 key
+//   4 x image: uint32 cubemap, channels, width, height, levels
+//              then for every level, every face: width x height x channels half floats
+// The key is a hash of the source HDR bytes and the bake settings; a mismatch means "bake again".
+
+// sizes used by the bake passes; all of them end up in the cache key
+struct IblBakeSettings
+{
+    uint32_t environmentSize = 512;   // equirectangular -> cubemap capture
+    uint32_t irradianceSize = 32;     // diffuse convolution
+    uint32_t prefilterSize = 128;     // GGX prefilter, mip 0
+    uint32_t prefilterMipLevels = 5;  // roughness 0..1 over these mips
+    uint32_t brdfSize = 512;          // split-sum LUT
+};
+
+const uint32_t IBL_CACHE_VERSION = 1;
+
+// one baked texture with all of its mips, stored as half floats
+struct IblImage
+{
+    uint32_t cubemap = 0;
+    uint32_t channels = 0; // 3 (RGB16F) or 2 (RG16F)
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<std::vector<uint16_t>> levels; // levels[mip] holds the faces back to back
+
+    uint32_t faces() const { return cubemap ? 6 : 1; }
+    uint32_t levelWidth(uint32_t mip) const { return (width >> mip) ? (width >> mip) : 1; }
+    uint32_t levelHeight(uint32_t mip) const { return (height >> mip) ? (height >> mip) : 1; }
+    // half floats in one face of a mip
+    size_t faceSize(uint32_t mip) const { return size_t(levelWidth(mip)) * levelHeight(mip) * channels; }
+    size_t levelSize(uint32_t mip) const { return faceSize(mip) * faces(); }
+};
+
+struct IblCache
+{
+    uint64_t key = 0;
+    IblImage environment;
+    IblImage irradiance;
+    IblImage prefilter;
+    IblImage brdfLUT;
+};
+
+// hash of the HDR file contents and the bake settings; 0 if the HDR can't be read
+inline uint64_t iblCacheKey(const std::string &hdrPath, const IblBakeSettings &settings)
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    if (!fnv1aFile(hash, hdrPath))
+        return 0;
+    fnv1a(hash, &IBL_CACHE_VERSION, sizeof(IBL_CACHE_VERSION));
+    fnv1a(hash, &settings, sizeof(settings));
+    return hash;
+}
+
+inline bool writeIblImage(std::ofstream &file, const IblImage &image)
+{
+    uint32_t header[] = { image.cubemap, image.channels, image.width, image.height,
+                          static_cast<uint32_t>(image.levels.size()) };
+    file.write(reinterpret_cast<const char *>(header), sizeof(header));
+    for (uint32_t mip = 0; mip < image.levels.size(); ++mip)
+    {
+        if (image.levels[mip].size() != image.levelSize(mip))
+            return false;
+        file.write(reinterpret_cast<const char *>(image.levels[mip].data()), image.levelSize(mip) * sizeof(uint16_t));
+    }
+    return static_cast<bool>(file);
+}
+
+inline bool readIblImage(std::ifstream &file, IblImage &image)
+{
+    uint32_t header[5];
+    if (!file.read(reinterpret_cast<char *>(header), sizeof(header)))
+        return false;
+    image.cubemap = header[0];
+    image.channels = header[1];
+    image.width = header[2];
+    image.height = header[3];
+    uint32_t levelCount = header[4];
+    // reject anything that a bake could not have produced before allocating for it
+    if (image.cubemap > 1 || image.channels < 1 || image.channels > 4 || image.width == 0 || image.height == 0 ||
+        image.width > 16384 || image.height > 16384 || levelCount == 0 || levelCount > 15)
+        return false;
+
+    image.levels.resize(levelCount);
+    for (uint32_t mip = 0; mip < levelCount; ++mip)
+    {
+        image.levels[mip].resize(image.levelSize(mip));
+        if (!file.read(reinterpret_cast<char *>(image.levels[mip].data()), image.levelSize(mip) * sizeof(uint16_t)))
+            return false;
+    }
+    return true;
+}
+
+// writes the whole cache; returns false if the file couldn't be written
+inline bool writeIblCache(const std::string &path, const IblCache &cache)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+    file.write("PIBL", 4);
+    file.write(reinterpret_cast<const char *>(&IBL_CACHE_VERSION), sizeof(IBL_CACHE_VERSION));
+    file.write(reinterpret_cast<const char *>(&cache.key), sizeof(cache.key));
+    return writeIblImage(file, cache.environment) && writeIblImage(file, cache.irradiance) &&
+           writeIblImage(file, cache.prefilter) && writeIblImage(file, cache.brdfLUT);
+}
+
+// reads a cache; expectedKey == 0 accepts any key (tools that just inspect a file)
+inline bool readIblCache(const std::string &path, uint64_t expectedKey, IblCache &cache)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    char magic[4];
+    uint32_t version = 0;
+    if (!file.read(magic, 4) || std::memcmp(magic, "PIBL", 4) != 0)
+        return false;
+    if (!file.read(reinterpret_cast<char *>(&version), sizeof(version)) || version != IBL_CACHE_VERSION)
+        return false;
+    if (!file.read(reinterpret_cast<char *>(&cache.key), sizeof(cache.key)))
+        return false;
+    if (expectedKey != 0 && cache.key != expectedKey)
+        return false;
+
+    return readIblImage(file, cache.environment) && readIblImage(file, cache.irradiance) &&
+           readIblImage(file, cache.prefilter) && readIblImage(file, cache.brdfLUT);
+}
+
+#endif
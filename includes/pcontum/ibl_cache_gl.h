@@ -0,0 +1,74 @@
+#ifndef IBL_CACHE_GL_H
+#define IBL_CACHE_GL_H
+
+#include <glad/glad.h>
+
+#include <pcontum/ibl_cache.h>
+
+// GL side of the IBL cache: reads baked textures back as half floats and recreates them on a cache hit.
+
+// reads every mip of a baked texture; levels is how many mips the bake actually wrote
+inline IblImage downloadIblImage(unsigned int texture, bool cubemap, uint32_t channels, uint32_t levels)
+{
+    IblImage image;
+    image.cubemap = cubemap ? 1 : 0;
+    image.channels = channels;
+
+    GLenum target = cubemap ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+    GLenum faceTarget = cubemap ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : GL_TEXTURE_2D;
+    GLenum format = (channels == 3) ? GL_RGB : GL_RG;
+
+    GLint width = 0, height = 0;
+    glBindTexture(target, texture);
+    glGetTexLevelParameteriv(faceTarget, 0, GL_TEXTURE_WIDTH, &width);
+    glGetTexLevelParameteriv(faceTarget, 0, GL_TEXTURE_HEIGHT, &height);
+    image.width = static_cast<uint32_t>(width);
+    image.height = static_cast<uint32_t>(height);
+
+    // RGB half rows of small mips aren't 4-byte multiples
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    image.levels.resize(levels);
+    for (uint32_t mip = 0; mip < levels; ++mip)
+    {
+        image.levels[mip].resize(image.levelSize(mip));
+        for (uint32_t face = 0; face < image.faces(); ++face)
+            glGetTexImage(faceTarget + face, mip, format, GL_HALF_FLOAT, image.levels[mip].data() + face * image.faceSize(mip));
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    return image;
+}
+
+// creates a texture from a cached image with the sampler state the bake uses
+inline unsigned int uploadIblImage(const IblImage &image)
+{
+    GLenum target = image.cubemap ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+    GLenum faceTarget = image.cubemap ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : GL_TEXTURE_2D;
+    GLenum internalFormat = (image.channels == 3) ? GL_RGB16F : GL_RG16F;
+    GLenum format = (image.channels == 3) ? GL_RGB : GL_RG;
+    uint32_t levels = static_cast<uint32_t>(image.levels.size());
+
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(target, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (uint32_t mip = 0; mip < levels; ++mip)
+    {
+        for (uint32_t face = 0; face < image.faces(); ++face)
+            glTexImage2D(faceTarget + face, mip, internalFormat, image.levelWidth(mip), image.levelHeight(mip), 0, format,
+                         GL_HALF_FLOAT, image.levels[mip].data() + face * image.faceSize(mip));
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // only the stored mips exist, so cap the chain there to keep the texture complete
+    glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    if (image.cubemap)
+        glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return texture;
+}
+
+#endif
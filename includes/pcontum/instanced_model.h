@@ -0,0 +1,124 @@
+#ifndef INSTANCED_MODEL_H
+#define INSTANCED_MODEL_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <pcontum/scene_model.h>
+#include <pcontum/shader_program.h>
+
+#include <cstddef>
+#include <vector>
+
+// Draws every mesh of a model once per instance with glDrawElementsInstanced.
+// The per-instance model and normal matrices live in a vertex buffer with an attribute divisor of 1
+// instead of in uniforms, so a whole formation costs one draw call (and one set of texture binds) per mesh.
+// The shader reads them when its "instanced" uniform is set, see 2.2.2.pbr.vs.
+class InstancedModel
+{
+public:
+    // attribute slots after the Vertex layout of mesh.h (0..6); a mat4 takes 4 slots, a mat3 takes 3
+    static const unsigned int MODEL_MATRIX_LOCATION = 7;
+    static const unsigned int NORMAL_MATRIX_LOCATION = 11;
+
+    struct Instance
+    {
+        glm::mat4 model;
+        glm::mat3 normalMatrix;
+    };
+
+    InstancedModel(std::vector<SceneMesh> &meshes) : meshes(meshes)
+    {
+        glGenBuffers(1, &instanceVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        for (unsigned int i = 0; i < meshes.size(); i++)
+        {
+            glBindVertexArray(meshes[i].VAO);
+            for (unsigned int column = 0; column < 4; column++)
+            {
+                glEnableVertexAttribArray(MODEL_MATRIX_LOCATION + column);
+                glVertexAttribPointer(MODEL_MATRIX_LOCATION + column, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                                      (void*)(offsetof(Instance, model) + column * sizeof(glm::vec4)));
+                glVertexAttribDivisor(MODEL_MATRIX_LOCATION + column, 1);
+            }
+            for (unsigned int column = 0; column < 3; column++)
+            {
+                glEnableVertexAttribArray(NORMAL_MATRIX_LOCATION + column);
+                glVertexAttribPointer(NORMAL_MATRIX_LOCATION + column, 3, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                                      (void*)(offsetof(Instance, normalMatrix) + column * sizeof(glm::vec3)));
+                glVertexAttribDivisor(NORMAL_MATRIX_LOCATION + column, 1);
+            }
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // uploads this frame's model matrices; the normal matrices are derived here once per instance
+    void update(const std::vector<glm::mat4> &modelMatrices)
+    {
+        instances.resize(modelMatrices.size());
+        for (unsigned int i = 0; i < modelMatrices.size(); i++)
+        {
+            instances[i].model = modelMatrices[i];
+            instances[i].normalMatrix = glm::transpose(glm::inverse(glm::mat3(modelMatrices[i])));
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        if (instances.size() > capacity)
+        {
+            capacity = instances.size();
+            glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Instance), instances.data(), GL_STREAM_DRAW);
+        }
+        else
+        {
+            // orphan the old storage so we don't wait on the previous frame's draws
+            glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(Instance), instances.data());
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // draws all instances; binds the mesh textures the same way SceneMesh::Draw does
+    void Draw(ShaderProgram &shader)
+    {
+        if (instances.empty())
+            return;
+
+        GLint dequantize = shader.uniforms.location("positionDequantize");
+        shader.setBool("instanced", true);
+        for (unsigned int i = 0; i < meshes.size(); i++)
+        {
+            SceneMesh &mesh = meshes[i];
+            mesh.bindTextures(shader);
+            glm::mat4 matrix = mesh.quantization.matrix();
+            glUniformMatrix4fv(dequantize, 1, GL_FALSE, &matrix[0][0]);
+
+            glBindVertexArray(mesh.VAO);
+            glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(mesh.indexCount), GL_UNSIGNED_INT, 0,
+                                    static_cast<GLsizei>(instances.size()));
+            glBindVertexArray(0);
+            glActiveTexture(GL_TEXTURE0);
+        }
+        shader.setBool("instanced", false);
+    }
+
+    unsigned int count() const { return static_cast<unsigned int>(instances.size()); }
+
+    // whether Draw() binds any textures of its own (see RenderQueue::submit)
+    bool bindsTextures() const
+    {
+        for (const SceneMesh &mesh : meshes)
+            if (!mesh.textures.empty())
+                return true;
+        return false;
+    }
+
+private:
+    std::vector<SceneMesh> &meshes;
+    unsigned int instanceVBO = 0;
+    size_t capacity = 0;
+    std::vector<Instance> instances;
+};
+
+#endif
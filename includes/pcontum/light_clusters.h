@@ -0,0 +1,268 @@
+#ifndef LIGHT_CLUSTERS_H
+#define LIGHT_CLUSTERS_H
+
+#include <glm/glm.hpp>
+
+#include <pcontum/culling.h>
+#include <pcontum/thread_pool.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Clustered lighting: the PBR camera's view volume is cut into CLUSTER_TILES_X x CLUSTER_TILES_Y
+// screen tiles and CLUSTER_SLICES depth slices (exponential in view depth, so near clusters are not
+// stretched), and every frame each point light is listed in the clusters its sphere of influence
+// touches. A fragment then only shades the lights of its own cluster, so its cost follows the local light
+// density instead of the scene's light count.
+//
+// Binning runs per depth slice on the thread pool (a slice's clusters are written by one job only) and
+// tests a light against four cluster boxes at a time with the AabbPacket4 layout of culling.h. The result
+// is compacted into three flat arrays for texture buffers (light_clusters_gl.h):
+//   lightData   2 x vec4 per light: world position and radius, color
+//   grid        2 x uint32 per cluster: first entry in indices, count; cluster = (z * TILES_Y + y) * TILES_X + x
+//   indices     uint16 light numbers
+// Tiles count from the bottom left of the viewport like gl_FragCoord.
+
+const int CLUSTER_TILES_X = 16;
+const int CLUSTER_TILES_Y = 9;
+const int CLUSTER_SLICES = 24;
+const int CLUSTER_COUNT = CLUSTER_TILES_X * CLUSTER_TILES_Y * CLUSTER_SLICES;
+// lights beyond this in one cluster are dropped (and counted); far more than the demo ever puts in one
+const int MAX_LIGHTS_PER_CLUSTER = 64;
+
+// the grid size for the shader, as ProgramCache defines
+inline std::string lightClusterDefines()
+{
+    return "#define CLUSTER_TILES_X " + std::to_string(CLUSTER_TILES_X) + "\n#define CLUSTER_TILES_Y " +
+           std::to_string(CLUSTER_TILES_Y) + "\n#define CLUSTER_SLICES " + std::to_string(CLUSTER_SLICES) + "\n";
+}
+
+struct PointLight
+{
+    glm::vec3 position; // world space
+    float radius;       // no contribution beyond this
+    glm::vec3 color;    // radiance at 1 unit
+};
+
+// where color / distance^2 falls below cutoff in every channel; the shader fades the light out towards
+// this radius so the cut is not visible
+inline float pointLightRadius(const glm::vec3 &color, float cutoff = 0.01f)
+{
+    float peak = std::max(color.x, std::max(color.y, color.z));
+    return peak > 0.0f ? std::sqrt(peak / cutoff) : 0.0f;
+}
+
+// bits of the lanes whose box the sphere reaches
+inline int sphereTest4(const glm::vec3 &center, float radius, const AabbPacket4 &boxes)
+{
+#ifdef PCONTUM_CULL_SSE
+    __m128 zero = _mm_setzero_ps();
+    __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+    // distance from the center to each box along every axis, 0 inside the slab
+    __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(boxes.minX), cx), _mm_sub_ps(cx, _mm_load_ps(boxes.maxX))), zero);
+    __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(boxes.minY), cy), _mm_sub_ps(cy, _mm_load_ps(boxes.maxY))), zero);
+    __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(boxes.minZ), cz), _mm_sub_ps(cz, _mm_load_ps(boxes.maxZ))), zero);
+    __m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+    return _mm_movemask_ps(_mm_cmple_ps(distance2, _mm_set1_ps(radius * radius)));
+#else
+    int hits = 0;
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        float dx = std::max(std::max(boxes.minX[lane] - center.x, center.x - boxes.maxX[lane]), 0.0f);
+        float dy = std::max(std::max(boxes.minY[lane] - center.y, center.y - boxes.maxY[lane]), 0.0f);
+        float dz = std::max(std::max(boxes.minZ[lane] - center.z, center.z - boxes.maxZ[lane]), 0.0f);
+        if (dx * dx + dy * dy + dz * dz <= radius * radius)
+            hits |= 1 << lane;
+    }
+    return hits;
+#endif
+}
+
+struct LightClusterStats
+{
+    size_t lights = 0;
+    size_t visibleLights = 0;   // touching at least one depth slice
+    size_t assignments = 0;     // entries in the index list
+    size_t maxPerCluster = 0;
+    size_t overflow = 0;        // assignments dropped at MAX_LIGHTS_PER_CLUSTER
+};
+
+class LightClusters
+{
+public:
+    static_assert(CLUSTER_TILES_X * CLUSTER_TILES_Y % 4 == 0, "a slice's tiles must fill whole packets");
+
+    LightClusters()
+        : packets(CLUSTER_COUNT / 4), sliceCounts(CLUSTER_COUNT),
+          sliceIndices(static_cast<size_t>(CLUSTER_COUNT) * MAX_LIGHTS_PER_CLUSTER), sliceOverflow(CLUSTER_SLICES),
+          grid(CLUSTER_COUNT * 2)
+    {
+    }
+
+    // view-space boxes of the clusters for a symmetric perspective projection; again whenever it changes
+    void setProjection(float fovY, float aspect, float nearDistance, float farDistance)
+    {
+        nearPlane = nearDistance;
+        farPlane = farDistance;
+        float tanY = std::tan(fovY * 0.5f);
+        float tanX = tanY * aspect;
+        for (int z = 0; z < CLUSTER_SLICES; ++z)
+        {
+            float depth0 = sliceDepth(z), depth1 = sliceDepth(z + 1);
+            for (int y = 0; y < CLUSTER_TILES_Y; ++y)
+            {
+                float y0 = -1.0f + 2.0f * y / CLUSTER_TILES_Y, y1 = -1.0f + 2.0f * (y + 1) / CLUSTER_TILES_Y;
+                for (int x = 0; x < CLUSTER_TILES_X; ++x)
+                {
+                    float x0 = -1.0f + 2.0f * x / CLUSTER_TILES_X, x1 = -1.0f + 2.0f * (x + 1) / CLUSTER_TILES_X;
+                    // the cluster is a frustum piece; its box holds the four corners at both depths
+                    Aabb box;
+                    for (float depth : { depth0, depth1 })
+                        for (float ndcX : { x0, x1 })
+                            for (float ndcY : { y0, y1 })
+                                box.expand(glm::vec3(ndcX * tanX * depth, ndcY * tanY * depth, -depth));
+                    int cluster = clusterIndex(x, y, z);
+                    packets[cluster / 4].set(cluster % 4, box);
+                }
+            }
+        }
+    }
+
+    // bins this frame's lights; view is the camera the shader's gl_FragCoord belongs to. With no pool it
+    // all runs on the calling thread.
+    void assign(const std::vector<PointLight> &lights, const glm::mat4 &view, ThreadPool *workers)
+    {
+        lastStats = LightClusterStats();
+        lastStats.lights = lights.size();
+
+        lightData.resize(lights.size() * 2);
+        viewLights.clear();
+        float logRange = std::log(farPlane / nearPlane);
+        for (size_t i = 0; i < lights.size() && i <= UINT16_MAX; ++i)
+        {
+            const PointLight &light = lights[i];
+            lightData[i * 2] = glm::vec4(light.position, light.radius);
+            lightData[i * 2 + 1] = glm::vec4(light.color, 0.0f);
+            glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+            float nearest = -center.z - light.radius, farthest = -center.z + light.radius;
+            if (light.radius <= 0.0f || farthest < nearPlane || nearest > farPlane)
+                continue;
+            ViewLight viewLight;
+            viewLight.center = center;
+            viewLight.radius = light.radius;
+            viewLight.index = static_cast<uint16_t>(i);
+            viewLight.firstSlice = sliceOf(nearest, logRange);
+            viewLight.lastSlice = sliceOf(farthest, logRange);
+            viewLights.push_back(viewLight);
+        }
+        lastStats.visibleLights = viewLights.size();
+
+        auto binSlices = [this](size_t begin, size_t end) {
+            for (size_t slice = begin; slice < end; ++slice)
+                binSlice(static_cast<int>(slice));
+        };
+        if (workers)
+            workers->parallelFor(CLUSTER_SLICES, 2, binSlices);
+        else
+            binSlices(0, CLUSTER_SLICES);
+
+        // compact: clusters in order, each one's lights after the previous one's
+        indices.clear();
+        for (int cluster = 0; cluster < CLUSTER_COUNT; ++cluster)
+        {
+            uint16_t count = sliceCounts[cluster];
+            grid[cluster * 2] = static_cast<uint32_t>(indices.size());
+            grid[cluster * 2 + 1] = count;
+            const uint16_t *first = &sliceIndices[static_cast<size_t>(cluster) * MAX_LIGHTS_PER_CLUSTER];
+            indices.insert(indices.end(), first, first + count);
+            lastStats.maxPerCluster = std::max<size_t>(lastStats.maxPerCluster, count);
+        }
+        for (size_t overflow : sliceOverflow)
+            lastStats.overflow += overflow;
+        lastStats.assignments = indices.size();
+    }
+
+    // shader side: slice = log(view depth) * x + y
+    glm::vec2 depthScale() const
+    {
+        float scale = CLUSTER_SLICES / std::log(farPlane / nearPlane);
+        return glm::vec2(scale, -std::log(nearPlane) * scale);
+    }
+
+    const std::vector<glm::vec4> &lightTexels() const { return lightData; }
+    const std::vector<uint32_t> &gridTexels() const { return grid; }
+    const std::vector<uint16_t> &indexTexels() const { return indices; }
+    const LightClusterStats &stats() const { return lastStats; }
+
+    static int clusterIndex(int x, int y, int z) { return (z * CLUSTER_TILES_Y + y) * CLUSTER_TILES_X + x; }
+
+private:
+    struct ViewLight
+    {
+        glm::vec3 center; // view space
+        float radius;
+        int firstSlice, lastSlice;
+        uint16_t index;
+    };
+
+    float nearPlane = 0.1f, farPlane = 100.0f;
+    std::vector<AabbPacket4> packets; // cluster boxes in cluster order, four per packet
+    std::vector<ViewLight> viewLights;
+    // per cluster, written by the job of its slice
+    std::vector<uint16_t> sliceCounts;
+    std::vector<uint16_t> sliceIndices; // MAX_LIGHTS_PER_CLUSTER slots per cluster
+    std::vector<size_t> sliceOverflow;
+    std::vector<glm::vec4> lightData;
+    std::vector<uint32_t> grid;
+    std::vector<uint16_t> indices;
+    LightClusterStats lastStats;
+
+    float sliceDepth(int slice) const
+    {
+        return nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(slice) / CLUSTER_SLICES);
+    }
+
+    int sliceOf(float depth, float logRange) const
+    {
+        if (depth <= nearPlane)
+            return 0;
+        int slice = static_cast<int>(std::log(depth / nearPlane) / logRange * CLUSTER_SLICES);
+        return std::min(slice, CLUSTER_SLICES - 1);
+    }
+
+    void binSlice(int slice)
+    {
+        const int tiles = CLUSTER_TILES_X * CLUSTER_TILES_Y;
+        int firstCluster = slice * tiles;
+        std::fill(sliceCounts.begin() + firstCluster, sliceCounts.begin() + firstCluster + tiles, uint16_t(0));
+        sliceOverflow[slice] = 0;
+        for (const ViewLight &light : viewLights)
+        {
+            if (slice < light.firstSlice || slice > light.lastSlice)
+                continue;
+            for (int packet = firstCluster / 4; packet < (firstCluster + tiles) / 4; ++packet)
+            {
+                int hits = sphereTest4(light.center, light.radius, packets[packet]);
+                for (int lane = 0; hits != 0; ++lane, hits >>= 1)
+                {
+                    if (!(hits & 1))
+                        continue;
+                    int cluster = packet * 4 + lane;
+                    uint16_t &count = sliceCounts[cluster];
+                    if (count == MAX_LIGHTS_PER_CLUSTER)
+                    {
+                        ++sliceOverflow[slice];
+                        continue;
+                    }
+                    sliceIndices[static_cast<size_t>(cluster) * MAX_LIGHTS_PER_CLUSTER + count++] = light.index;
+                }
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef LIGHT_CLUSTERS_GL_H
+#define LIGHT_CLUSTERS_GL_H
+
+#include <glad/glad.h>
+
+#include <pcontum/light_clusters.h>
+#include <pcontum/shader_program.h>
+
+#include <algorithm>
+
+// GL side of the light clusters: the three arrays as texture buffers, respecified every frame, and the
+// uniforms the PBR shader needs to find its cluster (see 2.2.2.pbr.fs).
+class LightClusterBuffers
+{
+public:
+    // texture units, above the ones the PBR shader and MultiDrawList use
+    static const int LIGHT_UNIT = 10;
+    static const int GRID_UNIT = 11;
+    static const int INDEX_UNIT = 12;
+
+    LightClusterBuffers()
+    {
+        glGenBuffers(3, buffers);
+        glGenTextures(3, textures);
+        const GLenum formats[] = { GL_RGBA32F, GL_RG32UI, GL_R16UI };
+        for (int i = 0; i < 3; ++i)
+        {
+            glBindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+            glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+            glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+            glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+        }
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    ~LightClusterBuffers() { release(); }
+
+    // deletes the buffers and texture views; called by the owner while the GL context is still current
+    void release()
+    {
+        if (!buffers[0])
+            return;
+        glDeleteTextures(3, textures);
+        glDeleteBuffers(3, buffers);
+        for (int i = 0; i < 3; ++i)
+            textures[i] = buffers[i] = 0;
+    }
+
+    LightClusterBuffers(const LightClusterBuffers &) = delete;
+    LightClusterBuffers &operator=(const LightClusterBuffers &) = delete;
+
+    // after LightClusters::assign; orphaning the storage keeps the upload from waiting on last frame's draws
+    void upload(const LightClusters &clusters)
+    {
+        upload(buffers[0], clusters.lightTexels().data(), clusters.lightTexels().size() * sizeof(glm::vec4));
+        upload(buffers[1], clusters.gridTexels().data(), clusters.gridTexels().size() * sizeof(uint32_t));
+        upload(buffers[2], clusters.indexTexels().data(), clusters.indexTexels().size() * sizeof(uint16_t));
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        depthScale = clusters.depthScale();
+    }
+
+    // binds the buffers and sets the lookup uniforms; the shader must be in use. viewport is the size
+    // gl_FragCoord counts in.
+    void bind(ShaderProgram &shader, int viewportWidth, int viewportHeight) const
+    {
+        const int units[] = { LIGHT_UNIT, GRID_UNIT, INDEX_UNIT };
+        for (int i = 0; i < 3; ++i)
+        {
+            glActiveTexture(GL_TEXTURE0 + units[i]);
+            glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+        }
+        glActiveTexture(GL_TEXTURE0);
+
+        shader.setInt("clusterLights", LIGHT_UNIT);
+        shader.setInt("clusterGrid", GRID_UNIT);
+        shader.setInt("clusterLightIndices", INDEX_UNIT);
+        glUniform2f(shader.uniforms.location("clusterTileScale"), static_cast<float>(CLUSTER_TILES_X) / viewportWidth,
+                    static_cast<float>(CLUSTER_TILES_Y) / viewportHeight);
+        glUniform2f(shader.uniforms.location("clusterDepthScale"), depthScale.x, depthScale.y);
+    }
+
+private:
+    unsigned int buffers[3] = {};  // lights, grid, indices
+    unsigned int textures[3] = {};
+    glm::vec2 depthScale = glm::vec2(0.0f);
+
+    static void upload(unsigned int buffer, const void *data, size_t size)
+    {
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        // an empty buffer texture is fine to bind, but keep a few bytes so the store never has size 0
+        glBufferData(GL_TEXTURE_BUFFER, std::max<size_t>(size, 16), nullptr, GL_STREAM_DRAW);
+        if (size > 0)
+            glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+    }
+};
+
+#endif
@@ -0,0 +1,500 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <pcontum/hash.h>
+#include <pcontum/mapped_file.h>
+#include <pcontum/model_data.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A parsed model in a file that is used in place. The runtime maps it and uploads the
+// vertex and index sections straight from the mapping, so the COLLADA parse and Assimp's post-processing
+// only run when the source changes.
+//
+// Layout (native little-endian, every section 16-byte aligned):
+//   MeshCacheHeader
+//   MeshRecord[meshCount]
+//   MaterialRecord[materialCount]   unique texture lists, shared by the meshes that use them
+//   TextureRecord[textureCount]     type and path, as offsets into the string table
+//   MeshLod[lodCount]               simplified levels of all meshes
+//   string table
+//   animation                       skeleton and clips (see writeAnimation), empty for a static model
+//   per mesh: PackedVertex[vertexCount], then uint32 indices[indexCount + lodIndexCount] (full detail,
+//   then the simplified levels)
+// The key is a hash of the source file, the format version and sizeof(PackedVertex); any mismatch means
+// "parse again and rewrite".
+
+const uint32_t MESH_CACHE_VERSION = 4;
+
+struct MeshCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceKey;
+    uint32_t vertexSize;
+    uint32_t meshCount;
+    uint32_t materialCount;
+    uint32_t textureCount;
+    uint32_t lodCount;
+    uint32_t padding;
+    uint64_t meshTable;
+    uint64_t materialTable;
+    uint64_t textureTable;
+    uint64_t lodTable;
+    uint64_t strings;
+    uint64_t stringsSize;
+    uint64_t animation;
+    uint64_t animationSize;
+};
+
+struct MeshRecord
+{
+    uint64_t vertexOffset;
+    uint64_t vertexCount;
+    uint64_t indexOffset;
+    uint64_t indexCount;
+    uint64_t lodIndexCount;
+    uint32_t material;
+    uint32_t firstLod;
+    uint32_t lodCount;
+    uint32_t padding;
+    float quantizationOffset[3];
+    float quantizationScale[3];
+};
+
+struct MaterialRecord
+{
+    uint32_t firstTexture;
+    uint32_t textureCount;
+};
+
+struct TextureRecord
+{
+    uint32_t typeOffset;
+    uint32_t typeLength;
+    uint32_t pathOffset;
+    uint32_t pathLength;
+};
+
+// hash of the source model and the things that decide the binary layout; 0 if the source can't be read
+inline uint64_t meshCacheKey(const std::string &sourcePath)
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    if (!fnv1aFile(hash, sourcePath))
+        return 0;
+    uint32_t vertexSize = sizeof(PackedVertex);
+    fnv1a(hash, &MESH_CACHE_VERSION, sizeof(MESH_CACHE_VERSION));
+    fnv1a(hash, &vertexSize, sizeof(vertexSize));
+    return hash;
+}
+
+// the source's absolute path, so that the game and the builder tool name the same file the same way
+inline std::string absoluteSourcePath(const std::string &sourcePath)
+{
+#ifdef _WIN32
+    char buffer[_MAX_PATH];
+    return _fullpath(buffer, sourcePath.c_str(), sizeof(buffer)) ? std::string(buffer) : sourcePath;
+#else
+    char *resolved = realpath(sourcePath.c_str(), nullptr);
+    if (!resolved)
+        return sourcePath;
+    std::string path(resolved);
+    std::free(resolved);
+    return path;
+#endif
+}
+
+// cache file for a source model, in the working directory next to the IBL cache: the source's file name
+// and a hash of its full path, so that two models with the same file name in different directories
+// don't overwrite each other's cache
+inline std::string meshCachePath(const std::string &sourcePath)
+{
+    std::string absolute = absoluteSourcePath(sourcePath);
+    uint64_t hash = FNV_OFFSET_BASIS;
+    fnv1a(hash, absolute.data(), absolute.size());
+    size_t slash = absolute.find_last_of("/\\");
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".%016llx.meshcache", static_cast<unsigned long long>(hash));
+    return (slash == std::string::npos ? absolute : absolute.substr(slash + 1)) + suffix;
+}
+
+inline uint64_t alignMeshCache(uint64_t offset)
+{
+    return (offset + 15) & ~uint64_t(15);
+}
+
+// animation section: globalInverse, then per joint a JointRecord and its name, then per clip a ClipRecord,
+// its name, AnimationTrack[trackCount], float times[keyCount] and vec4 values[keyCount]. Sequential and
+// small, so it is copied out rather than used in place.
+struct AnimationSectionHeader
+{
+    uint32_t jointCount;
+    uint32_t clipCount;
+};
+
+struct JointRecord
+{
+    int32_t parent;
+    uint32_t nameLength;
+    glm::mat4 offset;
+    glm::vec4 translation;
+    glm::vec4 rotation;
+    glm::vec4 scale;
+};
+
+struct ClipRecord
+{
+    float duration;
+    uint32_t nameLength;
+    uint32_t trackCount;
+    uint32_t keyCount;
+};
+
+inline std::string writeAnimation(const ModelAnimation &animation)
+{
+    std::string section;
+    if (animation.skeleton.empty())
+        return section;
+    auto append = [&section](const void *data, size_t size) { section.append(static_cast<const char *>(data), size); };
+    const Skeleton &skeleton = animation.skeleton;
+    AnimationSectionHeader header;
+    header.jointCount = static_cast<uint32_t>(skeleton.size());
+    header.clipCount = static_cast<uint32_t>(animation.clips.size());
+    append(&header, sizeof(header));
+    append(&skeleton.globalInverse, sizeof(glm::mat4));
+    for (size_t j = 0; j < skeleton.size(); ++j)
+    {
+        JointRecord record;
+        record.parent = skeleton.parents[j];
+        record.nameLength = static_cast<uint32_t>(skeleton.names[j].size());
+        record.offset = skeleton.offsets[j];
+        record.translation = skeleton.bindPose.translations[j];
+        record.rotation = skeleton.bindPose.rotations[j];
+        record.scale = skeleton.bindPose.scales[j];
+        append(&record, sizeof(record));
+        append(skeleton.names[j].data(), skeleton.names[j].size());
+    }
+    for (const AnimationClip &clip : animation.clips)
+    {
+        ClipRecord record;
+        record.duration = clip.duration;
+        record.nameLength = static_cast<uint32_t>(clip.name.size());
+        record.trackCount = static_cast<uint32_t>(clip.tracks.size());
+        record.keyCount = static_cast<uint32_t>(clip.keyTimes.size());
+        append(&record, sizeof(record));
+        append(clip.name.data(), clip.name.size());
+        append(clip.tracks.data(), clip.tracks.size() * sizeof(AnimationTrack));
+        append(clip.keyTimes.data(), clip.keyTimes.size() * sizeof(float));
+        append(clip.keyValues.data(), clip.keyValues.size() * sizeof(glm::vec4));
+    }
+    return section;
+}
+
+// false if the section is damaged; joint and key references are checked so sampling can trust them
+inline bool readAnimation(const unsigned char *data, uint64_t size, ModelAnimation &animation)
+{
+    animation = ModelAnimation();
+    if (size == 0)
+        return true;
+    auto take = [&data, &size](void *target, uint64_t bytes) {
+        if (bytes > size)
+            return false;
+        std::memcpy(target, data, static_cast<size_t>(bytes));
+        data += bytes;
+        size -= bytes;
+        return true;
+    };
+    auto takeString = [&take](std::string &target, uint32_t length) {
+        target.resize(length);
+        return take(&target[0], length);
+    };
+
+    AnimationSectionHeader header;
+    if (!take(&header, sizeof(header)) || header.jointCount == 0 || header.jointCount > MAX_SKELETON_JOINTS)
+        return false;
+    Skeleton &skeleton = animation.skeleton;
+    if (!take(&skeleton.globalInverse, sizeof(glm::mat4)))
+        return false;
+    skeleton.bindPose.resize(header.jointCount);
+    for (uint32_t j = 0; j < header.jointCount; ++j)
+    {
+        JointRecord record;
+        std::string name;
+        if (!take(&record, sizeof(record)) || record.parent >= static_cast<int32_t>(j) || record.parent < -1 ||
+            !takeString(name, record.nameLength))
+            return false;
+        skeleton.names.push_back(name);
+        skeleton.parents.push_back(record.parent);
+        skeleton.offsets.push_back(record.offset);
+        skeleton.bindPose.translations[j] = record.translation;
+        skeleton.bindPose.rotations[j] = record.rotation;
+        skeleton.bindPose.scales[j] = record.scale;
+    }
+    for (uint32_t c = 0; c < header.clipCount; ++c)
+    {
+        ClipRecord record;
+        AnimationClip clip;
+        if (!take(&record, sizeof(record)) || !takeString(clip.name, record.nameLength) ||
+            record.trackCount > size / sizeof(AnimationTrack))
+            return false;
+        clip.duration = record.duration;
+        clip.tracks.resize(record.trackCount);
+        if (!take(clip.tracks.data(), uint64_t(record.trackCount) * sizeof(AnimationTrack)) ||
+            record.keyCount > size / (sizeof(float) + sizeof(glm::vec4)))
+            return false;
+        clip.keyTimes.resize(record.keyCount);
+        clip.keyValues.resize(record.keyCount);
+        if (!take(clip.keyTimes.data(), uint64_t(record.keyCount) * sizeof(float)) ||
+            !take(clip.keyValues.data(), uint64_t(record.keyCount) * sizeof(glm::vec4)))
+            return false;
+        for (const AnimationTrack &track : clip.tracks)
+        {
+            if (track.joint >= header.jointCount)
+                return false;
+            for (const AnimationChannel &channel : track.channels)
+                if (channel.firstKey > record.keyCount || channel.keyCount > record.keyCount - channel.firstKey)
+                    return false;
+        }
+        animation.clips.push_back(std::move(clip));
+    }
+    return size == 0;
+}
+
+inline bool sameTextures(const std::vector<Texture> &a, const std::vector<Texture> &b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (a[i].type != b[i].type || a[i].path != b[i].path)
+            return false;
+    return true;
+}
+
+// writes model under key; goes through a temporary file so a reader never maps a half-written cache
+inline bool writeMeshCache(const std::string &cachePath, uint64_t key, const ModelData &model)
+{
+    std::vector<MeshRecord> meshes(model.meshes.size());
+    std::vector<MaterialRecord> materials;
+    std::vector<TextureRecord> textures;
+    std::vector<MeshLod> lods;
+    std::string strings;
+    std::vector<const std::vector<Texture> *> materialSources;
+
+    for (size_t i = 0; i < model.meshes.size(); ++i)
+    {
+        const std::vector<Texture> &list = model.meshes[i].textures;
+        uint32_t material = 0;
+        while (material < materialSources.size() && !sameTextures(*materialSources[material], list))
+            material++;
+        if (material == materialSources.size())
+        {
+            MaterialRecord record;
+            record.firstTexture = static_cast<uint32_t>(textures.size());
+            record.textureCount = static_cast<uint32_t>(list.size());
+            for (const Texture &texture : list)
+            {
+                TextureRecord entry;
+                entry.typeOffset = static_cast<uint32_t>(strings.size());
+                entry.typeLength = static_cast<uint32_t>(texture.type.size());
+                strings += texture.type;
+                entry.pathOffset = static_cast<uint32_t>(strings.size());
+                entry.pathLength = static_cast<uint32_t>(texture.path.size());
+                strings += texture.path;
+                textures.push_back(entry);
+            }
+            materials.push_back(record);
+            materialSources.push_back(&list);
+        }
+        meshes[i].material = material;
+        meshes[i].firstLod = static_cast<uint32_t>(lods.size());
+        meshes[i].lodCount = static_cast<uint32_t>(model.meshes[i].lods.size());
+        meshes[i].padding = 0;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            meshes[i].quantizationOffset[axis] = model.meshes[i].quantization.offset[axis];
+            meshes[i].quantizationScale[axis] = model.meshes[i].quantization.scale[axis];
+        }
+        lods.insert(lods.end(), model.meshes[i].lods.begin(), model.meshes[i].lods.end());
+    }
+
+    std::string animation = writeAnimation(model.animation);
+
+    MeshCacheHeader header;
+    std::memcpy(header.magic, "PMSH", 4);
+    header.version = MESH_CACHE_VERSION;
+    header.sourceKey = key;
+    header.vertexSize = sizeof(PackedVertex);
+    header.meshCount = static_cast<uint32_t>(meshes.size());
+    header.materialCount = static_cast<uint32_t>(materials.size());
+    header.textureCount = static_cast<uint32_t>(textures.size());
+    header.lodCount = static_cast<uint32_t>(lods.size());
+    header.padding = 0;
+    header.meshTable = alignMeshCache(sizeof(MeshCacheHeader));
+    header.materialTable = alignMeshCache(header.meshTable + meshes.size() * sizeof(MeshRecord));
+    header.textureTable = alignMeshCache(header.materialTable + materials.size() * sizeof(MaterialRecord));
+    header.lodTable = alignMeshCache(header.textureTable + textures.size() * sizeof(TextureRecord));
+    header.strings = alignMeshCache(header.lodTable + lods.size() * sizeof(MeshLod));
+    header.stringsSize = strings.size();
+    header.animation = alignMeshCache(header.strings + strings.size());
+    header.animationSize = animation.size();
+
+    uint64_t offset = alignMeshCache(header.animation + animation.size());
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        const MeshData &mesh = model.meshes[i];
+        meshes[i].vertexOffset = offset;
+        meshes[i].vertexCount = mesh.vertexCount;
+        offset = alignMeshCache(offset + mesh.vertexCount * sizeof(PackedVertex));
+        meshes[i].indexOffset = offset;
+        meshes[i].indexCount = mesh.indexCount;
+        meshes[i].lodIndexCount = mesh.lodIndexCount;
+        offset = alignMeshCache(offset + (mesh.indexCount + mesh.lodIndexCount) * sizeof(unsigned int));
+    }
+
+    std::string tempPath = cachePath + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+        uint64_t written = 0;
+        auto put = [&](uint64_t at, const void *data, size_t size) {
+            static const char zeros[16] = {};
+            file.write(zeros, static_cast<std::streamsize>(at - written));
+            file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+            written = at + size;
+        };
+        put(0, &header, sizeof(header));
+        put(header.meshTable, meshes.data(), meshes.size() * sizeof(MeshRecord));
+        put(header.materialTable, materials.data(), materials.size() * sizeof(MaterialRecord));
+        put(header.textureTable, textures.data(), textures.size() * sizeof(TextureRecord));
+        put(header.lodTable, lods.data(), lods.size() * sizeof(MeshLod));
+        put(header.strings, strings.data(), strings.size());
+        put(header.animation, animation.data(), animation.size());
+        for (size_t i = 0; i < meshes.size(); ++i)
+        {
+            const MeshData &mesh = model.meshes[i];
+            put(meshes[i].vertexOffset, mesh.vertexData, mesh.vertexCount * sizeof(PackedVertex));
+            put(meshes[i].indexOffset, mesh.indexData, mesh.indexCount * sizeof(unsigned int));
+            put(meshes[i].indexOffset + mesh.indexCount * sizeof(unsigned int), mesh.lodIndexData,
+                mesh.lodIndexCount * sizeof(unsigned int));
+        }
+        if (!file)
+            return false;
+    }
+    std::remove(cachePath.c_str()); // rename() doesn't replace on Windows
+    return std::rename(tempPath.c_str(), cachePath.c_str()) == 0;
+}
+
+// maps a cache and fills model with views into it; false if the file is missing, stale or damaged.
+// The mapping stays alive in model.mapping until the meshes have been uploaded.
+inline bool readMeshCache(const std::string &cachePath, uint64_t key, const std::string &sourcePath, ModelData &model)
+{
+    std::shared_ptr<MappedFile> mapping = std::make_shared<MappedFile>();
+    if (key == 0 || !mapping->open(cachePath) || mapping->size() < sizeof(MeshCacheHeader))
+        return false;
+
+    const unsigned char *base = mapping->data();
+    uint64_t size = mapping->size();
+    const MeshCacheHeader &header = *reinterpret_cast<const MeshCacheHeader *>(base);
+    if (std::memcmp(header.magic, "PMSH", 4) != 0 || header.version != MESH_CACHE_VERSION ||
+        header.sourceKey != key || header.vertexSize != sizeof(PackedVertex))
+        return false;
+
+    // every table and section has to lie inside the file before anything is dereferenced
+    auto inside = [size](uint64_t offset, uint64_t count, uint64_t elementSize) {
+        return offset <= size && count <= (size - offset) / elementSize;
+    };
+    if (!inside(header.meshTable, header.meshCount, sizeof(MeshRecord)) ||
+        !inside(header.materialTable, header.materialCount, sizeof(MaterialRecord)) ||
+        !inside(header.textureTable, header.textureCount, sizeof(TextureRecord)) ||
+        !inside(header.lodTable, header.lodCount, sizeof(MeshLod)) ||
+        !inside(header.strings, header.stringsSize, 1) || !inside(header.animation, header.animationSize, 1))
+        return false;
+
+    const MeshRecord *meshes = reinterpret_cast<const MeshRecord *>(base + header.meshTable);
+    const MaterialRecord *materials = reinterpret_cast<const MaterialRecord *>(base + header.materialTable);
+    const TextureRecord *textures = reinterpret_cast<const TextureRecord *>(base + header.textureTable);
+    const MeshLod *lods = reinterpret_cast<const MeshLod *>(base + header.lodTable);
+    const char *strings = reinterpret_cast<const char *>(base + header.strings);
+
+    ModelData result;
+    if (!readAnimation(base + header.animation, header.animationSize, result.animation))
+        return false;
+    result.meshes.resize(header.meshCount);
+    for (uint32_t i = 0; i < header.meshCount; ++i)
+    {
+        const MeshRecord &record = meshes[i];
+        if (!inside(record.vertexOffset, record.vertexCount, sizeof(PackedVertex)) ||
+            record.lodIndexCount > UINT64_MAX - record.indexCount ||
+            !inside(record.indexOffset, record.indexCount + record.lodIndexCount, sizeof(unsigned int)) ||
+            record.material >= header.materialCount || record.firstLod > header.lodCount ||
+            record.lodCount > header.lodCount - record.firstLod)
+            return false;
+        const MaterialRecord &material = materials[record.material];
+        if (material.firstTexture > header.textureCount || material.textureCount > header.textureCount - material.firstTexture)
+            return false;
+
+        MeshData &mesh = result.meshes[i];
+        mesh.vertexData = reinterpret_cast<const PackedVertex *>(base + record.vertexOffset);
+        mesh.vertexCount = static_cast<size_t>(record.vertexCount);
+        mesh.indexData = reinterpret_cast<const unsigned int *>(base + record.indexOffset);
+        mesh.indexCount = static_cast<size_t>(record.indexCount);
+        mesh.lodIndexData = mesh.indexData + mesh.indexCount;
+        mesh.lodIndexCount = static_cast<size_t>(record.lodIndexCount);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            mesh.quantization.offset[axis] = record.quantizationOffset[axis];
+            mesh.quantization.scale[axis] = record.quantizationScale[axis];
+        }
+        for (uint32_t l = 0; l < record.lodCount; ++l)
+        {
+            const MeshLod &lod = lods[record.firstLod + l];
+            if (lod.firstIndex < record.indexCount ||
+                uint64_t(lod.firstIndex) + lod.indexCount > record.indexCount + record.lodIndexCount)
+                return false;
+            mesh.lods.push_back(lod);
+        }
+        for (uint32_t t = 0; t < material.textureCount; ++t)
+        {
+            const TextureRecord &entry = textures[material.firstTexture + t];
+            if (uint64_t(entry.typeOffset) + entry.typeLength > header.stringsSize ||
+                uint64_t(entry.pathOffset) + entry.pathLength > header.stringsSize)
+                return false;
+            Texture texture;
+            texture.id = 0;
+            texture.type.assign(strings + entry.typeOffset, entry.typeLength);
+            texture.path.assign(strings + entry.pathOffset, entry.pathLength);
+            mesh.textures.push_back(texture);
+        }
+    }
+
+    result.directory = sourcePath.substr(0, sourcePath.find_last_of('/'));
+    result.mapping = mapping;
+    result.loaded = true;
+    model = std::move(result);
+    return true;
+}
+
+// cache first, Assimp on a miss; a fresh parse is written back so the next launch maps it
+inline ModelData loadModelData(const std::string &sourcePath)
+{
+    uint64_t key = meshCacheKey(sourcePath);
+    std::string cachePath = meshCachePath(sourcePath);
+    ModelData model;
+    if (readMeshCache(cachePath, key, sourcePath, model))
+        return model;
+
+    model = parseModel(sourcePath);
+    if (model.loaded && key != 0 && !writeMeshCache(cachePath, key, model))
+        std::cout << "Mesh cache could not be written: " << cachePath << std::endl;
+    return model;
+}
+
+#endif
@@ -0,0 +1,419 @@
+#ifndef MESH_LOD_H
+#define MESH_LOD_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+// Mesh LOD: simplified index lists generated at import time with quadric edge collapses (Garland &
+// Heckbert), and a per-instance choice between them from the model's size on screen.
+//
+// The simplifier only moves vertices onto existing neighbours (half-edge collapses), so a LOD is just
+// another index list over the same vertices: no extra vertex data, and every level can be drawn from the
+// same vertex range with a different index range. Vertices on open borders, UV/normal seams (one position,
+// several vertices) and non-manifold edges never move, which keeps the silhouette and texture seams.
+
+// the full mesh plus three simplified levels at 1/2, 1/4 and 1/8 of its triangles
+const int MESH_LOD_LEVELS = 4;
+const float MESH_LOD_RATIOS[MESH_LOD_LEVELS] = { 1.0f, 0.5f, 0.25f, 0.125f };
+
+// one simplified level; firstIndex counts from the start of the mesh's index list, in which the levels
+// follow the full-detail indices
+struct MeshLod
+{
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    float error = 0.0f; // largest collapse error so far, in model units (distance to the original surface)
+};
+
+// symmetric 4x4 error quadric: sum of squared distances to a set of planes
+struct Quadric
+{
+    double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+
+    static Quadric plane(const glm::vec3 &normal, float distance)
+    {
+        Quadric q;
+        double a = normal.x, b = normal.y, c = normal.z, d = distance;
+        q.a2 = a * a; q.ab = a * b; q.ac = a * c; q.ad = a * d;
+        q.b2 = b * b; q.bc = b * c; q.bd = b * d;
+        q.c2 = c * c; q.cd = c * d;
+        q.d2 = d * d;
+        return q;
+    }
+
+    Quadric &operator+=(const Quadric &q)
+    {
+        a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad; b2 += q.b2;
+        bc += q.bc; bd += q.bd; c2 += q.c2; cd += q.cd; d2 += q.d2;
+        return *this;
+    }
+
+    double evaluate(const glm::vec3 &p) const
+    {
+        double x = p.x, y = p.y, z = p.z;
+        double result = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x + b2 * y * y + 2 * bc * y * z +
+                        2 * bd * y + c2 * z * z + 2 * cd * z + d2;
+        return std::max(result, 0.0);
+    }
+};
+
+class MeshSimplifier
+{
+public:
+    MeshSimplifier(const Vertex *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount)
+        : vertices(vertices), vertexCount(vertexCount)
+    {
+        weldPositions();
+
+        // degenerate input triangles carry no area and would only confuse the adjacency
+        for (size_t i = 0; i + 2 < indexCount; i += 3)
+        {
+            Triangle t = { { indices[i], indices[i + 1], indices[i + 2] }, true };
+            if (position[t.v[0]] == position[t.v[1]] || position[t.v[1]] == position[t.v[2]] ||
+                position[t.v[0]] == position[t.v[2]])
+                continue;
+            triangles.push_back(t);
+        }
+        liveTriangles = triangles.size();
+
+        vertexTriangles.resize(vertexCount);
+        quadrics.resize(positionCount);
+        for (uint32_t t = 0; t < triangles.size(); ++t)
+        {
+            const Triangle &triangle = triangles[t];
+            const glm::vec3 &p0 = vertices[triangle.v[0]].Position;
+            const glm::vec3 &p1 = vertices[triangle.v[1]].Position;
+            const glm::vec3 &p2 = vertices[triangle.v[2]].Position;
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            float length = glm::length(normal);
+            if (length > 0.0f)
+                normal = normal * (1.0f / length);
+            Quadric q = Quadric::plane(normal, -glm::dot(normal, p0));
+            for (uint32_t v : triangle.v)
+            {
+                vertexTriangles[v].push_back(t);
+                quadrics[position[v]] += q;
+            }
+        }
+
+        lockBordersAndSeams();
+        version.assign(vertexCount, 0);
+        for (uint32_t t = 0; t < triangles.size(); ++t)
+            for (int e = 0; e < 3; ++e)
+                pushEdge(triangles[t].v[e], triangles[t].v[(e + 1) % 3]);
+    }
+
+    // collapses the cheapest edges until at most targetIndexCount indices are left, or nothing else can go
+    void simplify(size_t targetIndexCount)
+    {
+        while (liveTriangles * 3 > targetIndexCount && !heap.empty())
+        {
+            Candidate candidate = heap.top();
+            heap.pop();
+            if (candidate.fromVersion != version[candidate.from] || candidate.toVersion != version[candidate.to])
+                continue;
+            if (!canCollapse(candidate.from, candidate.to))
+                continue;
+            collapse(candidate.from, candidate.to);
+            maxError = std::max(maxError, static_cast<float>(std::sqrt(candidate.cost)));
+        }
+    }
+
+    void appendIndices(std::vector<unsigned int> &out) const
+    {
+        for (const Triangle &triangle : triangles)
+            if (triangle.alive)
+                out.insert(out.end(), triangle.v, triangle.v + 3);
+    }
+
+    size_t indexCount() const { return liveTriangles * 3; }
+    float error() const { return maxError; }
+
+private:
+    struct Triangle
+    {
+        uint32_t v[3];
+        bool alive;
+    };
+
+    struct Candidate
+    {
+        double cost;
+        uint32_t from, to;
+        uint32_t fromVersion, toVersion;
+
+        bool operator>(const Candidate &other) const { return cost > other.cost; }
+    };
+
+    const Vertex *vertices;
+    size_t vertexCount;
+    std::vector<uint32_t> position; // vertex -> welded position id
+    size_t positionCount = 0;
+    std::vector<bool> locked;       // per position
+    std::vector<Triangle> triangles;
+    size_t liveTriangles = 0;
+    std::vector<std::vector<uint32_t>> vertexTriangles;
+    std::vector<Quadric> quadrics;  // per position
+    std::vector<uint32_t> version;  // bumped whenever a vertex's quadric or triangles change
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> heap;
+    float maxError = 0.0f;
+
+    struct PositionKey
+    {
+        float x, y, z;
+        bool operator==(const PositionKey &o) const { return std::memcmp(this, &o, sizeof(PositionKey)) == 0; }
+    };
+
+    struct PositionHash
+    {
+        size_t operator()(const PositionKey &key) const
+        {
+            uint32_t bits[3];
+            std::memcpy(bits, &key, sizeof(bits));
+            return (size_t(bits[0]) * 73856093u) ^ (size_t(bits[1]) * 19349663u) ^ (size_t(bits[2]) * 83492791u);
+        }
+    };
+
+    void weldPositions()
+    {
+        std::unordered_map<PositionKey, uint32_t, PositionHash> ids;
+        position.resize(vertexCount);
+        std::vector<uint32_t> verticesAtPosition;
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            const glm::vec3 &p = vertices[v].Position;
+            auto id = ids.emplace(PositionKey{ p.x, p.y, p.z }, static_cast<uint32_t>(ids.size())).first->second;
+            position[v] = id;
+            if (id == verticesAtPosition.size())
+                verticesAtPosition.push_back(0);
+            verticesAtPosition[id]++;
+        }
+        positionCount = ids.size();
+        // a position shared by several vertices is a seam
+        locked.assign(positionCount, false);
+        for (size_t p = 0; p < positionCount; ++p)
+            locked[p] = verticesAtPosition[p] > 1;
+    }
+
+    void lockBordersAndSeams()
+    {
+        // an edge used by anything but two triangles is a border or non-manifold
+        std::unordered_map<uint64_t, int> edgeUse;
+        auto key = [](uint32_t a, uint32_t b) { return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a; };
+        for (const Triangle &triangle : triangles)
+            for (int e = 0; e < 3; ++e)
+                edgeUse[key(position[triangle.v[e]], position[triangle.v[(e + 1) % 3]])]++;
+        for (const auto &edge : edgeUse)
+        {
+            if (edge.second != 2)
+            {
+                locked[uint32_t(edge.first >> 32)] = true;
+                locked[uint32_t(edge.first & 0xffffffffu)] = true;
+            }
+        }
+    }
+
+    void pushEdge(uint32_t a, uint32_t b)
+    {
+        Quadric q;
+        if (!locked[position[a]])
+        {
+            q = quadrics[position[a]];
+            q += quadrics[position[b]];
+            heap.push(Candidate{ q.evaluate(vertices[b].Position), a, b, version[a], version[b] });
+        }
+        if (!locked[position[b]])
+        {
+            q = quadrics[position[b]];
+            q += quadrics[position[a]];
+            heap.push(Candidate{ q.evaluate(vertices[a].Position), b, a, version[b], version[a] });
+        }
+    }
+
+    bool contains(const Triangle &triangle, uint32_t v) const
+    {
+        return triangle.v[0] == v || triangle.v[1] == v || triangle.v[2] == v;
+    }
+
+    bool canCollapse(uint32_t from, uint32_t to) const
+    {
+        // link condition: the two ends may only share the neighbours of the triangles on the edge,
+        // otherwise the collapse pinches the surface
+        std::vector<uint32_t> fromNeighbours, toNeighbours;
+        int shared = 0;
+        for (uint32_t t : vertexTriangles[from])
+        {
+            const Triangle &triangle = triangles[t];
+            if (!triangle.alive)
+                continue;
+            if (contains(triangle, to))
+                shared++;
+            for (uint32_t v : triangle.v)
+                if (v != from && v != to)
+                    fromNeighbours.push_back(position[v]);
+        }
+        if (shared == 0)
+            return false; // no longer an edge
+        for (uint32_t t : vertexTriangles[to])
+        {
+            const Triangle &triangle = triangles[t];
+            if (!triangle.alive)
+                continue;
+            for (uint32_t v : triangle.v)
+                if (v != from && v != to)
+                    toNeighbours.push_back(position[v]);
+        }
+        std::sort(fromNeighbours.begin(), fromNeighbours.end());
+        fromNeighbours.erase(std::unique(fromNeighbours.begin(), fromNeighbours.end()), fromNeighbours.end());
+        std::sort(toNeighbours.begin(), toNeighbours.end());
+        toNeighbours.erase(std::unique(toNeighbours.begin(), toNeighbours.end()), toNeighbours.end());
+        std::vector<uint32_t> common;
+        std::set_intersection(fromNeighbours.begin(), fromNeighbours.end(), toNeighbours.begin(), toNeighbours.end(),
+                              std::back_inserter(common));
+        if (common.size() != static_cast<size_t>(shared))
+            return false;
+
+        // no triangle around from may flip or collapse to a sliver when from moves onto to
+        const glm::vec3 &target = vertices[to].Position;
+        for (uint32_t t : vertexTriangles[from])
+        {
+            const Triangle &triangle = triangles[t];
+            if (!triangle.alive || contains(triangle, to))
+                continue;
+            glm::vec3 p[3], q[3];
+            for (int i = 0; i < 3; ++i)
+            {
+                p[i] = vertices[triangle.v[i]].Position;
+                q[i] = triangle.v[i] == from ? target : p[i];
+            }
+            glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+            glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+            float beforeLength = glm::length(before), afterLength = glm::length(after);
+            if (afterLength <= 1e-12f || glm::dot(before, after) < 0.25f * beforeLength * afterLength)
+                return false;
+        }
+        return true;
+    }
+
+    void collapse(uint32_t from, uint32_t to)
+    {
+        for (uint32_t t : vertexTriangles[from])
+        {
+            Triangle &triangle = triangles[t];
+            if (!triangle.alive)
+                continue;
+            if (contains(triangle, to))
+            {
+                triangle.alive = false;
+                liveTriangles--;
+                continue;
+            }
+            for (uint32_t &v : triangle.v)
+                if (v == from)
+                    v = to;
+            vertexTriangles[to].push_back(t);
+        }
+        vertexTriangles[from].clear();
+        quadrics[position[to]] += quadrics[position[from]];
+        version[from]++;
+        version[to]++;
+
+        // every edge at to has a new cost now
+        for (uint32_t t : vertexTriangles[to])
+        {
+            const Triangle &triangle = triangles[t];
+            if (!triangle.alive)
+                continue;
+            for (uint32_t v : triangle.v)
+                if (v != to)
+                    pushEdge(to, v);
+        }
+    }
+};
+
+// appends MESH_LOD_LEVELS - 1 simplified index lists to lodIndices; every level continues from the one
+// before, so their errors only grow
+inline void buildMeshLods(const Vertex *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount,
+                          std::vector<unsigned int> &lodIndices, std::vector<MeshLod> &lods)
+{
+    MeshSimplifier simplifier(vertices, vertexCount, indices, indexCount);
+    for (int level = 1; level < MESH_LOD_LEVELS; ++level)
+    {
+        size_t target = static_cast<size_t>(indexCount / 3 * MESH_LOD_RATIOS[level]) * 3;
+        simplifier.simplify(target);
+        MeshLod lod;
+        lod.firstIndex = static_cast<uint32_t>(indexCount + lodIndices.size());
+        lod.indexCount = static_cast<uint32_t>(simplifier.indexCount());
+        lod.error = simplifier.error();
+        simplifier.appendIndices(lodIndices);
+        lods.push_back(lod);
+    }
+}
+
+// picks a level per instance of one model. A level is good enough while its error covers less than
+// maxPixelError pixels, i.e. while the model is smaller on screen than diameter / error * maxPixelError.
+// A switch has to cross that limit by the hysteresis fraction, so instances near a limit don't flicker
+// between two levels.
+class LodSelector
+{
+public:
+    LodSelector(float maxPixelError = 1.0f, float hysteresis = 0.2f)
+        : maxPixelError(maxPixelError), hysteresis(hysteresis)
+    {
+    }
+
+    // errors[level] of the whole model (level 0 is exact), radius of its bounds; both in model units
+    void setModel(const std::vector<float> &errors, float radius)
+    {
+        sizeLimits.clear();
+        for (float error : errors)
+            sizeLimits.push_back(error > 0.0f ? maxPixelError * 2.0f * radius / error : std::numeric_limits<float>::max());
+        this->radius = radius;
+    }
+
+    // on-screen diameter in pixels of a model scaled by scale at distance, for a vertical fov in radians
+    float screenSize(float distance, float scale, float fovY, float viewportHeight) const
+    {
+        float projected = 2.0f * radius * scale / (std::max(distance, 1e-4f) * 2.0f * std::tan(fovY * 0.5f));
+        return projected * viewportHeight;
+    }
+
+    // level for one instance; instance ids must stay stable from frame to frame
+    int select(size_t instance, float screenSize)
+    {
+        if (instance >= current.size())
+            current.resize(instance + 1, 0);
+        int level = current[instance];
+        int last = static_cast<int>(sizeLimits.size()) - 1;
+        while (level < last && screenSize < sizeLimits[level + 1] * (1.0f - hysteresis))
+            level++;
+        while (level > 0 && screenSize > sizeLimits[level] * (1.0f + hysteresis))
+            level--;
+        current[instance] = level;
+        return level;
+    }
+
+    int levels() const { return static_cast<int>(sizeLimits.size()); }
+
+private:
+    float maxPixelError;
+    float hysteresis;
+    float radius = 1.0f;
+    std::vector<float> sizeLimits; // largest screen size each level may be drawn at
+    std::vector<int> current;
+};
+
+#endif
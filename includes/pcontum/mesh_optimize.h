@@ -0,0 +1,311 @@
+#ifndef MESH_OPTIMIZE_H
+#define MESH_OPTIMIZE_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Import-time reordering so the GPU does less work for the same triangles.
+//   optimizeVertexCache - triangle order for the post-transform cache (Forsyth's linear-speed greedy
+//                         scoring), so a vertex shaded once is reused by its neighbours
+//   optimizeOverdraw    - splits that order into pieces that cost few extra cache misses and sorts them
+//                         outside first (Sander et al.), so the depth test rejects more of what is behind
+//   optimizeVertexFetch - renumbers vertices in first-use order, so fetches walk the buffer forward
+// All of them only permute; the triangles and their winding stay as they are.
+
+// size the scoring assumes; larger than real FIFO caches, which the LRU model approximates well enough
+const int VERTEX_CACHE_SCORE_SIZE = 32;
+// FIFO size used to measure the result and to find the overdraw cluster boundaries
+const int VERTEX_CACHE_FIFO_SIZE = 16;
+
+// average cache misses per triangle with a FIFO cache (ACMR); 0.5 is about the best a regular grid gets,
+// 3 means no reuse at all
+inline float vertexCacheMissRatio(const unsigned int *indices, size_t indexCount, size_t vertexCount,
+                                  int cacheSize = VERTEX_CACHE_FIFO_SIZE)
+{
+    if (indexCount < 3)
+        return 0.0f;
+    // a vertex is in the cache while fewer than cacheSize misses happened after its own
+    std::vector<size_t> loadedAt(vertexCount, 0);
+    size_t misses = 0;
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        unsigned int vertex = indices[i];
+        if (loadedAt[vertex] == 0 || misses - loadedAt[vertex] >= static_cast<size_t>(cacheSize))
+            loadedAt[vertex] = ++misses;
+    }
+    return static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+}
+
+inline float forsythVertexScore(int cachePosition, unsigned int remainingTriangles)
+{
+    if (remainingTriangles == 0)
+        return -1.0f;
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // the last triangle's vertices get a fixed score so it isn't simply repeated
+        if (cachePosition < 3)
+            score = 0.75f;
+        else
+            score = std::pow(1.0f - static_cast<float>(cachePosition - 3) / (VERTEX_CACHE_SCORE_SIZE - 3), 1.5f);
+    }
+    // vertices with few triangles left are finished first, so they don't get stranded
+    return score + 2.0f / std::sqrt(static_cast<float>(remainingTriangles));
+}
+
+// reorders the triangles of indices in place
+inline void optimizeVertexCache(unsigned int *indices, size_t indexCount, size_t vertexCount)
+{
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2)
+        return;
+
+    // triangles of every vertex; the first remaining[v] entries are the ones not emitted yet
+    std::vector<unsigned int> firstTriangle(vertexCount + 1, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+        firstTriangle[indices[i] + 1]++;
+    for (size_t v = 0; v < vertexCount; ++v)
+        firstTriangle[v + 1] += firstTriangle[v];
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    std::vector<unsigned int> adjacency(triangleCount * 3);
+    for (size_t t = 0; t < triangleCount; ++t)
+        for (int k = 0; k < 3; ++k)
+        {
+            unsigned int v = indices[t * 3 + k];
+            adjacency[firstTriangle[v] + remaining[v]++] = static_cast<unsigned int>(t);
+        }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+        vertexScore[v] = forsythVertexScore(-1, remaining[v]);
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (size_t t = 0; t < triangleCount; ++t)
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+
+    std::vector<unsigned int> cache, nextCache;
+    cache.reserve(VERTEX_CACHE_SCORE_SIZE + 3);
+    nextCache.reserve(VERTEX_CACHE_SCORE_SIZE + 3);
+    std::vector<unsigned int> result;
+    result.reserve(triangleCount * 3);
+
+    size_t scanCursor = 0;
+    long best = -1;
+    float bestScore = -1.0f;
+    for (size_t t = 0; t < triangleCount; ++t)
+        if (triangleScore[t] > bestScore)
+        {
+            bestScore = triangleScore[t];
+            best = static_cast<long>(t);
+        }
+
+    while (best >= 0)
+    {
+        size_t triangle = static_cast<size_t>(best);
+        emitted[triangle] = true;
+        const unsigned int *corners = indices + triangle * 3;
+        for (int k = 0; k < 3; ++k)
+        {
+            unsigned int v = corners[k];
+            result.push_back(v);
+            unsigned int *list = &adjacency[firstTriangle[v]];
+            unsigned int *end = list + remaining[v];
+            std::iter_swap(std::find(list, end, static_cast<unsigned int>(triangle)), end - 1);
+            remaining[v]--;
+        }
+
+        // most recently used first; what falls off the end has left the cache
+        nextCache.assign(corners, corners + 3);
+        for (unsigned int v : cache)
+            if (v != corners[0] && v != corners[1] && v != corners[2])
+                nextCache.push_back(v);
+        for (size_t i = 0; i < nextCache.size(); ++i)
+            cachePosition[nextCache[i]] = i < static_cast<size_t>(VERTEX_CACHE_SCORE_SIZE) ? static_cast<int>(i) : -1;
+
+        // only triangles around vertices whose score changed can become the next best
+        best = -1;
+        bestScore = -1.0f;
+        for (unsigned int v : nextCache)
+            vertexScore[v] = forsythVertexScore(cachePosition[v], remaining[v]);
+        for (unsigned int v : nextCache)
+        {
+            for (unsigned int i = 0; i < remaining[v]; ++i)
+            {
+                unsigned int t = adjacency[firstTriangle[v] + i];
+                float score = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+                triangleScore[t] = score;
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    best = static_cast<long>(t);
+                }
+            }
+        }
+        if (nextCache.size() > static_cast<size_t>(VERTEX_CACHE_SCORE_SIZE))
+            nextCache.resize(VERTEX_CACHE_SCORE_SIZE);
+        cache.swap(nextCache);
+
+        // nothing left around the cache: continue with the next unfinished triangle in input order
+        if (best < 0)
+        {
+            while (scanCursor < triangleCount && emitted[scanCursor])
+                scanCursor++;
+            if (scanCursor < triangleCount)
+                best = static_cast<long>(scanCursor);
+        }
+    }
+    std::copy(result.begin(), result.end(), indices);
+}
+
+// reorders clusters of a cache-optimized triangle list so the outward-facing ones come first. Clusters
+// start where a triangle misses the cache with all three vertices, which costs nothing, and are cut again
+// as soon as a piece gets within threshold of its cluster's miss ratio, which bounds what the split
+// costs in extra misses.
+inline void optimizeOverdraw(unsigned int *indices, size_t indexCount, const Vertex *vertices, size_t vertexCount,
+                             float threshold = 1.05f)
+{
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2)
+        return;
+
+    // FIFO cache as in vertexCacheMissRatio(); moving the clock a cache size ahead empties it
+    std::vector<size_t> loadedAt(vertexCount, 0);
+    size_t clock = 0;
+    auto triangleMisses = [&](size_t triangle) {
+        int misses = 0;
+        for (int k = 0; k < 3; ++k)
+        {
+            unsigned int v = indices[triangle * 3 + k];
+            if (loadedAt[v] == 0 || clock - loadedAt[v] >= static_cast<size_t>(VERTEX_CACHE_FIFO_SIZE))
+            {
+                loadedAt[v] = ++clock;
+                misses++;
+            }
+        }
+        return misses;
+    };
+
+    std::vector<size_t> hardStart;
+    for (size_t t = 0; t < triangleCount; ++t)
+        if (triangleMisses(t) == 3 || t == 0)
+            hardStart.push_back(t);
+    hardStart.push_back(triangleCount);
+
+    std::vector<size_t> clusterStart;
+    for (size_t h = 0; h + 1 < hardStart.size(); ++h)
+    {
+        size_t begin = hardStart[h], end = hardStart[h + 1];
+        clock += VERTEX_CACHE_FIFO_SIZE;
+        size_t clusterMisses = 0;
+        for (size_t t = begin; t < end; ++t)
+            clusterMisses += triangleMisses(t);
+        float target = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - begin);
+
+        clock += VERTEX_CACHE_FIFO_SIZE;
+        clusterStart.push_back(begin);
+        size_t runMisses = 0, runTriangles = 0;
+        for (size_t t = begin; t + 1 < end; ++t)
+        {
+            runMisses += triangleMisses(t);
+            runTriangles++;
+            if (static_cast<float>(runMisses) <= target * static_cast<float>(runTriangles))
+            {
+                clusterStart.push_back(t + 1);
+                clock += VERTEX_CACHE_FIFO_SIZE;
+                runMisses = runTriangles = 0;
+            }
+        }
+    }
+    if (clusterStart.size() < 2)
+        return;
+    clusterStart.push_back(triangleCount);
+
+    struct Cluster
+    {
+        size_t first;
+        size_t count;
+        glm::vec3 centroid;
+        glm::vec3 normal;
+        float sortKey;
+    };
+    std::vector<Cluster> clusters(clusterStart.size() - 1);
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (size_t c = 0; c < clusters.size(); ++c)
+    {
+        Cluster &cluster = clusters[c];
+        cluster.first = clusterStart[c];
+        cluster.count = clusterStart[c + 1] - clusterStart[c];
+        cluster.centroid = glm::vec3(0.0f);
+        cluster.normal = glm::vec3(0.0f);
+        float area = 0.0f;
+        for (size_t t = cluster.first; t < cluster.first + cluster.count; ++t)
+        {
+            const glm::vec3 &a = vertices[indices[t * 3]].Position;
+            const glm::vec3 &b = vertices[indices[t * 3 + 1]].Position;
+            const glm::vec3 &p = vertices[indices[t * 3 + 2]].Position;
+            glm::vec3 cross = glm::cross(b - a, p - a); // length is twice the area
+            float triangleArea = glm::length(cross);
+            cluster.normal += cross;
+            cluster.centroid += (a + b + p) * (triangleArea / 3.0f);
+            area += triangleArea;
+        }
+        meshCentroid += cluster.centroid;
+        meshArea += area;
+        if (area > 0.0f)
+            cluster.centroid = cluster.centroid * (1.0f / area);
+    }
+    if (meshArea <= 0.0f)
+        return;
+    meshCentroid = meshCentroid * (1.0f / meshArea);
+
+    // how far the cluster faces away from the middle of the mesh: those are seen first from outside
+    for (Cluster &cluster : clusters)
+    {
+        float length = glm::length(cluster.normal);
+        cluster.sortKey = length > 0.0f ? glm::dot(cluster.centroid - meshCentroid, cluster.normal * (1.0f / length)) : 0.0f;
+    }
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster &a, const Cluster &b) {
+        return a.sortKey > b.sortKey;
+    });
+
+    std::vector<unsigned int> result;
+    result.reserve(triangleCount * 3);
+    for (const Cluster &cluster : clusters)
+        result.insert(result.end(), indices + cluster.first * 3, indices + (cluster.first + cluster.count) * 3);
+    std::copy(result.begin(), result.end(), indices);
+}
+
+// renumbers vertices in the order the index lists first use them (indices, then lodIndices) and drops
+// the ones nothing uses
+inline void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices,
+                                std::vector<unsigned int> &lodIndices)
+{
+    const unsigned int unused = ~0u;
+    std::vector<unsigned int> remap(vertices.size(), unused);
+    std::vector<Vertex> ordered;
+    ordered.reserve(vertices.size());
+    for (std::vector<unsigned int> *list : { &indices, &lodIndices })
+    {
+        for (unsigned int &index : *list)
+        {
+            if (remap[index] == unused)
+            {
+                remap[index] = static_cast<unsigned int>(ordered.size());
+                ordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+    }
+    vertices.swap(ordered);
+}
+
+#endif
@@ -0,0 +1,344 @@
+#ifndef MODEL_DATA_H
+#define MODEL_DATA_H
+
+#include <glm/glm.hpp>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include <learnopengl/mesh.h>
+
+#include <pcontum/mapped_file.h>
+#include <pcontum/culling.h>
+#include <pcontum/mesh_lod.h>
+#include <pcontum/mesh_optimize.h>
+#include <pcontum/skeletal_animation.h>
+#include <pcontum/vertex_format.h>
+
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// CPU side of a model: what learnopengl's Model::loadModel() extracts from Assimp, without any GL calls,
+// so it can be produced on a worker thread or read back from a mesh cache.
+
+// everything Assimp produced for one mesh, no GL yet; texture ids are filled in on the main thread.
+// vertexData/indexData are what gets uploaded: they point into the vectors after a parse, or straight
+// into the mapped mesh cache, in which case the vectors stay empty. The simplified levels (see
+// mesh_lod.h) are a second index list over the same vertices; it is uploaded right after the full mesh.
+// Vertices are already in the compact GPU format (vertex_format.h); quantization maps them back.
+struct MeshData
+{
+    std::vector<PackedVertex> vertices;
+    std::vector<unsigned int> indices;
+    std::vector<unsigned int> lodIndices;
+    std::vector<Texture> textures;
+    std::vector<MeshLod> lods;
+    VertexQuantization quantization;
+
+    const PackedVertex *vertexData = nullptr;
+    size_t vertexCount = 0;
+    const unsigned int *indexData = nullptr;
+    size_t indexCount = 0;
+    const unsigned int *lodIndexData = nullptr;
+    size_t lodIndexCount = 0;
+};
+
+struct ModelData
+{
+    bool loaded = false;
+    std::string directory;
+    std::vector<MeshData> meshes;
+    ModelAnimation animation; // empty for a static model
+    std::shared_ptr<MappedFile> mapping; // keeps a mesh cache mapped while its meshes are uploaded
+
+    // points the upload views at the owned vectors
+    void useOwnedData()
+    {
+        for (MeshData &mesh : meshes)
+        {
+            mesh.vertexData = mesh.vertices.data();
+            mesh.vertexCount = mesh.vertices.size();
+            mesh.indexData = mesh.indices.data();
+            mesh.indexCount = mesh.indices.size();
+            mesh.lodIndexData = mesh.lodIndices.data();
+            mesh.lodIndexCount = mesh.lodIndices.size();
+        }
+    }
+};
+
+inline void appendMaterialTextures(std::vector<Texture> &textures, aiMaterial *mat, aiTextureType type, const std::string &typeName)
+{
+    for (unsigned int i = 0; i < mat->GetTextureCount(type); i++)
+    {
+        aiString str;
+        mat->GetTexture(type, i, &str);
+        Texture texture;
+        texture.id = 0;
+        texture.type = typeName;
+        texture.path = str.C_Str();
+        textures.push_back(texture);
+    }
+}
+
+// import-time preparation of a parsed mesh: triangle order for the vertex cache and for overdraw, the
+// simplified levels, vertex order for fetch locality, and finally the compact vertex format
+inline void prepareMesh(std::vector<Vertex> &vertices, MeshData &data)
+{
+    optimizeVertexCache(data.indices.data(), data.indices.size(), vertices.size());
+    optimizeOverdraw(data.indices.data(), data.indices.size(), vertices.data(), vertices.size());
+    buildMeshLods(vertices.data(), vertices.size(), data.indices.data(), data.indices.size(), data.lodIndices, data.lods);
+    // the simplifier keeps the order of the surviving triangles, which the collapses have broken up
+    for (const MeshLod &lod : data.lods)
+        optimizeVertexCache(data.lodIndices.data() + (lod.firstIndex - data.indices.size()), lod.indexCount, vertices.size());
+    optimizeVertexFetch(vertices, data.indices, data.lodIndices);
+
+    data.quantization = VertexQuantization::fromBounds(boundsOf(vertices.data(), vertices.size()));
+    data.vertices.resize(vertices.size());
+    packVertices(vertices.data(), vertices.size(), data.quantization, data.vertices.data());
+}
+
+inline glm::mat4 toGlm(const aiMatrix4x4 &m)
+{
+    // Assimp's matrices are row-major
+    return glm::mat4(glm::vec4(m.a1, m.b1, m.c1, m.d1), glm::vec4(m.a2, m.b2, m.c2, m.d2),
+                     glm::vec4(m.a3, m.b3, m.c3, m.d3), glm::vec4(m.a4, m.b4, m.c4, m.d4));
+}
+
+// a node transform as the Pose components; shear is not representable and dropped
+inline void decomposeJoint(const glm::mat4 &m, glm::vec4 &translation, glm::vec4 &rotation, glm::vec4 &scale)
+{
+    translation = glm::vec4(glm::vec3(m[3]), 0.0f);
+    glm::vec3 axes[3] = { glm::vec3(m[0]), glm::vec3(m[1]), glm::vec3(m[2]) };
+    glm::vec3 size(glm::length(axes[0]), glm::length(axes[1]), glm::length(axes[2]));
+    if (glm::dot(glm::cross(axes[0], axes[1]), axes[2]) < 0.0f)
+        size.x = -size.x;
+    for (int axis = 0; axis < 3; ++axis)
+        if (size[axis] != 0.0f)
+            axes[axis] /= size[axis];
+    glm::quat q = glm::normalize(glm::quat_cast(glm::mat3(axes[0], axes[1], axes[2])));
+    rotation = glm::vec4(q.x, q.y, q.z, q.w);
+    scale = glm::vec4(size, 0.0f);
+}
+
+// true if node or anything below it is a bone; those nodes make up the skeleton
+inline bool hasBoneBelow(const aiNode *node, const std::unordered_map<std::string, glm::mat4> &bones)
+{
+    if (bones.count(node->mName.C_Str()))
+        return true;
+    for (unsigned int i = 0; i < node->mNumChildren; i++)
+        if (hasBoneBelow(node->mChildren[i], bones))
+            return true;
+    return false;
+}
+
+inline void appendJoints(const aiNode *node, int parent, const std::unordered_map<std::string, glm::mat4> &bones, Skeleton &skeleton)
+{
+    if (!hasBoneBelow(node, bones))
+        return;
+    int index = static_cast<int>(skeleton.size());
+    auto bone = bones.find(node->mName.C_Str());
+    skeleton.names.push_back(node->mName.C_Str());
+    skeleton.parents.push_back(parent);
+    skeleton.offsets.push_back(bone != bones.end() ? bone->second : glm::mat4(1.0f));
+    skeleton.bindPose.resize(skeleton.size());
+    decomposeJoint(toGlm(node->mTransformation), skeleton.bindPose.translations.back(), skeleton.bindPose.rotations.back(),
+                   skeleton.bindPose.scales.back());
+    for (unsigned int i = 0; i < node->mNumChildren; i++)
+        appendJoints(node->mChildren[i], index, bones, skeleton);
+}
+
+// the bones of every mesh and the nodes between them and the root, depth first, so parents come before
+// their children. Empty when the model has no bones or more joints than a vertex can address.
+inline Skeleton parseSkeleton(const aiScene *scene)
+{
+    std::unordered_map<std::string, glm::mat4> bones;
+    for (unsigned int m = 0; m < scene->mNumMeshes; m++)
+        for (unsigned int b = 0; b < scene->mMeshes[m]->mNumBones; b++)
+            bones[scene->mMeshes[m]->mBones[b]->mName.C_Str()] = toGlm(scene->mMeshes[m]->mBones[b]->mOffsetMatrix);
+
+    Skeleton skeleton;
+    if (bones.empty())
+        return skeleton;
+    appendJoints(scene->mRootNode, -1, bones, skeleton);
+    if (skeleton.size() > MAX_SKELETON_JOINTS)
+    {
+        std::cout << "ERROR::SKELETON:: " << skeleton.size() << " joints, at most " << MAX_SKELETON_JOINTS
+                  << " fit in a vertex; the model stays static" << std::endl;
+        return Skeleton();
+    }
+    skeleton.globalInverse = glm::inverse(toGlm(scene->mRootNode->mTransformation));
+    return skeleton;
+}
+
+// every animation's channels on skeleton joints, times converted from ticks to seconds. Channels of
+// nodes outside the skeleton (rigid node animation) are dropped.
+inline std::vector<AnimationClip> parseAnimations(const aiScene *scene, const Skeleton &skeleton)
+{
+    std::vector<AnimationClip> clips;
+    if (skeleton.empty())
+        return clips;
+    for (unsigned int a = 0; a < scene->mNumAnimations; a++)
+    {
+        const aiAnimation *animation = scene->mAnimations[a];
+        double ticksPerSecond = animation->mTicksPerSecond != 0.0 ? animation->mTicksPerSecond : 25.0;
+        AnimationClip clip;
+        clip.name = animation->mName.C_Str();
+        clip.duration = static_cast<float>(animation->mDuration / ticksPerSecond);
+        for (unsigned int c = 0; c < animation->mNumChannels; c++)
+        {
+            const aiNodeAnim *channel = animation->mChannels[c];
+            int joint = skeleton.find(channel->mNodeName.C_Str());
+            if (joint < 0)
+                continue;
+            AnimationTrack track;
+            track.joint = static_cast<uint32_t>(joint);
+            auto appendKey = [&](double time, const glm::vec4 &value) {
+                clip.keyTimes.push_back(static_cast<float>(time / ticksPerSecond));
+                clip.keyValues.push_back(value);
+            };
+            track.channels[ANIMATION_TRANSLATION].firstKey = static_cast<uint32_t>(clip.keyTimes.size());
+            track.channels[ANIMATION_TRANSLATION].keyCount = channel->mNumPositionKeys;
+            for (unsigned int k = 0; k < channel->mNumPositionKeys; k++)
+            {
+                const aiVector3D &v = channel->mPositionKeys[k].mValue;
+                appendKey(channel->mPositionKeys[k].mTime, glm::vec4(v.x, v.y, v.z, 0.0f));
+            }
+            track.channels[ANIMATION_ROTATION].firstKey = static_cast<uint32_t>(clip.keyTimes.size());
+            track.channels[ANIMATION_ROTATION].keyCount = channel->mNumRotationKeys;
+            for (unsigned int k = 0; k < channel->mNumRotationKeys; k++)
+            {
+                const aiQuaternion &q = channel->mRotationKeys[k].mValue;
+                appendKey(channel->mRotationKeys[k].mTime, glm::vec4(q.x, q.y, q.z, q.w));
+            }
+            track.channels[ANIMATION_SCALE].firstKey = static_cast<uint32_t>(clip.keyTimes.size());
+            track.channels[ANIMATION_SCALE].keyCount = channel->mNumScalingKeys;
+            for (unsigned int k = 0; k < channel->mNumScalingKeys; k++)
+            {
+                const aiVector3D &v = channel->mScalingKeys[k].mValue;
+                appendKey(channel->mScalingKeys[k].mTime, glm::vec4(v.x, v.y, v.z, 0.0f));
+            }
+            clip.tracks.push_back(track);
+        }
+        if (!clip.tracks.empty())
+            clips.push_back(std::move(clip));
+    }
+    return clips;
+}
+
+// keeps the four strongest influences of a vertex
+inline void addBoneInfluence(Vertex &vertex, int joint, float weight)
+{
+    int slot = 0;
+    for (int i = 1; i < MAX_BONE_INFLUENCE; i++)
+        if (vertex.m_BoneIDs[i] < 0 || (vertex.m_BoneIDs[slot] >= 0 && vertex.m_Weights[i] < vertex.m_Weights[slot]))
+            slot = i;
+    if (vertex.m_BoneIDs[slot] >= 0 && vertex.m_Weights[slot] >= weight)
+        return;
+    vertex.m_BoneIDs[slot] = joint;
+    vertex.m_Weights[slot] = weight;
+}
+
+inline MeshData parseMesh(aiMesh *mesh, const aiScene *scene, const Skeleton &skeleton)
+{
+    MeshData data;
+    std::vector<Vertex> vertices;
+    vertices.reserve(mesh->mNumVertices);
+    for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+    {
+        Vertex vertex;
+        vertex.Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+        vertex.Normal = glm::vec3(0.0f);
+        if (mesh->HasNormals())
+            vertex.Normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
+        vertex.TexCoords = glm::vec2(0.0f, 0.0f);
+        vertex.Tangent = glm::vec3(0.0f);
+        vertex.Bitangent = glm::vec3(0.0f);
+        if (mesh->mTextureCoords[0])
+        {
+            vertex.TexCoords = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
+            vertex.Tangent = glm::vec3(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z);
+            vertex.Bitangent = glm::vec3(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z);
+        }
+        for (int j = 0; j < MAX_BONE_INFLUENCE; j++)
+        {
+            vertex.m_BoneIDs[j] = -1;
+            vertex.m_Weights[j] = 0.0f;
+        }
+        vertices.push_back(vertex);
+    }
+
+    for (unsigned int b = 0; b < mesh->mNumBones; b++)
+    {
+        const aiBone *bone = mesh->mBones[b];
+        int joint = skeleton.find(bone->mName.C_Str());
+        if (joint < 0)
+            continue;
+        for (unsigned int w = 0; w < bone->mNumWeights; w++)
+            if (bone->mWeights[w].mVertexId < vertices.size())
+                addBoneInfluence(vertices[bone->mWeights[w].mVertexId], joint, bone->mWeights[w].mWeight);
+    }
+    // dropped influences leave the sum below 1
+    if (mesh->mNumBones > 0)
+    {
+        for (Vertex &vertex : vertices)
+        {
+            float total = 0.0f;
+            for (int j = 0; j < MAX_BONE_INFLUENCE; j++)
+                total += vertex.m_BoneIDs[j] >= 0 ? vertex.m_Weights[j] : 0.0f;
+            for (int j = 0; j < MAX_BONE_INFLUENCE && total > 0.0f; j++)
+                vertex.m_Weights[j] /= total;
+        }
+    }
+
+    for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+    {
+        aiFace face = mesh->mFaces[i];
+        for (unsigned int j = 0; j < face.mNumIndices; j++)
+            data.indices.push_back(face.mIndices[j]);
+    }
+    prepareMesh(vertices, data);
+
+    // same sampler naming as learnopengl's Model: texture_diffuseN, texture_specularN, texture_normalN, texture_heightN
+    aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
+    appendMaterialTextures(data.textures, material, aiTextureType_DIFFUSE, "texture_diffuse");
+    appendMaterialTextures(data.textures, material, aiTextureType_SPECULAR, "texture_specular");
+    appendMaterialTextures(data.textures, material, aiTextureType_HEIGHT, "texture_normal");
+    appendMaterialTextures(data.textures, material, aiTextureType_AMBIENT, "texture_height");
+    return data;
+}
+
+inline void parseNode(aiNode *node, const aiScene *scene, ModelData &model)
+{
+    for (unsigned int i = 0; i < node->mNumMeshes; i++)
+        model.meshes.push_back(parseMesh(scene->mMeshes[node->mMeshes[i]], scene, model.animation.skeleton));
+    for (unsigned int i = 0; i < node->mNumChildren; i++)
+        parseNode(node->mChildren[i], scene, model);
+}
+
+// Model::loadModel() without the GL calls, safe to run on any thread
+inline ModelData parseModel(const std::string &path)
+{
+    ModelData model;
+    Assimp::Importer importer;
+    const aiScene *scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+    {
+        std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
+        return model;
+    }
+    model.directory = path.substr(0, path.find_last_of('/'));
+    // the skeleton first: vertex bone ids are its joint indices
+    model.animation.skeleton = parseSkeleton(scene);
+    model.animation.clips = parseAnimations(scene, model.animation.skeleton);
+    parseNode(scene->mRootNode, scene, model);
+    model.useOwnedData();
+    model.loaded = true;
+    return model;
+}
+
+#endif
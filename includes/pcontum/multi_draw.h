@@ -0,0 +1,220 @@
+#ifndef MULTI_DRAW_H
+#define MULTI_DRAW_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <pcontum/geometry_buffer.h>
+#include <pcontum/gl_extensions.h>
+#include <pcontum/shader_program.h>
+
+#include <cstring>
+#include <vector>
+
+// A list of GeometryBuffer ranges, each with its own instance transforms, rebuilt
+// every frame and drawn with a single glMultiDrawElementsIndirect. The shader finds its per-draw data
+// through gl_DrawIDARB: drawRecords[drawId] is the first transform of the draw, and every instance reads
+// its model and normal matrix from drawTransforms[first + gl_InstanceID]. Both are texture buffers, so
+// nothing beyond GL 3.3 is needed on the shader side (see 2.2.2.pbr.vs, vertex_shader.glsl). The range's
+// quantization is folded into the stored model matrix; the normal matrix comes from the model alone.
+// A skinned instance stores the quantization alone instead and the index of its first matrix in the
+// skinning palettes (skeletal_animation_gl.h) in the w of the first normal matrix texel, -1 otherwise;
+// its palette is already in world space.
+//
+// glad is generated for GL 3.3, so the entry point is fetched at runtime. Without GL 4.3 (or
+// ARB_multi_draw_indirect) plus ARB_shader_draw_parameters, the same commands go out as one
+// glDrawElementsInstancedBaseVertex each with the draw index in the drawIdBase uniform; one VAO and no
+// binds in between either way.
+
+// layout fixed by GL
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+typedef void (APIENTRY *MultiDrawElementsIndirectProc)(GLenum mode, GLenum type, const void *indirect,
+                                                         GLsizei drawCount, GLsizei stride);
+
+const GLenum MULTI_DRAW_INDIRECT_BUFFER = 0x8F3F; // GL_DRAW_INDIRECT_BUFFER, not in the 3.3 headers
+
+inline MultiDrawElementsIndirectProc &multiDrawElementsIndirect()
+{
+    static MultiDrawElementsIndirectProc proc = nullptr;
+    return proc;
+}
+
+// call once after gladLoadGLLoader with the same loader; returns whether the indirect path is available
+inline bool loadMultiDrawIndirect(GLADloadproc load)
+{
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    bool indirect = major > 4 || (major == 4 && minor >= 3) || hasGlExtension("GL_ARB_multi_draw_indirect");
+    // the shaders only see gl_DrawIDARB through the extension
+    bool drawParameters = hasGlExtension("GL_ARB_shader_draw_parameters");
+    multiDrawElementsIndirect() = nullptr;
+    if (indirect && drawParameters)
+        multiDrawElementsIndirect() = reinterpret_cast<MultiDrawElementsIndirectProc>(load("glMultiDrawElementsIndirect"));
+    return multiDrawElementsIndirect() != nullptr;
+}
+
+class MultiDrawList
+{
+public:
+    // texture units of the two buffers, above the eight the PBR shader uses
+    static const int TRANSFORM_UNIT = 8;
+    static const int RECORD_UNIT = 9;
+
+    explicit MultiDrawList(GeometryBuffer &geometry) : geometry(geometry)
+    {
+        glGenBuffers(1, &commandBuffer);
+        glGenBuffers(1, &transformBuffer);
+        glGenBuffers(1, &recordBuffer);
+        glGenTextures(1, &transformTexture);
+        glGenTextures(1, &recordTexture);
+
+        // the texture buffers keep pointing at their buffers when the storage is respecified each frame
+        glBindBuffer(GL_TEXTURE_BUFFER, transformBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, transformTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, transformBuffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, recordBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, sizeof(GLint), nullptr, GL_STREAM_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, recordTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32I, recordBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    MultiDrawList(const MultiDrawList &) = delete;
+    MultiDrawList &operator=(const MultiDrawList &) = delete;
+
+    ~MultiDrawList() { release(); }
+
+    // deletes the buffers and texture views; called by the owner while the GL context is still current
+    void release()
+    {
+        if (!commandBuffer)
+            return;
+        unsigned int buffers[] = { commandBuffer, transformBuffer, recordBuffer };
+        glDeleteBuffers(3, buffers);
+        unsigned int textures[] = { transformTexture, recordTexture };
+        glDeleteTextures(2, textures);
+        commandBuffer = transformBuffer = recordBuffer = 0;
+        transformTexture = recordTexture = 0;
+    }
+
+    void clear()
+    {
+        commands.clear();
+        transforms.clear();
+        records.clear();
+    }
+
+    // one command drawing range once per transform. paletteBases, if given, holds each instance's first
+    // palette matrix; those instances are skinned.
+    void add(const GeometryRange &range, const glm::mat4 *models, size_t instanceCount, const int *paletteBases = nullptr)
+    {
+        if (instanceCount == 0)
+            return;
+        DrawElementsIndirectCommand command;
+        command.count = range.indexCount;
+        command.instanceCount = static_cast<GLuint>(instanceCount);
+        command.firstIndex = range.firstIndex;
+        command.baseVertex = range.baseVertex;
+        command.baseInstance = 0;
+        commands.push_back(command);
+        records.push_back(static_cast<GLint>(transforms.size() / TEXELS_PER_INSTANCE));
+        glm::mat4 dequantize = range.quantization.matrix();
+
+        for (size_t i = 0; i < instanceCount; ++i)
+        {
+            const glm::mat4 &model = models[i];
+            glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+            bool skinned = paletteBases && paletteBases[i] >= 0;
+            glm::mat4 transform = skinned ? dequantize : model * dequantize;
+            for (int column = 0; column < 4; ++column)
+                transforms.push_back(transform[column]);
+            for (int column = 0; column < 3; ++column)
+                transforms.push_back(glm::vec4(normalMatrix[column], 0.0f));
+            transforms[transforms.size() - 3].w = skinned ? static_cast<float>(paletteBases[i]) : -1.0f;
+        }
+    }
+
+    void add(const GeometryRange &range, const glm::mat4 &model) { add(range, &model, 1); }
+
+    // uploads this frame's lists and draws them; the shader must be bound
+    void submit(ShaderProgram &shader)
+    {
+        lastDrawCalls = 0;
+        if (commands.empty())
+            return;
+
+        glBindBuffer(GL_TEXTURE_BUFFER, transformBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, transforms.size() * sizeof(glm::vec4), transforms.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, recordBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, records.size() * sizeof(GLint), records.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        glActiveTexture(GL_TEXTURE0 + TRANSFORM_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, transformTexture);
+        glActiveTexture(GL_TEXTURE0 + RECORD_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, recordTexture);
+        glActiveTexture(GL_TEXTURE0);
+
+        shader.setBool("multiDraw", true);
+        shader.setInt("drawTransforms", TRANSFORM_UNIT);
+        shader.setInt("drawRecords", RECORD_UNIT);
+        GLint drawIdBase = shader.uniforms.location("drawIdBase");
+        glBindVertexArray(geometry.VAO());
+
+        if (multiDrawElementsIndirect())
+        {
+            glBindBuffer(MULTI_DRAW_INDIRECT_BUFFER, commandBuffer);
+            glBufferData(MULTI_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand),
+                         commands.data(), GL_STREAM_DRAW);
+            glUniform1i(drawIdBase, 0);
+            multiDrawElementsIndirect()(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(commands.size()), 0);
+            glBindBuffer(MULTI_DRAW_INDIRECT_BUFFER, 0);
+            lastDrawCalls = 1;
+        }
+        else
+        {
+            for (size_t i = 0; i < commands.size(); ++i)
+            {
+                const DrawElementsIndirectCommand &command = commands[i];
+                glUniform1i(drawIdBase, static_cast<GLint>(i));
+                glDrawElementsInstancedBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(command.count), GL_UNSIGNED_INT,
+                                                  (void*)(size_t(command.firstIndex) * sizeof(unsigned int)),
+                                                  static_cast<GLsizei>(command.instanceCount), command.baseVertex);
+            }
+            lastDrawCalls = commands.size();
+        }
+
+        glBindVertexArray(0);
+        shader.setBool("multiDraw", false);
+    }
+
+    size_t commandCount() const { return commands.size(); }
+    size_t drawCalls() const { return lastDrawCalls; }
+
+private:
+    static const size_t TEXELS_PER_INSTANCE = 7; // mat4 model, mat3 normal matrix padded to vec4 columns
+
+    GeometryBuffer &geometry;
+    unsigned int commandBuffer = 0;
+    unsigned int transformBuffer = 0;
+    unsigned int recordBuffer = 0;
+    unsigned int transformTexture = 0;
+    unsigned int recordTexture = 0;
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<glm::vec4> transforms;
+    std::vector<GLint> records;
+    size_t lastDrawCalls = 0;
+};
+
+#endif
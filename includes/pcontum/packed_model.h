@@ -0,0 +1,331 @@
+#ifndef PACKED_MODEL_H
+#define PACKED_MODEL_H
+
+#include <glad/glad.h>
+
+#include <stb_image.h>
+
+#include <pcontum/collision_mesh.h>
+#include <pcontum/culling.h>
+#include <pcontum/model_data.h>
+#include <pcontum/scene_model.h>
+#include <pcontum/shader_program.h>
+#include <pcontum/vertex_format.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Models made of many small single-texture meshes (the carrier has ~100 tiny
+// Image_N.png files) are repacked at load time. The diffuse textures become layers of one
+// GL_TEXTURE_2D_ARRAY, every vertex carries its layer, and all meshes sharing an array are merged into
+// one vertex/index buffer. The whole model then draws with one texture bind and one draw call per array.
+// vertex_shader.glsl / fragment_shader.glsl read the layer when "useTextureArray" is set.
+
+// GL 3.3 guarantees at least 256 layers; a full array simply starts another one of the same size
+const int TEXTURE_ARRAY_MAX_LAYERS = 256;
+
+// RGBA8 layers of one size, back to back
+struct TextureArrayData
+{
+    int width = 0;
+    int height = 0;
+    int layers = 0;
+    std::vector<unsigned char> pixels;
+};
+
+// one source mesh inside a merged batch, kept so the meshes can still be culled one by one
+struct PackedMeshRange
+{
+    unsigned int firstIndex = 0; // into the batch's indices
+    unsigned int indexCount = 0;
+    Aabb bounds;                 // model space
+};
+
+// merged meshes that share one texture array; array == -1 holds the meshes without a diffuse texture
+struct PackedBatchData
+{
+    int array = -1;
+    std::vector<PackedVertex> vertices; // requantized to the bounds of the whole batch
+    VertexQuantization quantization;
+    std::vector<unsigned int> indices;
+    std::vector<int> layers; // one per vertex, -1 without texture
+    std::vector<PackedMeshRange> meshes;
+};
+
+struct PackedModelData
+{
+    bool loaded = false;
+    size_t sourceMeshes = 0;
+    size_t sourceTextures = 0;
+    std::vector<TextureArrayData> arrays;
+    std::vector<PackedBatchData> batches;
+    CollisionMesh collision; // model space, built with the batches on the worker
+};
+
+// nearest-neighbour resize of an RGBA8 image; the carrier's sizes are powers of two, so upscaling just
+// repeats texels and loses nothing
+inline void resizeRgba8(const unsigned char *source, int sourceWidth, int sourceHeight, unsigned char *target,
+                        int targetWidth, int targetHeight)
+{
+    for (int y = 0; y < targetHeight; ++y)
+    {
+        int sy = y * sourceHeight / targetHeight;
+        for (int x = 0; x < targetWidth; ++x)
+        {
+            int sx = x * sourceWidth / targetWidth;
+            std::memcpy(target + (size_t(y) * targetWidth + x) * 4, source + (size_t(sy) * sourceWidth + sx) * 4, 4);
+        }
+    }
+}
+
+// decodes every mesh's first diffuse texture (no GL, runs on a worker) and merges the meshes per array.
+// All layers get the size of the largest texture, so a model normally ends up with a single array that
+// one draw (or one multi-draw) can sample from.
+inline PackedModelData packModel(const ModelData &model)
+{
+    PackedModelData packed;
+    if (!model.loaded)
+        return packed;
+    packed.sourceMeshes = model.meshes.size();
+
+    // same orientation as Model/TextureFromFile(); the setting is per thread
+    stbi_set_flip_vertically_on_load_thread(false);
+
+    struct DecodedImage
+    {
+        int width = 0;
+        int height = 0;
+        unsigned char *pixels = nullptr;
+        std::pair<int, int> slot = std::make_pair(-1, -1); // (array, layer)
+    };
+    std::map<std::string, DecodedImage> images;
+    std::vector<std::string> meshTexture(model.meshes.size());
+    int width = 0, height = 0;
+    for (size_t i = 0; i < model.meshes.size(); ++i)
+    {
+        for (const Texture &texture : model.meshes[i].textures)
+        {
+            if (texture.type != "texture_diffuse")
+                continue;
+            std::string path = model.directory + '/' + texture.path;
+            meshTexture[i] = path;
+            if (images.count(path))
+                break;
+            DecodedImage &image = images[path];
+            int components;
+            image.pixels = stbi_load(path.c_str(), &image.width, &image.height, &components, 4);
+            if (image.pixels)
+            {
+                width = std::max(width, image.width);
+                height = std::max(height, image.height);
+            }
+            else
+            {
+                std::cout << "Texture failed to load at path: " << path << std::endl;
+            }
+            break;
+        }
+    }
+
+    // layers in first-use order
+    size_t layerSize = size_t(width) * height * 4;
+    for (const std::string &path : meshTexture)
+    {
+        if (path.empty())
+            continue;
+        DecodedImage &image = images[path];
+        if (!image.pixels || image.slot.first >= 0)
+            continue;
+        if (packed.arrays.empty() || packed.arrays.back().layers == TEXTURE_ARRAY_MAX_LAYERS)
+        {
+            packed.arrays.emplace_back();
+            packed.arrays.back().width = width;
+            packed.arrays.back().height = height;
+        }
+        TextureArrayData &target = packed.arrays.back();
+        target.pixels.resize(target.pixels.size() + layerSize);
+        resizeRgba8(image.pixels, image.width, image.height, target.pixels.data() + target.pixels.size() - layerSize,
+                    width, height);
+        image.slot = std::make_pair(static_cast<int>(packed.arrays.size() - 1), target.layers++);
+        packed.sourceTextures++;
+    }
+    for (auto &entry : images)
+        stbi_image_free(entry.second.pixels);
+
+    // the batches first, so every batch knows its bounds before its meshes' positions are requantized
+    std::map<int, size_t> batchOfArray;
+    std::vector<size_t> meshBatch(model.meshes.size());
+    std::vector<Aabb> batchBounds;
+    for (size_t i = 0; i < model.meshes.size(); ++i)
+    {
+        int array = meshTexture[i].empty() ? -1 : images[meshTexture[i]].slot.first;
+        auto batch = batchOfArray.find(array);
+        if (batch == batchOfArray.end())
+        {
+            batch = batchOfArray.insert(std::make_pair(array, packed.batches.size())).first;
+            packed.batches.emplace_back();
+            packed.batches.back().array = array;
+            batchBounds.emplace_back();
+        }
+        meshBatch[i] = batch->second;
+        batchBounds[batch->second].expand(model.meshes[i].quantization.bounds());
+    }
+    for (size_t b = 0; b < packed.batches.size(); ++b)
+        packed.batches[b].quantization = VertexQuantization::fromBounds(batchBounds[b]);
+
+    for (size_t i = 0; i < model.meshes.size(); ++i)
+    {
+        const MeshData &mesh = model.meshes[i];
+        int layer = meshTexture[i].empty() ? -1 : images[meshTexture[i]].slot.second;
+        PackedBatchData &target = packed.batches[meshBatch[i]];
+        PackedMeshRange range;
+        range.firstIndex = static_cast<unsigned int>(target.indices.size());
+        range.indexCount = static_cast<unsigned int>(mesh.indexCount);
+        range.bounds = mesh.quantization.bounds();
+        target.meshes.push_back(range);
+        unsigned int base = static_cast<unsigned int>(target.vertices.size());
+        const VertexQuantization &to = target.quantization;
+        for (size_t v = 0; v < mesh.vertexCount; ++v)
+        {
+            PackedVertex vertex = mesh.vertexData[v];
+            glm::vec3 position = (unpackPosition(vertex, mesh.quantization) - to.offset) / to.scale;
+            for (int axis = 0; axis < 3; ++axis)
+                vertex.position[axis] = packUnorm16(position[axis]);
+            target.vertices.push_back(vertex);
+        }
+        target.layers.insert(target.layers.end(), mesh.vertexCount, layer);
+        for (size_t j = 0; j < mesh.indexCount; ++j)
+            target.indices.push_back(base + mesh.indexData[j]);
+    }
+    packed.collision = buildCollisionMesh(model);
+    packed.loaded = true;
+    return packed;
+}
+
+// GPU side: the arrays and one merged mesh per array
+class PackedModel
+{
+public:
+    // attribute slot after the instance matrices of InstancedModel (7..13)
+    static const unsigned int LAYER_LOCATION = 14;
+    // texture unit of the array; kept off unit 0 so it never shares a unit with a sampler2D
+    static const int ARRAY_UNIT = 1;
+
+    size_t sourceMeshes = 0;
+    size_t sourceTextures = 0;
+    CollisionMesh collision; // CPU only; the asset loader moves it over after upload()
+
+    PackedModel() {}
+    PackedModel(const PackedModel &) = delete;
+    PackedModel &operator=(const PackedModel &) = delete;
+
+    ~PackedModel() { release(); }
+
+    // deletes the arrays and batch buffers while the GL context is still current; the model is empty after
+    void release()
+    {
+        if (!arrays.empty())
+            glDeleteTextures(static_cast<GLsizei>(arrays.size()), arrays.data());
+        for (Batch &batch : batches)
+        {
+            glDeleteVertexArrays(1, &batch.mesh.VAO);
+            glDeleteBuffers(1, &batch.mesh.VBO);
+            glDeleteBuffers(1, &batch.mesh.EBO);
+            glDeleteBuffers(1, &batch.layerVBO);
+        }
+        arrays.clear();
+        batches.clear();
+    }
+
+    void upload(const PackedModelData &data)
+    {
+        sourceMeshes = data.sourceMeshes;
+        sourceTextures = data.sourceTextures;
+
+        arrays.resize(data.arrays.size());
+        if (!arrays.empty())
+            glGenTextures(static_cast<GLsizei>(arrays.size()), arrays.data());
+        for (size_t i = 0; i < arrays.size(); ++i)
+        {
+            const TextureArrayData &array = data.arrays[i];
+            glBindTexture(GL_TEXTURE_2D_ARRAY, arrays[i]);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, array.width, array.height, array.layers, 0, GL_RGBA,
+                         GL_UNSIGNED_BYTE, array.pixels.data());
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        }
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        batches.resize(data.batches.size());
+        for (size_t i = 0; i < batches.size(); ++i)
+        {
+            const PackedBatchData &source = data.batches[i];
+            Batch &batch = batches[i];
+            batch.array = source.array;
+            batch.meshes = source.meshes;
+            batch.mesh.upload(source.vertices.data(), source.vertices.size(), source.quantization, source.indices.data(),
+                              source.indices.size());
+
+            glBindVertexArray(batch.mesh.VAO);
+            glGenBuffers(1, &batch.layerVBO);
+            glBindBuffer(GL_ARRAY_BUFFER, batch.layerVBO);
+            glBufferData(GL_ARRAY_BUFFER, source.layers.size() * sizeof(int), source.layers.data(), GL_STATIC_DRAW);
+            glEnableVertexAttribArray(LAYER_LOCATION);
+            glVertexAttribIPointer(LAYER_LOCATION, 1, GL_INT, sizeof(int), (void*)0);
+            glBindVertexArray(0);
+        }
+    }
+
+    size_t drawCount() const { return batches.size(); }
+
+    // merged meshes for callers that draw them their own way (GeometryBuffer / MultiDrawList)
+    const SceneMesh &batchMesh(size_t batch) const { return batches[batch].mesh; }
+    unsigned int batchLayers(size_t batch) const { return batches[batch].layerVBO; }
+    int batchArray(size_t batch) const { return batches[batch].array; }
+    const std::vector<PackedMeshRange> &batchMeshes(size_t batch) const { return batches[batch].meshes; }
+    size_t arrayCount() const { return arrays.size(); }
+    unsigned int arrayTexture(size_t array) const { return arrays[array]; }
+
+    void Draw(ShaderProgram &shader)
+    {
+        GLint dequantize = shader.uniforms.location("positionDequantize");
+        shader.setBool("useTextureArray", true);
+        shader.setInt("material.texture_array", ARRAY_UNIT);
+        glActiveTexture(GL_TEXTURE0 + ARRAY_UNIT);
+        for (Batch &batch : batches)
+        {
+            glBindTexture(GL_TEXTURE_2D_ARRAY, batch.array >= 0 ? arrays[batch.array] : 0);
+            glm::mat4 matrix = batch.mesh.quantization.matrix();
+            glUniformMatrix4fv(dequantize, 1, GL_FALSE, &matrix[0][0]);
+            glBindVertexArray(batch.mesh.VAO);
+            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(batch.mesh.indexCount), GL_UNSIGNED_INT, 0);
+        }
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+        shader.setBool("useTextureArray", false);
+    }
+
+private:
+    struct Batch
+    {
+        SceneMesh mesh;
+        unsigned int layerVBO = 0;
+        int array = -1;
+        std::vector<PackedMeshRange> meshes;
+    };
+
+    std::vector<unsigned int> arrays;
+    std::vector<Batch> batches;
+};
+
+#endif
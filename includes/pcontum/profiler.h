@@ -0,0 +1,400 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <glad/glad.h>
+
+#include <pcontum/spsc_ring.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Named zones per frame on two tracks. A CPU zone is a pair of steady_clock reads; a
+// GPU zone is a pair of GL_TIMESTAMP queries (glQueryCounter, core since 3.3), which unlike
+// GL_TIME_ELAPSED may nest and put the GPU work on the same timeline as the CPU. Query results are read
+// a few frames later, once they are available, so measuring never stalls the pipeline; a finished frame
+// then goes into a lock-free ring. The consumer side (ProfileHistory) drains the ring into a rolling
+// window for p50/p99 summaries and Chrome trace_event JSON (chrome://tracing, ui.perfetto.dev).
+//
+// Zone names are not copied: pass string literals.
+
+enum ProfileTrack
+{
+    PROFILE_CPU = 0,
+    PROFILE_GPU = 1,
+};
+
+struct ProfileZone
+{
+    const char *name;
+    uint32_t track;
+    double start;    // microseconds since the profiler was created
+    double duration; // microseconds
+};
+
+// zones past this are dropped for the frame
+const int PROFILE_MAX_ZONES = 64;
+
+struct ProfileFrame
+{
+    uint64_t index = 0;
+    uint32_t zoneCount = 0;
+    ProfileZone zones[PROFILE_MAX_ZONES];
+};
+
+// producer side; all calls from the GL thread, with the context current
+class FrameProfiler
+{
+public:
+    // how many frames may wait for their GPU timestamps before beginFrame() waits for the oldest
+    static const int FRAMES_IN_FLIGHT = 4;
+
+    explicit FrameProfiler(size_t ringFrames = 1024) : ring(ringFrames), epoch(std::chrono::steady_clock::now())
+    {
+        // GPU timestamps onto the CPU timeline; both clocks are steady, the offset is taken once
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        gpuOffset = now() - static_cast<double>(gpuNow) / 1000.0;
+    }
+
+    FrameProfiler(const FrameProfiler &) = delete;
+    FrameProfiler &operator=(const FrameProfiler &) = delete;
+
+    ~FrameProfiler() { release(); }
+
+    // deletes the timestamp queries while the GL context is still current; unresolved frames are dropped
+    void release()
+    {
+        for (InFlight &frame : inFlight)
+        {
+            if (!frame.queries.empty())
+                glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+            frame.queries.clear();
+            frame.usedQueries = 0;
+            frame.pending = false;
+        }
+    }
+
+    // opens the "frame" zone on both tracks
+    void beginFrame()
+    {
+        InFlight &frame = inFlight[frameCount % FRAMES_IN_FLIGHT];
+        if (frame.pending)
+        {
+            // the oldest frame; everything before it is resolved already
+            resolve(frame);
+            resolved++;
+        }
+        frame.frame.index = frameCount;
+        frame.frame.zoneCount = 0;
+        frame.usedQueries = 0;
+        frame.open.clear();
+        frame.gpuZones.clear();
+        frame.pending = true;
+        frameZone = begin("frame", true);
+    }
+
+    // closes the frame and hands every frame whose GPU results are in to the ring
+    void endFrame()
+    {
+        end(frameZone);
+        frameCount++;
+        while (resolved < frameCount)
+        {
+            InFlight &frame = inFlight[resolved % FRAMES_IN_FLIGHT];
+            if (frame.usedQueries > 0)
+            {
+                GLint available = 0;
+                glGetQueryObjectiv(frame.queries[frame.usedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+                if (!available)
+                    break;
+            }
+            resolve(frame);
+            resolved++;
+        }
+    }
+
+    // starts a zone in the current frame; gpu adds the same zone on the GPU track. Returns the handle
+    // for end(), -1 if the frame is full.
+    int begin(const char *name, bool gpu = false)
+    {
+        InFlight &frame = current();
+        int zones = gpu ? 2 : 1;
+        if (frame.frame.zoneCount + zones > static_cast<uint32_t>(PROFILE_MAX_ZONES))
+            return -1;
+        OpenZone open;
+        open.cpuZone = frame.frame.zoneCount++;
+        frame.frame.zones[open.cpuZone] = ProfileZone{ name, PROFILE_CPU, now(), 0.0 };
+        if (gpu)
+        {
+            GpuZone zone;
+            zone.zone = frame.frame.zoneCount++;
+            frame.frame.zones[zone.zone] = ProfileZone{ name, PROFILE_GPU, 0.0, 0.0 };
+            zone.beginQuery = frame.usedQueries;
+            glQueryCounter(query(frame), GL_TIMESTAMP);
+            open.gpuZone = static_cast<int>(frame.gpuZones.size());
+            frame.gpuZones.push_back(zone);
+        }
+        frame.open.push_back(open);
+        return static_cast<int>(frame.open.size() - 1);
+    }
+
+    void end(int handle)
+    {
+        if (handle < 0)
+            return;
+        InFlight &frame = current();
+        const OpenZone &open = frame.open[handle];
+        ProfileZone &zone = frame.frame.zones[open.cpuZone];
+        zone.duration = now() - zone.start;
+        if (open.gpuZone >= 0)
+        {
+            frame.gpuZones[open.gpuZone].endQuery = frame.usedQueries;
+            glQueryCounter(query(frame), GL_TIMESTAMP);
+        }
+    }
+
+    // finished frames, oldest first; one consumer (see ProfileHistory)
+    SpscRing<ProfileFrame> &frames() { return ring; }
+    // frames lost because the consumer fell more than a ring behind
+    size_t droppedFrames() const { return dropped; }
+
+private:
+    struct OpenZone
+    {
+        uint32_t cpuZone = 0;
+        int gpuZone = -1; // into InFlight::gpuZones
+    };
+
+    struct GpuZone
+    {
+        uint32_t zone = 0;
+        size_t beginQuery = 0;
+        size_t endQuery = SIZE_MAX; // stays so if the zone was never closed
+    };
+
+    struct InFlight
+    {
+        ProfileFrame frame;
+        std::vector<GLuint> queries;
+        size_t usedQueries = 0;
+        std::vector<OpenZone> open;
+        std::vector<GpuZone> gpuZones;
+        bool pending = false;
+    };
+
+    SpscRing<ProfileFrame> ring;
+    std::chrono::steady_clock::time_point epoch;
+    double gpuOffset = 0.0;
+    InFlight inFlight[FRAMES_IN_FLIGHT];
+    uint64_t frameCount = 0;
+    uint64_t resolved = 0;
+    int frameZone = -1;
+    size_t dropped = 0;
+    std::vector<GLuint64> stamps;
+
+    double now() const
+    {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    InFlight &current() { return inFlight[frameCount % FRAMES_IN_FLIGHT]; }
+
+    // next query object of the frame, created the first time a frame needs that many
+    GLuint query(InFlight &frame)
+    {
+        if (frame.usedQueries == frame.queries.size())
+        {
+            GLuint id;
+            glGenQueries(1, &id);
+            frame.queries.push_back(id);
+        }
+        return frame.queries[frame.usedQueries++];
+    }
+
+    // reads the frame's timestamps (waiting for them if need be) and pushes it to the ring
+    void resolve(InFlight &frame)
+    {
+        stamps.resize(frame.usedQueries);
+        for (size_t i = 0; i < frame.usedQueries; ++i)
+            glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &stamps[i]);
+        for (const GpuZone &gpu : frame.gpuZones)
+        {
+            if (gpu.endQuery == SIZE_MAX)
+                continue;
+            ProfileZone &zone = frame.frame.zones[gpu.zone];
+            zone.start = static_cast<double>(stamps[gpu.beginQuery]) / 1000.0 + gpuOffset;
+            zone.duration = static_cast<double>(stamps[gpu.endQuery] - stamps[gpu.beginQuery]) / 1000.0;
+        }
+        frame.pending = false;
+        if (!ring.push(frame.frame))
+            dropped++;
+    }
+};
+
+// measures the enclosing block
+class ProfileScope
+{
+public:
+    ProfileScope(FrameProfiler &profiler, const char *name, bool gpu = false)
+        : profiler(profiler), handle(profiler.begin(name, gpu))
+    {
+    }
+
+    ~ProfileScope() { profiler.end(handle); }
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+    FrameProfiler &profiler;
+    int handle;
+};
+
+// one zone over the history window, per frame (zones of the same name in a frame are added up)
+struct ProfileZoneStats
+{
+    std::string name;
+    uint32_t track = PROFILE_CPU;
+    size_t frames = 0;
+    double p50 = 0.0; // milliseconds
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+// consumer side: the last frames out of the ring, summaries and trace export. Not tied to GL, so a copy
+// can be written out on a worker thread.
+class ProfileHistory
+{
+public:
+    explicit ProfileHistory(size_t window = 600) : window(window) {}
+
+    void drain(SpscRing<ProfileFrame> &ring)
+    {
+        ProfileFrame frame;
+        while (ring.pop(frame))
+        {
+            history.push_back(frame);
+            if (history.size() > window)
+                history.pop_front();
+        }
+    }
+
+    size_t size() const { return history.size(); }
+
+    std::vector<ProfileZoneStats> summary() const
+    {
+        // (track, name) -> per-frame totals, in first-seen order
+        std::map<std::pair<uint32_t, std::string>, size_t> slot;
+        std::vector<ProfileZoneStats> stats;
+        std::vector<std::vector<double>> samples;
+        std::map<size_t, double> frameTotals;
+        for (const ProfileFrame &frame : history)
+        {
+            frameTotals.clear();
+            for (uint32_t i = 0; i < frame.zoneCount; ++i)
+            {
+                const ProfileZone &zone = frame.zones[i];
+                auto key = std::make_pair(zone.track, std::string(zone.name));
+                auto found = slot.find(key);
+                if (found == slot.end())
+                {
+                    found = slot.insert(std::make_pair(key, stats.size())).first;
+                    stats.emplace_back();
+                    stats.back().name = key.second;
+                    stats.back().track = zone.track;
+                    samples.emplace_back();
+                }
+                frameTotals[found->second] += zone.duration / 1000.0;
+            }
+            for (const auto &total : frameTotals)
+                samples[total.first].push_back(total.second);
+        }
+        for (size_t i = 0; i < stats.size(); ++i)
+        {
+            std::vector<double> &values = samples[i];
+            std::sort(values.begin(), values.end());
+            stats[i].frames = values.size();
+            stats[i].p50 = percentile(values, 0.50);
+            stats[i].p99 = percentile(values, 0.99);
+            stats[i].max = values.back();
+        }
+        return stats;
+    }
+
+    void printSummary(std::ostream &out) const
+    {
+        out << "Profil (ms, son " << history.size() << " kare, p50 / p99 / en kötü):" << std::endl;
+        char line[160];
+        for (const ProfileZoneStats &zone : summary())
+        {
+            std::snprintf(line, sizeof(line), "  %s %-24s %7.2f / %7.2f / %7.2f", zone.track == PROFILE_GPU ? "GPU" : "CPU",
+                          zone.name.c_str(), zone.p50, zone.p99, zone.max);
+            out << line << std::endl;
+        }
+    }
+
+    // Chrome trace_event JSON: one "X" event per zone, CPU and GPU as two threads of one process
+    bool writeChromeTrace(const std::string &path) const
+    {
+        std::ofstream file(path, std::ios::trunc);
+        if (!file)
+            return false;
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+        char event[256];
+        for (const ProfileFrame &frame : history)
+        {
+            for (uint32_t i = 0; i < frame.zoneCount; ++i)
+            {
+                const ProfileZone &zone = frame.zones[i];
+                std::snprintf(event, sizeof(event),
+                              ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+                              "\"args\":{\"frame\":%llu}}",
+                              escape(zone.name).c_str(), zone.track == PROFILE_GPU ? "gpu" : "cpu",
+                              zone.track == PROFILE_GPU ? 2 : 1, zone.start, zone.duration,
+                              static_cast<unsigned long long>(frame.index));
+                file << event;
+            }
+        }
+        file << "\n]}\n";
+        return static_cast<bool>(file);
+    }
+
+private:
+    size_t window;
+    std::deque<ProfileFrame> history;
+
+    // nearest rank
+    static double percentile(const std::vector<double> &sorted, double fraction)
+    {
+        if (sorted.empty())
+            return 0.0;
+        size_t rank = static_cast<size_t>(fraction * sorted.size() + 0.999999);
+        return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+    }
+
+    static std::string escape(const char *text)
+    {
+        std::string result;
+        for (; *text; ++text)
+        {
+            if (*text == '"' || *text == '\\')
+                result += '\\';
+            result += *text;
+        }
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,473 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+
+#include <pcontum/gl_extensions.h>
+#include <pcontum/hash.h>
+#include <pcontum/mapped_file.h>
+#include <pcontum/shader_program.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The demo's programs are linked once and kept as driver program binaries
+// (glGetProgramBinary) in one file. The next launch hands the blob back with glProgramBinary instead of
+// compiling the GLSL. A binary is looked up by a hash of the program's sources with their defines; the
+// file as a whole belongs to one GL_VENDOR / GL_RENDERER / GL_VERSION, so a driver update throws all of it
+// away.
+// The driver may also reject a binary it wrote itself; that program is then compiled from source and the
+// file is rewritten.
+//
+// Compiling from source starts every compile and link before it checks any of them. With
+// KHR_parallel_shader_compile (or the ARB version) the driver runs them on its own threads, and
+// GL_COMPLETION_STATUS tells which ones are done, so they are checked in the order they finish.
+//
+// glad is generated for GL 3.3, so all of this is fetched at runtime (GL 4.1 or ARB_get_program_binary);
+// without it every launch compiles, still in parallel where possible.
+//
+// File layout (native endianness):
+//   ProgramCacheHeader
+//   per program: ProgramBinaryRecord, then length bytes of binary, padded to 8
+
+const uint32_t PROGRAM_CACHE_VERSION = 1;
+
+struct ProgramCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t contextKey; // vendor, renderer, version
+    uint32_t programCount;
+    uint32_t padding;
+};
+
+struct ProgramBinaryRecord
+{
+    uint64_t sourceKey;
+    uint32_t format;
+    uint32_t length;
+};
+
+typedef void (APIENTRY *GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat,
+                                              void *binary);
+typedef void (APIENTRY *ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (APIENTRY *ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+typedef void (APIENTRY *MaxShaderCompilerThreadsProc)(GLuint count);
+
+// not in the 3.3 headers
+const GLenum PROGRAM_BINARY_RETRIEVABLE_HINT = 0x8257;
+const GLenum PROGRAM_BINARY_LENGTH = 0x8741;
+const GLenum NUM_PROGRAM_BINARY_FORMATS = 0x87FE;
+const GLenum COMPLETION_STATUS = 0x91B1; // GL_COMPLETION_STATUS_KHR / _ARB
+
+struct ProgramBinaryProcs
+{
+    GetProgramBinaryProc getProgramBinary = nullptr;
+    ProgramBinaryProc programBinary = nullptr;
+    ProgramParameteriProc programParameteri = nullptr;
+    bool parallelCompile = false;
+
+    bool binaries() const { return getProgramBinary && programBinary && programParameteri; }
+};
+
+inline ProgramBinaryProcs &programBinaryProcs()
+{
+    static ProgramBinaryProcs procs;
+    return procs;
+}
+
+// call once after gladLoadGLLoader with the same loader; returns whether program binaries can be cached
+inline bool loadProgramBinary(GLADloadproc load)
+{
+    ProgramBinaryProcs &procs = programBinaryProcs();
+    procs = ProgramBinaryProcs();
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    GLint formats = 0;
+    if (major > 4 || (major == 4 && minor >= 1) || hasGlExtension("GL_ARB_get_program_binary"))
+        glGetIntegerv(NUM_PROGRAM_BINARY_FORMATS, &formats);
+    // a driver may support the entry points and still accept no format at all
+    if (formats > 0)
+    {
+        procs.getProgramBinary = reinterpret_cast<GetProgramBinaryProc>(load("glGetProgramBinary"));
+        procs.programBinary = reinterpret_cast<ProgramBinaryProc>(load("glProgramBinary"));
+        procs.programParameteri = reinterpret_cast<ProgramParameteriProc>(load("glProgramParameteri"));
+    }
+
+    MaxShaderCompilerThreadsProc maxThreads = nullptr;
+    if (hasGlExtension("GL_KHR_parallel_shader_compile"))
+        maxThreads = reinterpret_cast<MaxShaderCompilerThreadsProc>(load("glMaxShaderCompilerThreadsKHR"));
+    else if (hasGlExtension("GL_ARB_parallel_shader_compile"))
+        maxThreads = reinterpret_cast<MaxShaderCompilerThreadsProc>(load("glMaxShaderCompilerThreadsARB"));
+    if (maxThreads)
+    {
+        maxThreads(0xFFFFFFFFu); // as many as the driver wants
+        procs.parallelCompile = true;
+    }
+    return procs.binaries();
+}
+
+// the source with defines (whole lines, "#define NAME VALUE\n") right after its #version line
+inline std::string insertDefines(const std::string &source, const std::string &defines)
+{
+    if (defines.empty())
+        return source;
+    size_t version = source.find("#version");
+    if (version == std::string::npos)
+        return defines + source;
+    size_t lineEnd = source.find('\n', version);
+    if (lineEnd == std::string::npos)
+        return source + "\n" + defines;
+    return source.substr(0, lineEnd + 1) + defines + source.substr(lineEnd + 1);
+}
+
+class ProgramCache
+{
+public:
+    // path: the cache file, created on the first build; empty to always compile
+    explicit ProgramCache(const std::string &path) : path(path) {}
+
+    ProgramCache(const ProgramCache &) = delete;
+    ProgramCache &operator=(const ProgramCache &) = delete;
+
+    // registers a program (the geometry shader is optional, as in Shader's constructor); its ID is 0 until
+    // build(). The reference stays valid as long as the cache.
+    ShaderProgram &add(const std::string &vertexPath, const std::string &fragmentPath,
+                       const std::string &geometryPath = std::string(), const std::string &defines = std::string())
+    {
+        std::unique_ptr<Entry> entry(new Entry());
+        entry->vertexPath = vertexPath;
+        entry->fragmentPath = fragmentPath;
+        entry->geometryPath = geometryPath;
+        entry->defines = defines;
+        entries.push_back(std::move(entry));
+        return entries.back()->program;
+    }
+
+    // loads or compiles every program added since the last build; GL thread only. false if any of them
+    // failed (the log is on stdout and its ID stays 0).
+    bool build()
+    {
+        const ProgramBinaryProcs &procs = programBinaryProcs();
+        uint64_t contextKey = programContextKey();
+        MappedFile mapping;
+        std::vector<const ProgramBinaryRecord *> cached;
+        if (procs.binaries() && !path.empty())
+            readCache(mapping, contextKey, cached);
+
+        bool ok = true;
+        std::vector<Entry *> pending;
+        for (auto &entry : entries)
+        {
+            if (entry->state != Entry::ADDED)
+                continue;
+            if (!readSources(*entry))
+            {
+                entry->state = Entry::FAILED;
+                ok = false;
+                continue;
+            }
+            if (loadBinary(*entry, cached))
+                continue;
+            startCompile(*entry);
+            pending.push_back(entry.get());
+        }
+        // every compile is in flight before the first link, and every link before the first status query
+        for (Entry *entry : pending)
+            startLink(*entry);
+        bool compiled = !pending.empty();
+        while (!pending.empty())
+        {
+            bool progress = false;
+            for (size_t i = 0; i < pending.size();)
+            {
+                if (!linkComplete(*pending[i]))
+                {
+                    ++i;
+                    continue;
+                }
+                ok = finishLink(*pending[i]) && ok;
+                pending[i] = pending.back();
+                pending.pop_back();
+                progress = true;
+            }
+            if (!progress)
+                std::this_thread::yield();
+        }
+
+        mapping.close();
+        if (compiled && procs.binaries() && !path.empty() && !writeCache(contextKey))
+            std::cout << "Program cache could not be written: " << path << std::endl;
+        return ok;
+    }
+
+    size_t programCount() const { return entries.size(); }
+    size_t loadedBinaries() const { return loaded; }
+    size_t rejectedBinaries() const { return rejected; }
+    size_t compiledPrograms() const { return compiledCount; }
+
+private:
+    struct Entry
+    {
+        enum State { ADDED, READY, FAILED };
+
+        ShaderProgram program;
+        std::string vertexPath, fragmentPath, geometryPath, defines;
+        std::string vertexSource, fragmentSource, geometrySource;
+        uint64_t sourceKey = 0;
+        GLuint vertex = 0, fragment = 0, geometry = 0;
+        State state = ADDED;
+    };
+
+    std::string path;
+    std::vector<std::unique_ptr<Entry>> entries;
+    size_t loaded = 0;
+    size_t rejected = 0;
+    size_t compiledCount = 0;
+
+    static uint64_t programContextKey()
+    {
+        uint64_t hash = FNV_OFFSET_BASIS;
+        fnv1a(hash, &PROGRAM_CACHE_VERSION, sizeof(PROGRAM_CACHE_VERSION));
+        const GLenum names[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+        for (GLenum name : names)
+        {
+            const char *value = reinterpret_cast<const char *>(glGetString(name));
+            if (value)
+                fnv1a(hash, value, std::strlen(value) + 1);
+        }
+        return hash;
+    }
+
+    static bool readFile(const std::string &filePath, std::string &text)
+    {
+        std::ifstream file(filePath, std::ios::binary);
+        if (!file)
+            return false;
+        std::stringstream stream;
+        stream << file.rdbuf();
+        text = stream.str();
+        return true;
+    }
+
+    static bool readSources(Entry &entry)
+    {
+        std::string vertex, fragment, geometry;
+        if (!readFile(entry.vertexPath, vertex) || !readFile(entry.fragmentPath, fragment) ||
+            (!entry.geometryPath.empty() && !readFile(entry.geometryPath, geometry)))
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << entry.vertexPath << ", "
+                      << entry.fragmentPath << (entry.geometryPath.empty() ? "" : ", ") << entry.geometryPath
+                      << std::endl;
+            return false;
+        }
+        entry.vertexSource = insertDefines(vertex, entry.defines);
+        entry.fragmentSource = insertDefines(fragment, entry.defines);
+        if (!entry.geometryPath.empty())
+            entry.geometrySource = insertDefines(geometry, entry.defines);
+        uint64_t hash = FNV_OFFSET_BASIS;
+        fnv1a(hash, entry.vertexSource.data(), entry.vertexSource.size() + 1);
+        fnv1a(hash, entry.fragmentSource.data(), entry.fragmentSource.size() + 1);
+        fnv1a(hash, entry.geometrySource.data(), entry.geometrySource.size() + 1);
+        entry.sourceKey = hash;
+        return true;
+    }
+
+    // the records of a cache file written under the same context; the mapping keeps them readable
+    void readCache(MappedFile &mapping, uint64_t contextKey, std::vector<const ProgramBinaryRecord *> &cached)
+    {
+        if (!mapping.open(path) || mapping.size() < sizeof(ProgramCacheHeader))
+            return;
+        ProgramCacheHeader header;
+        std::memcpy(&header, mapping.data(), sizeof(header));
+        if (std::memcmp(header.magic, "PPRG", 4) != 0 || header.version != PROGRAM_CACHE_VERSION ||
+            header.contextKey != contextKey)
+            return;
+        size_t offset = sizeof(header);
+        for (uint32_t i = 0; i < header.programCount; ++i)
+        {
+            if (offset + sizeof(ProgramBinaryRecord) > mapping.size())
+                break;
+            const ProgramBinaryRecord *record = reinterpret_cast<const ProgramBinaryRecord *>(mapping.data() + offset);
+            offset += sizeof(ProgramBinaryRecord);
+            if (offset + record->length > mapping.size())
+                break;
+            cached.push_back(record);
+            offset += (record->length + 7u) & ~size_t(7);
+        }
+    }
+
+    bool loadBinary(Entry &entry, const std::vector<const ProgramBinaryRecord *> &cached)
+    {
+        const ProgramBinaryProcs &procs = programBinaryProcs();
+        for (const ProgramBinaryRecord *record : cached)
+        {
+            if (record->sourceKey != entry.sourceKey)
+                continue;
+            GLuint program = glCreateProgram();
+            // so a later rewrite of the file can read this program back as well
+            procs.programParameteri(program, PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            procs.programBinary(program, record->format, record + 1, static_cast<GLsizei>(record->length));
+            GLint success = 0;
+            glGetProgramiv(program, GL_LINK_STATUS, &success);
+            if (!success)
+            {
+                glDeleteProgram(program);
+                ++rejected;
+                return false;
+            }
+            entry.program.ID = program;
+            entry.program.uniforms.load(program);
+            entry.state = Entry::READY;
+            ++loaded;
+            return true;
+        }
+        return false;
+    }
+
+    static GLuint startShader(GLenum type, const std::string &source)
+    {
+        GLuint shader = glCreateShader(type);
+        const char *text = source.c_str();
+        glShaderSource(shader, 1, &text, nullptr);
+        glCompileShader(shader);
+        return shader;
+    }
+
+    static void startCompile(Entry &entry)
+    {
+        entry.vertex = startShader(GL_VERTEX_SHADER, entry.vertexSource);
+        entry.fragment = startShader(GL_FRAGMENT_SHADER, entry.fragmentSource);
+        if (!entry.geometrySource.empty())
+            entry.geometry = startShader(GL_GEOMETRY_SHADER, entry.geometrySource);
+    }
+
+    static void startLink(Entry &entry)
+    {
+        const ProgramBinaryProcs &procs = programBinaryProcs();
+        GLuint program = glCreateProgram();
+        glAttachShader(program, entry.vertex);
+        glAttachShader(program, entry.fragment);
+        if (entry.geometry != 0)
+            glAttachShader(program, entry.geometry);
+        if (procs.binaries())
+            procs.programParameteri(program, PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(program);
+        entry.program.ID = program;
+    }
+
+    // without the extension there is nothing to poll: the status queries below simply wait
+    static bool linkComplete(const Entry &entry)
+    {
+        if (!programBinaryProcs().parallelCompile)
+            return true;
+        GLint complete = 0;
+        glGetProgramiv(entry.program.ID, COMPLETION_STATUS, &complete);
+        return complete != 0;
+    }
+
+    static bool shaderCompiled(GLuint shader, const char *type)
+    {
+        GLint success = 0;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (success)
+            return true;
+        GLchar infoLog[1024];
+        glGetShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
+        std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << std::endl;
+        return false;
+    }
+
+    bool finishLink(Entry &entry)
+    {
+        GLuint program = entry.program.ID;
+        bool ok = shaderCompiled(entry.vertex, "VERTEX") && shaderCompiled(entry.fragment, "FRAGMENT") &&
+                  (entry.geometry == 0 || shaderCompiled(entry.geometry, "GEOMETRY"));
+        GLint success = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (ok && !success)
+        {
+            GLchar infoLog[1024];
+            glGetProgramInfoLog(program, sizeof(infoLog), nullptr, infoLog);
+            std::cout << "ERROR::PROGRAM_LINKING_ERROR: " << entry.vertexPath << ", " << entry.fragmentPath << "\n"
+                      << infoLog << std::endl;
+            ok = false;
+        }
+        for (GLuint shader : { entry.vertex, entry.fragment, entry.geometry })
+        {
+            if (shader == 0)
+                continue;
+            glDetachShader(program, shader);
+            glDeleteShader(shader);
+        }
+        entry.vertex = entry.fragment = entry.geometry = 0;
+        if (!ok)
+        {
+            glDeleteProgram(program);
+            entry.program.ID = 0;
+            entry.state = Entry::FAILED;
+            return false;
+        }
+        entry.program.uniforms.load(program);
+        entry.state = Entry::READY;
+        ++compiledCount;
+        return true;
+    }
+
+    // every ready program, read back from the driver; written next to the file and renamed over it
+    bool writeCache(uint64_t contextKey) const
+    {
+        const ProgramBinaryProcs &procs = programBinaryProcs();
+        std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file)
+                return false;
+            ProgramCacheHeader header = {};
+            std::memcpy(header.magic, "PPRG", 4);
+            header.version = PROGRAM_CACHE_VERSION;
+            header.contextKey = contextKey;
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+            std::vector<char> binary;
+            const char zeros[8] = {};
+            for (auto &entry : entries)
+            {
+                if (entry->state != Entry::READY)
+                    continue;
+                GLint length = 0;
+                glGetProgramiv(entry->program.ID, PROGRAM_BINARY_LENGTH, &length);
+                if (length <= 0)
+                    continue;
+                binary.resize(static_cast<size_t>(length));
+                GLsizei written = 0;
+                GLenum format = 0;
+                procs.getProgramBinary(entry->program.ID, length, &written, &format, binary.data());
+                if (written <= 0)
+                    continue;
+                ProgramBinaryRecord record = { entry->sourceKey, format, static_cast<uint32_t>(written) };
+                file.write(reinterpret_cast<const char *>(&record), sizeof(record));
+                file.write(binary.data(), written);
+                file.write(zeros, (8 - written % 8) % 8);
+                ++header.programCount;
+            }
+            file.seekp(0);
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            if (!file)
+                return false;
+        }
+        std::remove(path.c_str()); // rename() doesn't replace on Windows
+        return std::rename(tempPath.c_str(), path.c_str()) == 0;
+    }
+};
+
+#endif
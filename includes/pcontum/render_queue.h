@@ -0,0 +1,210 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <pcontum/shader_program.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+// The frame is described as draw packets (pass, material, transform, draw call)
+// instead of being drawn in place. flush() sorts the packets by one 64-bit key and walks them in order,
+// switching program and texture bindings only when the next packet actually needs something else.
+//
+// Key layout, most significant first:
+//   pass (4 bits) | shader (8 bits) | material (16 bits) | depth (32 bits) | unused (4 bits)
+// so packets group by pass, then program, then texture set, and front to back inside a texture set.
+// Ties keep their submission order.
+
+enum RenderPass
+{
+    RENDER_PASS_OPAQUE = 0,
+    RENDER_PASS_SKY = 1, // after the opaque geometry, so the depth test rejects covered sky pixels
+};
+
+// one texture a material needs on a unit
+struct TextureBinding
+{
+    unsigned int unit;
+    GLenum target;
+    unsigned int id;
+};
+
+// what flush() did in the last frame, next to what drawing every packet on its own would have cost
+struct RenderQueueStats
+{
+    size_t packets = 0;
+    size_t shaderBinds = 0;
+    size_t textureBinds = 0;
+    size_t naiveShaderBinds = 0;
+    size_t naiveTextureBinds = 0;
+
+    size_t stateChanges() const { return shaderBinds + textureBinds; }
+    size_t savedStateChanges() const { return naiveShaderBinds + naiveTextureBinds - stateChanges(); }
+};
+
+class RenderQueue
+{
+public:
+    typedef std::function<void(ShaderProgram &)> DrawFunction;
+
+    // perFrame runs the first time the program is bound in a frame (view, camera position, lights ...)
+    int addShader(ShaderProgram &shader, DrawFunction perFrame = DrawFunction())
+    {
+        shaders.push_back(ShaderEntry{ &shader, perFrame });
+        return static_cast<int>(shaders.size() - 1);
+    }
+
+    int addMaterial(int shader, const std::vector<TextureBinding> &textures)
+    {
+        materials.push_back(Material{ shader, textures });
+        return static_cast<int>(materials.size() - 1);
+    }
+
+    static uint64_t sortKey(int pass, int shader, int material, float depth)
+    {
+        // non-negative floats order the same as their bit patterns
+        uint32_t depthBits;
+        depth = std::max(depth, 0.0f);
+        std::memcpy(&depthBits, &depth, sizeof(depthBits));
+        return (uint64_t(pass & 0xf) << 60) | (uint64_t(shader & 0xff) << 52) | (uint64_t(material & 0xffff) << 36) |
+               (uint64_t(depthBits) << 4);
+    }
+
+    // starts a frame; depth is measured from viewPosition
+    void begin(const glm::vec3 &viewPosition)
+    {
+        this->viewPosition = viewPosition;
+        packets.clear();
+    }
+
+    // queues one draw. With a transform the packet sets "model" and "normalMatrix" and sorts by its distance.
+    // bindsTextures marks draws that bind textures themselves (mesh textures, texture arrays), after which
+    // the queue can no longer trust what it thinks is bound.
+    void submit(int pass, int material, const glm::mat4 *transform, DrawFunction draw, bool bindsTextures = false)
+    {
+        Packet packet;
+        float depth = transform ? glm::length(glm::vec3((*transform)[3]) - viewPosition) : 0.0f;
+        packet.key = sortKey(pass, materials[material].shader, material, depth);
+        packet.material = material;
+        packet.hasTransform = transform != nullptr;
+        if (transform)
+            packet.transform = *transform;
+        packet.draw = draw;
+        packet.bindsTextures = bindsTextures;
+        packets.push_back(packet);
+    }
+
+    // sorts and draws everything queued since begin()
+    void flush()
+    {
+        order.resize(packets.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return packets[a].key < packets[b].key; });
+
+        // nothing is assumed about the GL state left by the previous frame
+        lastStats = RenderQueueStats();
+        lastStats.packets = packets.size();
+        int currentShader = -1;
+        bound.clear();
+        std::vector<bool> shaderSetUp(shaders.size(), false);
+
+        for (size_t index : order)
+        {
+            Packet &packet = packets[index];
+            const Material &material = materials[packet.material];
+            ShaderEntry &entry = shaders[material.shader];
+            lastStats.naiveShaderBinds++;
+            lastStats.naiveTextureBinds += material.textures.size();
+
+            if (material.shader != currentShader)
+            {
+                entry.shader->use();
+                currentShader = material.shader;
+                lastStats.shaderBinds++;
+                if (!shaderSetUp[material.shader])
+                {
+                    shaderSetUp[material.shader] = true;
+                    if (entry.perFrame)
+                        entry.perFrame(*entry.shader);
+                }
+            }
+            for (const TextureBinding &texture : material.textures)
+                bindTexture(texture);
+
+            if (packet.hasTransform)
+            {
+                entry.shader->setMat4("model", packet.transform);
+                entry.shader->setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(packet.transform))));
+            }
+            packet.draw(*entry.shader);
+            if (packet.bindsTextures)
+                bound.clear();
+        }
+        glActiveTexture(GL_TEXTURE0);
+        packets.clear();
+    }
+
+    const RenderQueueStats &stats() const { return lastStats; }
+
+private:
+    struct ShaderEntry
+    {
+        ShaderProgram *shader;
+        DrawFunction perFrame;
+    };
+
+    struct Material
+    {
+        int shader;
+        std::vector<TextureBinding> textures;
+    };
+
+    struct Packet
+    {
+        uint64_t key = 0;
+        int material = 0;
+        bool hasTransform = false;
+        bool bindsTextures = false;
+        glm::mat4 transform;
+        DrawFunction draw;
+    };
+
+    std::vector<ShaderEntry> shaders;
+    std::vector<Material> materials;
+    std::vector<Packet> packets;
+    std::vector<size_t> order;
+    std::vector<TextureBinding> bound; // what the queue itself bound this frame, per unit and target
+    glm::vec3 viewPosition = glm::vec3(0.0f);
+    RenderQueueStats lastStats;
+
+    void bindTexture(const TextureBinding &texture)
+    {
+        for (TextureBinding &current : bound)
+        {
+            if (current.unit == texture.unit && current.target == texture.target)
+            {
+                if (current.id == texture.id)
+                    return;
+                current.id = texture.id;
+                glActiveTexture(GL_TEXTURE0 + texture.unit);
+                glBindTexture(texture.target, texture.id);
+                lastStats.textureBinds++;
+                return;
+            }
+        }
+        bound.push_back(texture);
+        glActiveTexture(GL_TEXTURE0 + texture.unit);
+        glBindTexture(texture.target, texture.id);
+        lastStats.textureBinds++;
+    }
+};
+
+#endif
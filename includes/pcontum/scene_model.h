@@ -0,0 +1,141 @@
+#ifndef SCENE_MODEL_H
+#define SCENE_MODEL_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/mesh.h>
+#include <pcontum/shader_program.h>
+
+#include <pcontum/culling.h>
+#include <pcontum/mesh_lod.h>
+#include <pcontum/skeletal_animation.h>
+#include <pcontum/vertex_format.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// GPU side of a loaded mesh. Same attribute locations and texture binding as learnopengl's Mesh, but in
+// the compact vertex format (vertex_format.h), and the vertices and indices are uploaded from wherever
+// they live (a parsed model or a mapped mesh cache) instead of being copied into member vectors first.
+// The element buffer holds the full mesh followed by its simplified levels; Draw() uses the full mesh,
+// lods[level - 1] says where the others are.
+struct SceneMesh
+{
+    unsigned int VAO = 0;
+    unsigned int VBO = 0;
+    unsigned int EBO = 0;
+    unsigned int vertexCount = 0;
+    unsigned int indexCount = 0;       // full detail
+    unsigned int bufferIndexCount = 0; // everything in the EBO, simplified levels included
+    std::vector<Texture> textures;
+    std::vector<std::string> samplerNames; // one per texture, built on the first bindTextures()
+    std::vector<MeshLod> lods;
+    VertexQuantization quantization;
+    Aabb bounds; // model space, for culling
+
+    void upload(const PackedVertex *vertices, size_t numVertices, const VertexQuantization &vertexQuantization,
+                const unsigned int *indices, size_t numIndices, const unsigned int *lodIndices = nullptr,
+                size_t numLodIndices = 0)
+    {
+        vertexCount = static_cast<unsigned int>(numVertices);
+        quantization = vertexQuantization;
+        bounds = quantization.bounds();
+        indexCount = static_cast<unsigned int>(numIndices);
+        bufferIndexCount = static_cast<unsigned int>(numIndices + numLodIndices);
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, numVertices * sizeof(PackedVertex), vertices, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, bufferIndexCount * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, numIndices * sizeof(unsigned int), indices);
+        if (numLodIndices)
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, numIndices * sizeof(unsigned int), numLodIndices * sizeof(unsigned int),
+                            lodIndices);
+
+        setupPackedVertexAttributes();
+        glBindVertexArray(0);
+    }
+
+    // binds the mesh textures as texture_diffuseN, texture_specularN, texture_normalN, texture_heightN
+    void bindTextures(ShaderProgram &shader)
+    {
+        if (samplerNames.size() != textures.size())
+            buildSamplerNames();
+        for (unsigned int i = 0; i < textures.size(); i++)
+        {
+            glActiveTexture(GL_TEXTURE0 + i);
+            shader.setInt(samplerNames[i].c_str(), i);
+            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+        }
+    }
+
+    void buildSamplerNames()
+    {
+        unsigned int diffuseNr = 1;
+        unsigned int specularNr = 1;
+        unsigned int normalNr = 1;
+        unsigned int heightNr = 1;
+        samplerNames.clear();
+        for (const Texture &texture : textures)
+        {
+            std::string number;
+            const std::string &name = texture.type;
+            if (name == "texture_diffuse")
+                number = std::to_string(diffuseNr++);
+            else if (name == "texture_specular")
+                number = std::to_string(specularNr++);
+            else if (name == "texture_normal")
+                number = std::to_string(normalNr++);
+            else if (name == "texture_height")
+                number = std::to_string(heightNr++);
+            samplerNames.push_back(name + number);
+        }
+    }
+
+    void Draw(ShaderProgram &shader)
+    {
+        bindTextures(shader);
+        shader.setMat4("positionDequantize", quantization.matrix());
+        glBindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, 0);
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+};
+
+// a loaded model; same Draw() as learnopengl's Model, but its meshes can be created after the fact
+struct SceneModel
+{
+    std::vector<SceneMesh> meshes;
+    std::string directory;
+    ModelAnimation animation; // skeleton and clips; the meshes' bone ids are its joint indices
+
+    // simplification error of every level for the model as a whole (the worst of its meshes); level 0 is 0
+    std::vector<float> lodErrors() const
+    {
+        std::vector<float> errors(1, 0.0f);
+        for (const SceneMesh &mesh : meshes)
+        {
+            if (errors.size() < mesh.lods.size() + 1)
+                errors.resize(mesh.lods.size() + 1, 0.0f);
+            for (size_t level = 0; level < mesh.lods.size(); ++level)
+                errors[level + 1] = std::max(errors[level + 1], mesh.lods[level].error);
+        }
+        return errors;
+    }
+
+    void Draw(ShaderProgram &shader)
+    {
+        for (unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].Draw(shader);
+    }
+};
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef SH_IRRADIANCE_H
+#define SH_IRRADIANCE_H
+
+#include <pcontum/ibl_bake_cpu.h>
+#include <pcontum/ibl_cache.h>
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstdint>
+
+// The environment projected onto the 9 real SH basis functions and convolved with
+// the clamped cosine lobe (Ramamoorthi & Hanrahan). 2.2.2.pbr.fs evaluates the 9 RGB coefficients
+// per fragment instead of sampling the irradiance cubemap. The coefficients are scaled to match the
+// convolution cubemap, which stores irradiance / PI.
+struct ShIrradiance
+{
+    glm::vec3 coefficients[9];
+};
+
+// real SH basis, bands 0..2, same order and constants as evaluateShIrradiance() in 2.2.2.pbr.fs
+inline void shBasis(const glm::vec3 &n, float basis[9])
+{
+    basis[0] = 0.282095f;
+    basis[1] = 0.488603f * n.y;
+    basis[2] = 0.488603f * n.z;
+    basis[3] = 0.488603f * n.x;
+    basis[4] = 1.092548f * n.x * n.y;
+    basis[5] = 1.092548f * n.y * n.z;
+    basis[6] = 0.315392f * (3.0f * n.z * n.z - 1.0f);
+    basis[7] = 1.092548f * n.x * n.z;
+    basis[8] = 0.546274f * (n.x * n.x - n.y * n.y);
+}
+
+// projects one mip of a cached environment cubemap. A 32x32 face is plenty for band 2; the mip is
+// clamped to what the image has.
+inline ShIrradiance projectIrradianceSh(const IblImage &environment, uint32_t mip)
+{
+    ShIrradiance sh;
+    for (glm::vec3 &c : sh.coefficients)
+        c = glm::vec3(0.0f);
+    if (!environment.cubemap || environment.levels.empty())
+        return sh;
+    if (mip >= environment.levels.size())
+        mip = static_cast<uint32_t>(environment.levels.size() - 1);
+
+    uint32_t size = environment.levelWidth(mip);
+    const std::vector<uint16_t> &texels = environment.levels[mip];
+    float texelArea = (2.0f / size) * (2.0f / size);
+    float totalWeight = 0.0f;
+    for (uint32_t face = 0; face < 6; ++face)
+    {
+        for (uint32_t y = 0; y < size; ++y)
+        {
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                glm::vec3 dir = cubeTexelDirection(face, x, y, size);
+                // solid angle of the texel: projected area falls off with the cube of the distance
+                float lengthSquared = glm::dot(dir, dir);
+                float weight = texelArea / (lengthSquared * std::sqrt(lengthSquared));
+                glm::vec3 n = dir / std::sqrt(lengthSquared);
+
+                const uint16_t *texel = texels.data() + ((size_t(face) * size + y) * size + x) * environment.channels;
+                glm::vec3 radiance(halfToFloat(texel[0]), halfToFloat(texel[1]), halfToFloat(texel[2]));
+
+                float basis[9];
+                shBasis(n, basis);
+                for (int i = 0; i < 9; ++i)
+                    sh.coefficients[i] += radiance * (basis[i] * weight);
+                totalWeight += weight;
+            }
+        }
+    }
+
+    // the texel weights sum to slightly less than 4*PI; renormalise, then apply the cosine lobe per band
+    // (PI, 2PI/3, PI/4), divided by PI to land in the same units as the irradiance cubemap
+    const float band[9] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+    float normalization = 4.0f * IBL_PI / totalWeight;
+    for (int i = 0; i < 9; ++i)
+        sh.coefficients[i] *= normalization * band[i];
+    return sh;
+}
+
+// mip of a cubemap whose faces are closest to (but not below) the given size
+inline uint32_t mipForFaceSize(uint32_t baseSize, uint32_t faceSize)
+{
+    uint32_t mip = 0;
+    while ((baseSize >> (mip + 1)) >= faceSize)
+        mip++;
+    return mip;
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef SHADER_PROGRAM_H
+#define SHADER_PROGRAM_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <pcontum/uniform_cache.h>
+
+#include <string>
+
+// A linked program with the same interface as learnopengl's Shader (public ID, use(), the
+// setters), but built from outside: ProgramCache (program_cache.h) fills in ID, either from a cached program
+// binary or by compiling the sources, and then reads the uniform locations into uniforms. learnopengl's
+// Shader always compiles and links in its constructor, so it can't be loaded from a binary. The setters look
+// names up in that table instead of calling glGetUniformLocation; the std::string overloads are for names
+// built at run time ("shIrradiance[3]").
+class ShaderProgram
+{
+public:
+    unsigned int ID = 0;
+    UniformCache uniforms; // empty until the program is ready
+
+    // like Shader, the program is not deleted here: these live until glfwTerminate has taken the context
+    ShaderProgram() {}
+
+    ShaderProgram(const ShaderProgram &) = delete;
+    ShaderProgram &operator=(const ShaderProgram &) = delete;
+
+    void use() const { glUseProgram(ID); }
+
+    void setBool(const char *name, bool value) const { uniforms.setBool(name, value); }
+    void setInt(const char *name, int value) const { uniforms.setInt(name, value); }
+    void setFloat(const char *name, float value) const { uniforms.setFloat(name, value); }
+    void setVec2(const char *name, const glm::vec2 &value) const { uniforms.setVec2(name, value); }
+    void setVec3(const char *name, const glm::vec3 &value) const { uniforms.setVec3(name, value); }
+    void setVec4(const char *name, const glm::vec4 &value) const { uniforms.setVec4(name, value); }
+    void setMat3(const char *name, const glm::mat3 &mat) const { uniforms.setMat3(name, mat); }
+    void setMat4(const char *name, const glm::mat4 &mat) const { uniforms.setMat4(name, mat); }
+
+    void setBool(const std::string &name, bool value) const { setBool(name.c_str(), value); }
+    void setInt(const std::string &name, int value) const { setInt(name.c_str(), value); }
+    void setFloat(const std::string &name, float value) const { setFloat(name.c_str(), value); }
+    void setVec2(const std::string &name, const glm::vec2 &value) const { setVec2(name.c_str(), value); }
+    void setVec3(const std::string &name, const glm::vec3 &value) const { setVec3(name.c_str(), value); }
+    void setVec4(const std::string &name, const glm::vec4 &value) const { setVec4(name.c_str(), value); }
+    void setMat3(const std::string &name, const glm::mat3 &mat) const { setMat3(name.c_str(), mat); }
+    void setMat4(const std::string &name, const glm::mat4 &mat) const { setMat4(name.c_str(), mat); }
+};
+
+#endif
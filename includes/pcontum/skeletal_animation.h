@@ -0,0 +1,304 @@
+#ifndef SKELETAL_ANIMATION_H
+#define SKELETAL_ANIMATION_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <pcontum/culling.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The CPU half of GPU skinning. A skeleton is the joint hierarchy of a model, a clip
+// is a set of keyframe tracks over its joints. Every animated instance samples one or two clips into
+// local poses (translation, rotation, scale per joint), blends them, and turns the result into a palette
+// of world-space skinning matrices. The palettes of all instances go to the GPU in one texture buffer
+// (skeletal_animation_gl.h) and the vertex shader blends up to four of them per vertex (2.2.2.pbr.vs).
+//
+// Joint indices are what PackedVertex::boneIds holds, so a skeleton has at most 255 joints
+// (255 is "no bone"). The import from Assimp is in model_data.h.
+
+const size_t MAX_SKELETON_JOINTS = 255;
+
+// texels (rows of a 3x4 affine matrix) per palette matrix
+const size_t SKIN_PALETTE_TEXELS = 3;
+
+// local transform of every joint, one vec4 each: translation (w unused), rotation (quaternion as x, y,
+// z, w) and scale (w unused). Same layout for every component so a blend is one SIMD lerp per vec4.
+struct Pose
+{
+    std::vector<glm::vec4> translations;
+    std::vector<glm::vec4> rotations;
+    std::vector<glm::vec4> scales;
+
+    size_t size() const { return translations.size(); }
+
+    void resize(size_t joints)
+    {
+        translations.resize(joints);
+        rotations.resize(joints);
+        scales.resize(joints);
+    }
+};
+
+struct Skeleton
+{
+    std::vector<std::string> names;
+    std::vector<int32_t> parents;   // -1 for the root; a parent always comes before its children
+    std::vector<glm::mat4> offsets; // mesh space to joint space at bind time; identity for joints no vertex uses
+    Pose bindPose;                  // node transforms, for the joints a clip doesn't animate
+    glm::mat4 globalInverse = glm::mat4(1.0f); // undoes the root node's transform
+
+    size_t size() const { return parents.size(); }
+    bool empty() const { return parents.empty(); }
+
+    // -1 if there is no such joint
+    int find(const std::string &name) const
+    {
+        for (size_t i = 0; i < names.size(); ++i)
+            if (names[i] == name)
+                return static_cast<int>(i);
+        return -1;
+    }
+};
+
+// keys of one component of one joint: a range in the clip's key arrays
+struct AnimationChannel
+{
+    uint32_t firstKey = 0;
+    uint32_t keyCount = 0;
+};
+
+enum AnimationComponent
+{
+    ANIMATION_TRANSLATION = 0,
+    ANIMATION_ROTATION = 1,
+    ANIMATION_SCALE = 2,
+};
+
+struct AnimationTrack
+{
+    uint32_t joint = 0;
+    AnimationChannel channels[3]; // AnimationComponent order
+};
+
+// keys of all tracks in two flat arrays; times are in seconds, values use the Pose layout
+struct AnimationClip
+{
+    std::string name;
+    float duration = 0.0f;
+    std::vector<AnimationTrack> tracks;
+    std::vector<float> keyTimes;
+    std::vector<glm::vec4> keyValues;
+};
+
+struct ModelAnimation
+{
+    Skeleton skeleton;
+    std::vector<AnimationClip> clips;
+
+    bool empty() const { return skeleton.empty() || clips.empty(); }
+
+    // -1 if there is no such clip
+    int findClip(const std::string &name) const
+    {
+        for (size_t i = 0; i < clips.size(); ++i)
+            if (clips[i].name == name)
+                return static_cast<int>(i);
+        return -1;
+    }
+};
+
+// where each channel of a clip was sampled last. Playback moves forward in small steps, so the next key
+// is almost always the current one or the one after it: no binary search over the keys.
+struct AnimationCursor
+{
+    const AnimationClip *clip = nullptr;
+    std::vector<uint32_t> keys; // per track and component, relative to the channel's first key
+
+    void reset(const AnimationClip &target)
+    {
+        clip = &target;
+        keys.assign(target.tracks.size() * 3, 0);
+    }
+};
+
+// the key at or before time, walking on from where the cursor stopped; back to the start after a loop
+inline uint32_t seekKey(const float *times, uint32_t count, float time, uint32_t &cursor)
+{
+    if (cursor >= count || times[cursor] > time)
+        cursor = 0;
+    while (cursor + 1 < count && times[cursor + 1] <= time)
+        ++cursor;
+    return cursor;
+}
+
+inline glm::vec4 sampleChannel(const AnimationClip &clip, const AnimationChannel &channel, AnimationComponent component,
+                               float time, uint32_t &cursor)
+{
+    const float *times = clip.keyTimes.data() + channel.firstKey;
+    const glm::vec4 *values = clip.keyValues.data() + channel.firstKey;
+    uint32_t key = seekKey(times, channel.keyCount, time, cursor);
+    if (key + 1 >= channel.keyCount || time <= times[key])
+        return values[key];
+
+    float t = (time - times[key]) / (times[key + 1] - times[key]);
+    if (component != ANIMATION_ROTATION)
+        return values[key] + (values[key + 1] - values[key]) * t;
+    const glm::vec4 &a = values[key];
+    const glm::vec4 &b = values[key + 1];
+    glm::quat q = glm::slerp(glm::quat(a.w, a.x, a.y, a.z), glm::quat(b.w, b.x, b.y, b.z), t);
+    return glm::vec4(q.x, q.y, q.z, q.w);
+}
+
+// the clip at time (looped over its duration) into pose; joints without a track keep their bind pose
+inline void sampleClip(const Skeleton &skeleton, const AnimationClip &clip, float time, AnimationCursor &cursor, Pose &pose)
+{
+    if (cursor.clip != &clip)
+        cursor.reset(clip);
+    if (clip.duration > 0.0f)
+    {
+        time = std::fmod(time, clip.duration);
+        if (time < 0.0f)
+            time += clip.duration;
+    }
+
+    pose = skeleton.bindPose;
+    for (size_t i = 0; i < clip.tracks.size(); ++i)
+    {
+        const AnimationTrack &track = clip.tracks[i];
+        if (track.joint >= pose.size())
+            continue;
+        std::vector<glm::vec4> *components[] = { &pose.translations, &pose.rotations, &pose.scales };
+        for (int c = 0; c < 3; ++c)
+        {
+            if (track.channels[c].keyCount == 0)
+                continue;
+            (*components[c])[track.joint] =
+                sampleChannel(clip, track.channels[c], static_cast<AnimationComponent>(c), time, cursor.keys[i * 3 + c]);
+        }
+    }
+}
+
+// out = a * (1 - weight) + b * weight, with rotations normalized (nlerp) along the shorter arc.
+// out may be a or b.
+inline void blendPoses(const Pose &a, const Pose &b, float weight, Pose &out)
+{
+    size_t count = std::min(a.size(), b.size());
+    out.resize(count);
+#ifdef PCONTUM_CULL_SSE
+    const __m128 wa = _mm_set1_ps(1.0f - weight);
+    const __m128 wb = _mm_set1_ps(weight);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    auto lerp = [&](const glm::vec4 &x, const glm::vec4 &y, glm::vec4 &result) {
+        __m128 value = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&x.x), wa), _mm_mul_ps(_mm_loadu_ps(&y.x), wb));
+        _mm_storeu_ps(&result.x, value);
+    };
+    // the dot product ends up in every lane
+    auto dot4 = [](__m128 x, __m128 y) {
+        __m128 product = _mm_mul_ps(x, y);
+        __m128 sum = _mm_add_ps(product, _mm_shuffle_ps(product, product, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    };
+    for (size_t i = 0; i < count; ++i)
+    {
+        lerp(a.translations[i], b.translations[i], out.translations[i]);
+        lerp(a.scales[i], b.scales[i], out.scales[i]);
+
+        __m128 qa = _mm_loadu_ps(&a.rotations[i].x);
+        __m128 qb = _mm_loadu_ps(&b.rotations[i].x);
+        // q and -q are the same rotation; take the one on a's side
+        qb = _mm_xor_ps(qb, _mm_and_ps(dot4(qa, qb), signBit));
+        __m128 q = _mm_add_ps(_mm_mul_ps(qa, wa), _mm_mul_ps(qb, wb));
+        __m128 length = _mm_sqrt_ps(dot4(q, q));
+        _mm_storeu_ps(&out.rotations[i].x, _mm_div_ps(q, _mm_max_ps(length, _mm_set1_ps(1e-8f))));
+    }
+#else
+    for (size_t i = 0; i < count; ++i)
+    {
+        out.translations[i] = a.translations[i] * (1.0f - weight) + b.translations[i] * weight;
+        out.scales[i] = a.scales[i] * (1.0f - weight) + b.scales[i] * weight;
+        glm::vec4 qb = b.rotations[i];
+        if (glm::dot(a.rotations[i], qb) < 0.0f)
+            qb = qb * -1.0f;
+        glm::vec4 q = a.rotations[i] * (1.0f - weight) + qb * weight;
+        float length = std::sqrt(glm::dot(q, q));
+        out.rotations[i] = q * (1.0f / std::max(length, 1e-8f));
+    }
+#endif
+}
+
+// translate * rotate * scale from the Pose components
+inline glm::mat4 composeJoint(const glm::vec4 &translation, const glm::vec4 &rotation, const glm::vec4 &scale)
+{
+    glm::mat3 r = glm::mat3_cast(glm::quat(rotation.w, rotation.x, rotation.y, rotation.z));
+    return glm::mat4(glm::vec4(r[0] * scale.x, 0.0f), glm::vec4(r[1] * scale.y, 0.0f), glm::vec4(r[2] * scale.z, 0.0f),
+                     glm::vec4(glm::vec3(translation), 1.0f));
+}
+
+// palette matrices per instance: slot 0 is the bare model matrix (for vertices without bones), joint j
+// is slot 1 + j
+inline size_t skinPaletteSize(const Skeleton &skeleton)
+{
+    return skeleton.size() + 1;
+}
+
+// pose -> world-space skinning matrices as rows of 3x4 affine matrices, skinPaletteSize() *
+// SKIN_PALETTE_TEXELS texels. globals is scratch, kept by the caller between frames.
+inline void buildSkinPalette(const Skeleton &skeleton, const Pose &pose, const glm::mat4 &model,
+                             std::vector<glm::mat4> &globals, glm::vec4 *palette)
+{
+    auto writeRows = [](const glm::mat4 &m, glm::vec4 *rows) {
+        for (int row = 0; row < 3; ++row)
+            rows[row] = glm::vec4(m[0][row], m[1][row], m[2][row], m[3][row]);
+    };
+    writeRows(model, palette);
+
+    globals.resize(skeleton.size());
+    glm::mat4 root = model * skeleton.globalInverse;
+    for (size_t j = 0; j < skeleton.size(); ++j)
+    {
+        glm::mat4 local = composeJoint(pose.translations[j], pose.rotations[j], pose.scales[j]);
+        int parent = skeleton.parents[j];
+        globals[j] = parent < 0 ? root * local : globals[static_cast<size_t>(parent)] * local;
+        writeRows(globals[j] * skeleton.offsets[j], palette + (j + 1) * SKIN_PALETTE_TEXELS);
+    }
+}
+
+// what an animated instance keeps between frames: a cursor and a pose per clip layer, the blended pose
+// and the palette scratch
+struct SkinnedInstance
+{
+    AnimationCursor cursors[2];
+    Pose layers[2];
+    Pose pose;
+    std::vector<glm::mat4> globals;
+
+    // baseClip at time, blended towards overlayClip by overlayWeight (skipped at 0 or with overlayClip -1),
+    // into palette (skinPaletteSize() * SKIN_PALETTE_TEXELS texels). Instances are independent, so any
+    // number of them can be evaluated in parallel.
+    void evaluate(const ModelAnimation &animation, int baseClip, int overlayClip, float time, float overlayWeight,
+                  const glm::mat4 &model, glm::vec4 *palette)
+    {
+        const Skeleton &skeleton = animation.skeleton;
+        const Pose *result = &skeleton.bindPose;
+        if (baseClip >= 0 && baseClip < static_cast<int>(animation.clips.size()))
+        {
+            sampleClip(skeleton, animation.clips[static_cast<size_t>(baseClip)], time, cursors[0], layers[0]);
+            result = &layers[0];
+        }
+        if (overlayClip >= 0 && overlayClip < static_cast<int>(animation.clips.size()) && overlayWeight > 0.0f)
+        {
+            sampleClip(skeleton, animation.clips[static_cast<size_t>(overlayClip)], time, cursors[1], layers[1]);
+            blendPoses(*result, layers[1], std::min(overlayWeight, 1.0f), pose);
+            result = &pose;
+        }
+        buildSkinPalette(skeleton, *result, model, globals, palette);
+    }
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef SKELETAL_ANIMATION_GL_H
+#define SKELETAL_ANIMATION_GL_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <pcontum/shader_program.h>
+#include <pcontum/skeletal_animation.h>
+
+#include <algorithm>
+#include <vector>
+
+// GL side of the skinning palettes: every instance's matrices in one texture buffer, respecified once per
+// frame. A skinned MultiDrawList instance carries the index of its first palette matrix (see
+// MultiDrawList::add), so any number of instances and meshes draw from the same upload.
+class SkinPaletteBuffer
+{
+public:
+    // texture unit, above the light clusters
+    static const int PALETTE_UNIT = 13;
+
+    SkinPaletteBuffer()
+    {
+        glGenBuffers(1, &buffer);
+        glGenTextures(1, &texture);
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    ~SkinPaletteBuffer() { release(); }
+
+    // deletes the buffer and its texture view; called by the owner while the GL context is still current
+    void release()
+    {
+        if (!buffer)
+            return;
+        glDeleteTextures(1, &texture);
+        glDeleteBuffers(1, &buffer);
+        texture = buffer = 0;
+    }
+
+    SkinPaletteBuffer(const SkinPaletteBuffer &) = delete;
+    SkinPaletteBuffer &operator=(const SkinPaletteBuffer &) = delete;
+
+    // palette rows as written by buildSkinPalette(); orphaned like the light cluster buffers
+    void upload(const std::vector<glm::vec4> &palettes)
+    {
+        size_t size = palettes.size() * sizeof(glm::vec4);
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glBufferData(GL_TEXTURE_BUFFER, std::max<size_t>(size, 16), nullptr, GL_STREAM_DRAW);
+        if (size > 0)
+            glBufferSubData(GL_TEXTURE_BUFFER, 0, size, palettes.data());
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    // the shader must be in use
+    void bind(ShaderProgram &shader) const
+    {
+        glActiveTexture(GL_TEXTURE0 + PALETTE_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+        glActiveTexture(GL_TEXTURE0);
+        shader.setInt("bonePalettes", PALETTE_UNIT);
+    }
+
+private:
+    unsigned int buffer = 0;
+    unsigned int texture = 0;
+};
+
+#endif
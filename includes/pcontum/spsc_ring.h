@@ -0,0 +1,67 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// A fixed-size queue between exactly one producing and one
+// consuming thread, without locks. Each side only writes its own index; the release store of an index
+// publishes the slot written (or freed) before it, and the other side's acquire load picks that up.
+// A full ring refuses new items instead of overwriting, so the producer never waits on the consumer.
+template <typename T>
+class SpscRing
+{
+public:
+    // capacity is rounded up to a power of two
+    explicit SpscRing(size_t capacity)
+    {
+        size_t size = 1;
+        while (size < capacity)
+            size *= 2;
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    // producer only; false (and nothing stored) when the ring is full
+    bool push(const T &item)
+    {
+        size_t head = writeIndex.load(std::memory_order_relaxed);
+        if (head - readIndex.load(std::memory_order_acquire) == slots.size())
+            return false;
+        slots[head & mask] = item;
+        writeIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer only; false when the ring is empty
+    bool pop(T &item)
+    {
+        size_t tail = readIndex.load(std::memory_order_relaxed);
+        if (tail == writeIndex.load(std::memory_order_acquire))
+            return false;
+        item = slots[tail & mask];
+        readIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // a snapshot; exact only on a side that the other one isn't racing
+    size_t size() const
+    {
+        return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return slots.size(); }
+
+private:
+    std::vector<T> slots;
+    size_t mask = 0;
+    // on separate cache lines, so the two threads don't invalidate each other's line on every item
+    alignas(64) std::atomic<size_t> writeIndex{ 0 };
+    alignas(64) std::atomic<size_t> readIndex{ 0 };
+};
+
+#endif
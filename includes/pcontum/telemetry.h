@@ -0,0 +1,186 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <pcontum/flight_model.h>
+#include <pcontum/mapped_file.h>
+#include <pcontum/spsc_ring.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One fixed-size binary record per simulation tick instead of a line on stdout. The sim
+// thread only copies the record into a lock-free ring; a background thread drains the ring to disk in
+// batches, so the game loop never waits on file or terminal I/O. tools__telemetry_to_csv turns a file
+// back into CSV.
+//
+// File layout (native endianness, like the mesh cache):
+//   TelemetryHeader
+//   TelemetryRecord[...]   as many as were written; a torn record at the end (crash) is ignored
+
+const uint32_t TELEMETRY_VERSION = 1;
+
+struct TelemetryHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t padding;
+};
+
+enum TelemetryFlags
+{
+    TELEMETRY_COBRA = 1,
+    TELEMETRY_TOUCHING_GROUND = 2,
+};
+
+struct TelemetryRecord
+{
+    uint64_t tick;
+    double time; // simulated seconds
+    float position[3];
+    float pitch, yaw, roll;
+    float speed;
+    float pitchRate; // degrees per second
+    float cameraOffset[3];
+    uint32_t flags; // TelemetryFlags
+};
+
+static_assert(sizeof(TelemetryRecord) == 64, "TelemetryRecord is written as is");
+
+inline TelemetryRecord telemetryRecord(const FlightState &s, uint64_t tick)
+{
+    TelemetryRecord record;
+    record.tick = tick;
+    record.time = s.time;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        record.position[axis] = s.position[axis];
+        record.cameraOffset[axis] = s.cameraOffset[axis];
+    }
+    record.pitch = s.pitch;
+    record.yaw = s.yaw;
+    record.roll = s.roll;
+    record.speed = s.speed;
+    record.pitchRate = s.pitchRate;
+    record.flags = 0;
+    if (s.cobra)
+        record.flags |= TELEMETRY_COBRA;
+    if (s.touchingGround)
+        record.flags |= TELEMETRY_TOUCHING_GROUND;
+    return record;
+}
+
+class TelemetryWriter
+{
+public:
+    // capacity: records the ring holds before record() starts dropping; 16384 is over a minute at 240 Hz
+    explicit TelemetryWriter(size_t capacity = 16384) : ring(capacity) {}
+    ~TelemetryWriter() { close(); }
+
+    TelemetryWriter(const TelemetryWriter &) = delete;
+    TelemetryWriter &operator=(const TelemetryWriter &) = delete;
+
+    // truncates path and starts the writer thread; false if the file can't be created
+    bool open(const std::string &path)
+    {
+        close();
+        file.open(path, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+        TelemetryHeader header = {};
+        std::memcpy(header.magic, "PTLM", 4);
+        header.version = TELEMETRY_VERSION;
+        header.recordSize = sizeof(TelemetryRecord);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        stopping.store(false, std::memory_order_relaxed);
+        writer = std::thread([this] { run(); });
+        return true;
+    }
+
+    // writes out what is left in the ring and stops the thread
+    void close()
+    {
+        if (!writer.joinable())
+            return;
+        stopping.store(true, std::memory_order_release);
+        writer.join();
+        file.close();
+    }
+
+    // producer side, from one thread only; never blocks. Records that don't fit are counted and dropped.
+    void record(const TelemetryRecord &record)
+    {
+        if (!writer.joinable())
+            return;
+        if (!ring.push(record))
+            dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    size_t writtenRecords() const { return written.load(std::memory_order_relaxed); }
+    size_t droppedRecords() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    SpscRing<TelemetryRecord> ring;
+    std::ofstream file;
+    std::thread writer;
+    std::atomic<bool> stopping{ false };
+    std::atomic<size_t> written{ 0 };
+    std::atomic<size_t> dropped{ 0 };
+
+    void run()
+    {
+        std::vector<TelemetryRecord> batch;
+        batch.reserve(ring.capacity());
+        for (;;)
+        {
+            // read the flag first: whatever was pushed before close() is then in this last drain
+            bool last = stopping.load(std::memory_order_acquire);
+            if (drain(batch) == 0 && !last)
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            if (last)
+                break;
+        }
+    }
+
+    size_t drain(std::vector<TelemetryRecord> &batch)
+    {
+        batch.clear();
+        TelemetryRecord record;
+        while (ring.pop(record))
+            batch.push_back(record);
+        if (batch.empty())
+            return 0;
+        file.write(reinterpret_cast<const char *>(batch.data()),
+                   static_cast<std::streamsize>(batch.size() * sizeof(TelemetryRecord)));
+        file.flush();
+        written.fetch_add(batch.size(), std::memory_order_relaxed);
+        return batch.size();
+    }
+};
+
+// every whole record in a telemetry file; false if it is missing or not a telemetry file of this version
+inline bool readTelemetry(const std::string &path, std::vector<TelemetryRecord> &records)
+{
+    records.clear();
+    MappedFile mapping;
+    if (!mapping.open(path) || mapping.size() < sizeof(TelemetryHeader))
+        return false;
+    TelemetryHeader header;
+    std::memcpy(&header, mapping.data(), sizeof(header));
+    if (std::memcmp(header.magic, "PTLM", 4) != 0 || header.version != TELEMETRY_VERSION ||
+        header.recordSize != sizeof(TelemetryRecord))
+        return false;
+    size_t count = (mapping.size() - sizeof(header)) / sizeof(TelemetryRecord);
+    records.resize(count);
+    if (count > 0)
+        std::memcpy(records.data(), mapping.data() + sizeof(header), count * sizeof(TelemetryRecord));
+    return true;
+}
+
+#endif
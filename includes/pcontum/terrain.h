@@ -0,0 +1,660 @@
+#ifndef TERRAIN_H
+#define TERRAIN_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <pcontum/shader_program.h>
+
+#include <pcontum/culling.h>
+#include <pcontum/thread_pool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// The world is an endless grid of root chunks, each one a quadtree that is
+// refined around the aircraft. A chunk is always the same (resolution + 1)^2 vertex grid, so a level
+// closer to the aircraft just means a smaller chunk with denser vertices. The selected leaves are kept
+// 2:1 balanced, and an edge that borders a coarser chunk drops its odd vertices (one of 16 shared index
+// lists), so neighbouring levels meet without cracks.
+//
+// Chunk vertices are generated on ThreadPool workers and uploaded into a fixed pool of slots in one
+// vertex buffer; the pool size comes from the memory budget and the least recently used slot is reused.
+// Uploads and jobs per frame are capped, so flying further costs neither memory nor frame time. A chunk
+// that is not resident yet is covered by its closest resident ancestor until it arrives.
+
+struct TerrainSettings
+{
+    float rootSize = 2048.0f;        // side of a level 0 chunk; a power of two, like resolution, so that
+                                     // every vertex lands on exactly the same position in all levels
+    int maxLevel = 5;                // 64 units per finest chunk
+    int resolution = 32;             // quads per chunk side
+    float splitDistance = 1.5f;      // a chunk splits while the aircraft is closer than this many chunk sizes
+    float viewDistance = 1000.0f;    // roots further away than this are left out
+    float seaLevel = 0.0f;
+    float clearRadius = 1500.0f;     // open sea around the origin (the carrier); land fades in after it
+    size_t memoryBudget = 16u << 20; // vertex memory of the slot pool, in bytes
+    size_t uploadsPerFrame = 4;
+    size_t jobsInFlight = 8;
+};
+
+// hash-based value noise in [0, 1]
+inline float terrainLatticeValue(int x, int z)
+{
+    uint32_t h = static_cast<uint32_t>(x) * 0x8da6b343u ^ static_cast<uint32_t>(z) * 0xd8163841u;
+    h = (h ^ (h >> 13)) * 0x5bd1e995u;
+    h ^= h >> 15;
+    return static_cast<float>(h & 0xffffff) / static_cast<float>(0xffffff);
+}
+
+inline float terrainValueNoise(float x, float z)
+{
+    float fx = std::floor(x), fz = std::floor(z);
+    int ix = static_cast<int>(fx), iz = static_cast<int>(fz);
+    float tx = x - fx, tz = z - fz;
+    tx = tx * tx * (3.0f - 2.0f * tx);
+    tz = tz * tz * (3.0f - 2.0f * tz);
+    float a = terrainLatticeValue(ix, iz), b = terrainLatticeValue(ix + 1, iz);
+    float c = terrainLatticeValue(ix, iz + 1), d = terrainLatticeValue(ix + 1, iz + 1);
+    return (a + (b - a) * tx) + ((c + (d - c) * tx) - (a + (b - a) * tx)) * tz;
+}
+
+// height of the ground or the sea surface, whichever is higher; a pure function of the position, so
+// chunks of different levels agree wherever they share a vertex
+inline float terrainHeight(const TerrainSettings &settings, float x, float z)
+{
+    float noise = 0.0f, amplitude = 1.0f, total = 0.0f, frequency = 1.0f / 1200.0f;
+    for (int octave = 0; octave < 5; ++octave)
+    {
+        noise += amplitude * terrainValueNoise(x * frequency, z * frequency);
+        total += amplitude;
+        amplitude *= 0.5f;
+        frequency *= 2.0f;
+    }
+    float land = (noise / total - 0.5f) * 360.0f;
+
+    float distance = std::sqrt(x * x + z * z);
+    float fade = glm::clamp((distance - settings.clearRadius) / settings.clearRadius, 0.0f, 1.0f);
+    fade = fade * fade * (3.0f - 2.0f * fade);
+    return settings.seaLevel + std::max(land * fade - 10.0f * (1.0f - fade), 0.0f);
+}
+
+struct TerrainChunkKey
+{
+    int level = 0;
+    int x = 0; // in chunks of this level
+    int z = 0;
+
+    bool operator==(const TerrainChunkKey &other) const { return level == other.level && x == other.x && z == other.z; }
+    bool operator!=(const TerrainChunkKey &other) const { return !(*this == other); }
+
+    TerrainChunkKey parent() const { return TerrainChunkKey{ level - 1, x >> 1, z >> 1 }; }
+    TerrainChunkKey child(int i) const { return TerrainChunkKey{ level + 1, x * 2 + (i & 1), z * 2 + (i >> 1) }; }
+};
+
+struct TerrainChunkKeyHash
+{
+    size_t operator()(const TerrainChunkKey &key) const
+    {
+        uint64_t packed = (uint64_t(uint32_t(key.level)) << 58) ^ (uint64_t(uint32_t(key.x)) << 29) ^ uint64_t(uint32_t(key.z));
+        return std::hash<uint64_t>()(packed * 0x9e3779b97f4a7c15ull);
+    }
+};
+
+inline double terrainChunkSize(const TerrainSettings &settings, int level)
+{
+    return std::ldexp(static_cast<double>(settings.rootSize), -level);
+}
+
+struct TerrainVertex
+{
+    glm::vec3 position; // world space
+    glm::vec3 normal;
+};
+
+struct TerrainChunkData
+{
+    TerrainChunkKey key;
+    std::vector<TerrainVertex> vertices;
+    Aabb bounds;
+};
+
+// CPU side of one chunk, runs on a worker
+inline TerrainChunkData buildTerrainChunk(const TerrainSettings &settings, const TerrainChunkKey &key)
+{
+    TerrainChunkData chunk;
+    chunk.key = key;
+    int n = settings.resolution;
+    double spacing = terrainChunkSize(settings, key.level) / n;
+    chunk.vertices.resize(size_t(n + 1) * (n + 1));
+    for (int j = 0; j <= n; ++j)
+    {
+        for (int i = 0; i <= n; ++i)
+        {
+            // integer lattice times a power of two: exact, whatever the level
+            float x = static_cast<float>((double(key.x) * n + i) * spacing);
+            float z = static_cast<float>((double(key.z) * n + j) * spacing);
+            TerrainVertex &vertex = chunk.vertices[size_t(j) * (n + 1) + i];
+            vertex.position = glm::vec3(x, terrainHeight(settings, x, z), z);
+            // fixed step instead of the grid spacing, so the shading doesn't jump between levels
+            const float step = 1.0f;
+            float dx = terrainHeight(settings, x + step, z) - terrainHeight(settings, x - step, z);
+            float dz = terrainHeight(settings, x, z + step) - terrainHeight(settings, x, z - step);
+            vertex.normal = glm::normalize(glm::vec3(-dx, 2.0f * step, -dz));
+            chunk.bounds.expand(vertex.position);
+        }
+    }
+    return chunk;
+}
+
+// edge bits of TerrainNode::coarserEdges
+enum TerrainEdge
+{
+    TERRAIN_EDGE_MIN_X = 1,
+    TERRAIN_EDGE_MAX_X = 2,
+    TERRAIN_EDGE_MIN_Z = 4,
+    TERRAIN_EDGE_MAX_Z = 8,
+};
+
+// triangles of a chunk whose edges in coarserEdges border a chunk one level up. On such an edge every odd
+// vertex is replaced by the even one before it, so the edge only uses vertices the coarser chunk has too;
+// triangles that collapse on the way are left out.
+inline std::vector<unsigned int> terrainIndices(int resolution, int coarserEdges)
+{
+    int n = resolution;
+    auto vertex = [&](int i, int j) {
+        if ((coarserEdges & TERRAIN_EDGE_MIN_X) && i == 0 && (j & 1))
+            --j;
+        else if ((coarserEdges & TERRAIN_EDGE_MAX_X) && i == n && (j & 1))
+            --j;
+        else if ((coarserEdges & TERRAIN_EDGE_MIN_Z) && j == 0 && (i & 1))
+            --i;
+        else if ((coarserEdges & TERRAIN_EDGE_MAX_Z) && j == n && (i & 1))
+            --i;
+        return static_cast<unsigned int>(j * (n + 1) + i);
+    };
+    std::vector<unsigned int> indices;
+    indices.reserve(size_t(n) * n * 6);
+    auto triangle = [&](unsigned int a, unsigned int b, unsigned int c) {
+        if (a == b || b == c || a == c)
+            return;
+        indices.push_back(a);
+        indices.push_back(b);
+        indices.push_back(c);
+    };
+    for (int j = 0; j < n; ++j)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            // counter-clockwise seen from above (+y)
+            triangle(vertex(i, j), vertex(i, j + 1), vertex(i + 1, j));
+            triangle(vertex(i + 1, j), vertex(i, j + 1), vertex(i + 1, j + 1));
+        }
+    }
+    return indices;
+}
+
+struct TerrainNode
+{
+    TerrainChunkKey key;
+    int coarserEdges = 0;
+};
+
+// picks the leaves for one focus point: distance based splits, then extra splits until no leaf borders
+// one more than a level coarser, then the stitched edges of every leaf
+class TerrainSelection
+{
+public:
+    const std::vector<TerrainNode> &select(const TerrainSettings &settings, const glm::vec3 &focus)
+    {
+        this->settings = settings;
+        roots.clear();
+        splits.clear();
+
+        double rootSize = settings.rootSize;
+        int minX = static_cast<int>(std::floor((focus.x - settings.viewDistance) / rootSize));
+        int maxX = static_cast<int>(std::floor((focus.x + settings.viewDistance) / rootSize));
+        int minZ = static_cast<int>(std::floor((focus.z - settings.viewDistance) / rootSize));
+        int maxZ = static_cast<int>(std::floor((focus.z + settings.viewDistance) / rootSize));
+        for (int z = minZ; z <= maxZ; ++z)
+        {
+            for (int x = minX; x <= maxX; ++x)
+            {
+                TerrainChunkKey root{ 0, x, z };
+                if (horizontalDistance(root, focus) > settings.viewDistance)
+                    continue;
+                roots.insert(root);
+                refine(root, focus);
+            }
+        }
+
+        // 2:1 balance: a leaf whose neighbour is two or more levels finer gets split, until nothing changes
+        for (bool changed = true; changed;)
+        {
+            changed = false;
+            collectLeaves();
+            for (const TerrainNode &leaf : leaves)
+            {
+                for (int edge = 0; edge < 4; ++edge)
+                {
+                    TerrainChunkKey neighbour;
+                    if (neighbourLeaf(leaf.key, edge, neighbour) && neighbour.level < leaf.key.level - 1)
+                    {
+                        splitUpTo(neighbour, leaf.key.level - 1);
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        for (TerrainNode &leaf : leaves)
+        {
+            for (int edge = 0; edge < 4; ++edge)
+            {
+                TerrainChunkKey neighbour;
+                if (neighbourLeaf(leaf.key, edge, neighbour) && neighbour.level < leaf.key.level)
+                    leaf.coarserEdges |= 1 << edge;
+            }
+        }
+        return leaves;
+    }
+
+    // distance from the focus to the chunk's footprint, altitude included
+    double distance(const TerrainChunkKey &key, const glm::vec3 &focus) const
+    {
+        double horizontal = horizontalDistance(key, focus);
+        double height = std::max(0.0, double(focus.y) - settings.seaLevel);
+        return std::sqrt(horizontal * horizontal + height * height);
+    }
+
+private:
+    TerrainSettings settings;
+    std::unordered_set<TerrainChunkKey, TerrainChunkKeyHash> roots;
+    std::unordered_set<TerrainChunkKey, TerrainChunkKeyHash> splits;
+    std::vector<TerrainNode> leaves;
+    std::vector<TerrainChunkKey> stack;
+
+    double horizontalDistance(const TerrainChunkKey &key, const glm::vec3 &focus) const
+    {
+        double size = terrainChunkSize(settings, key.level);
+        double minX = key.x * size, minZ = key.z * size;
+        double dx = std::max({ minX - focus.x, 0.0, double(focus.x) - (minX + size) });
+        double dz = std::max({ minZ - focus.z, 0.0, double(focus.z) - (minZ + size) });
+        return std::sqrt(dx * dx + dz * dz);
+    }
+
+    void refine(const TerrainChunkKey &key, const glm::vec3 &focus)
+    {
+        if (key.level >= settings.maxLevel ||
+            distance(key, focus) >= settings.splitDistance * terrainChunkSize(settings, key.level))
+            return;
+        splits.insert(key);
+        for (int i = 0; i < 4; ++i)
+            refine(key.child(i), focus);
+    }
+
+    // splits the leaf key and the children on its way down, until the leaves there reach level
+    void splitUpTo(const TerrainChunkKey &key, int level)
+    {
+        if (key.level >= level || splits.count(key))
+            return;
+        splits.insert(key);
+        for (int i = 0; i < 4; ++i)
+            splitUpTo(key.child(i), level);
+    }
+
+    void collectLeaves()
+    {
+        leaves.clear();
+        stack.assign(roots.begin(), roots.end());
+        while (!stack.empty())
+        {
+            TerrainChunkKey key = stack.back();
+            stack.pop_back();
+            if (splits.count(key))
+            {
+                for (int i = 0; i < 4; ++i)
+                    stack.push_back(key.child(i));
+            }
+            else
+            {
+                TerrainNode node;
+                node.key = key;
+                leaves.push_back(node);
+            }
+        }
+    }
+
+    // leaf that holds the first row of cells across the given edge (TerrainEdge bit index), if it is selected
+    bool neighbourLeaf(const TerrainChunkKey &key, int edge, TerrainChunkKey &result) const
+    {
+        // the neighbour at the leaf's own level, then up until it exists in the tree
+        TerrainChunkKey neighbour = key;
+        neighbour.x += edge == 0 ? -1 : edge == 1 ? 1 : 0;
+        neighbour.z += edge == 2 ? -1 : edge == 3 ? 1 : 0;
+        std::vector<TerrainChunkKey> path;
+        while (neighbour.level > 0)
+        {
+            path.push_back(neighbour);
+            neighbour = neighbour.parent();
+        }
+        if (!roots.count(neighbour))
+            return false;
+        // walk down while the node is split; the first unsplit node on the path is the leaf
+        while (splits.count(neighbour) && !path.empty())
+        {
+            neighbour = path.back();
+            path.pop_back();
+        }
+        result = neighbour;
+        return true;
+    }
+};
+
+// what the streamer did in the last update() / cull()
+struct TerrainStats
+{
+    size_t selected = 0;  // leaves the quadtree asked for
+    size_t fallbacks = 0; // ancestors drawn in place of leaves that were not resident yet
+    size_t drawn = 0;     // chunks left after culling
+    size_t resident = 0;
+    size_t slots = 0;
+    size_t pending = 0;   // jobs on the workers
+    size_t uploads = 0;
+    size_t evictions = 0;
+    size_t memory = 0;    // bytes of the slot pool, fixed
+};
+
+class TerrainStreamer
+{
+public:
+    TerrainStreamer(ThreadPool &pool, const TerrainSettings &settings = TerrainSettings())
+        : pool(pool), settings(settings)
+    {
+        size_t chunkVertices = size_t(settings.resolution + 1) * (settings.resolution + 1);
+        slotVertices = static_cast<GLint>(chunkVertices);
+        slots.resize(std::max<size_t>(settings.memoryBudget / (chunkVertices * sizeof(TerrainVertex)), 1));
+
+        std::vector<unsigned int> indices;
+        for (int edges = 0; edges < 16; ++edges)
+        {
+            std::vector<unsigned int> variant = terrainIndices(settings.resolution, edges);
+            variantOffset[edges] = indices.size() * sizeof(unsigned int);
+            variantCount[edges] = static_cast<GLsizei>(variant.size());
+            indices.insert(indices.end(), variant.begin(), variant.end());
+        }
+
+        glGenVertexArrays(1, &vertexArray);
+        glGenBuffers(1, &vertexBuffer);
+        glGenBuffers(1, &indexBuffer);
+        glBindVertexArray(vertexArray);
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, slots.size() * chunkVertices * sizeof(TerrainVertex), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(TerrainVertex), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(TerrainVertex), (void*)offsetof(TerrainVertex, normal));
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        lastStats.slots = slots.size();
+        lastStats.memory = slots.size() * chunkVertices * sizeof(TerrainVertex);
+    }
+
+    TerrainStreamer(const TerrainStreamer &) = delete;
+    TerrainStreamer &operator=(const TerrainStreamer &) = delete;
+
+    ~TerrainStreamer()
+    {
+        // jobs reference nothing of ours, but their results must not outlive the pool's queue
+        for (auto &job : jobs)
+            job.second.wait();
+        release();
+    }
+
+    // deletes the VAO and buffers; called by the owner while the GL context is still current
+    void release()
+    {
+        if (!vertexArray)
+            return;
+        glDeleteVertexArrays(1, &vertexArray);
+        unsigned int buffers[] = { vertexBuffer, indexBuffer };
+        glDeleteBuffers(2, buffers);
+        vertexArray = vertexBuffer = indexBuffer = 0;
+    }
+
+    // once per frame: selects the chunks around focus, decides what is drawn, uploads finished chunks and
+    // queues the missing ones
+    void update(const glm::vec3 &focus)
+    {
+        ++frame;
+        const std::vector<TerrainNode> &leaves = selection.select(settings, focus);
+        lastStats.selected = leaves.size();
+        lastStats.uploads = 0;
+        lastStats.evictions = 0;
+
+        // leaves that are resident, or else their closest resident ancestor
+        visible.clear();
+        fallbackKeys.clear();
+        missing.clear();
+        allResident = true;
+        for (const TerrainNode &leaf : leaves)
+        {
+            auto slot = resident.find(leaf.key);
+            if (slot == resident.end())
+            {
+                allResident = false;
+                if (!jobs.count(leaf.key))
+                    missing.push_back(leaf.key);
+            }
+            // resident ancestors stay warm, they are what covers this area while its leaves stream in
+            TerrainChunkKey fallback = leaf.key;
+            bool covered = slot != resident.end();
+            for (TerrainChunkKey key = leaf.key; key.level > 0;)
+            {
+                key = key.parent();
+                auto ancestor = resident.find(key);
+                if (ancestor == resident.end())
+                    continue;
+                slots[ancestor->second].lastUsed = frame;
+                if (!covered)
+                {
+                    fallback = key;
+                    covered = true;
+                }
+            }
+            if (slot != resident.end())
+            {
+                slots[slot->second].lastUsed = frame;
+                visible.push_back(DrawItem{ slot->second, leaf.coarserEdges, leaf.key });
+            }
+            else if (covered)
+            {
+                fallbackKeys.insert(fallback);
+            }
+        }
+        // a drawn ancestor hides everything under it; the seams around it may crack until the leaves arrive
+        if (!fallbackKeys.empty())
+        {
+            visible.erase(std::remove_if(visible.begin(), visible.end(), [this](const DrawItem &item) {
+                for (TerrainChunkKey key = item.key; key.level > 0;)
+                {
+                    key = key.parent();
+                    if (fallbackKeys.count(key))
+                        return true;
+                }
+                return false;
+            }), visible.end());
+            for (const TerrainChunkKey &key : fallbackKeys)
+                visible.push_back(DrawItem{ resident[key], 0, key });
+        }
+        lastStats.fallbacks = fallbackKeys.size();
+
+        uploadFinished();
+
+        // coarse chunks first (they cover the most ground), nearest first within a level
+        std::sort(missing.begin(), missing.end(), [&](const TerrainChunkKey &a, const TerrainChunkKey &b) {
+            if (a.level != b.level)
+                return a.level < b.level;
+            return selection.distance(a, focus) < selection.distance(b, focus);
+        });
+        for (const TerrainChunkKey &key : missing)
+        {
+            if (jobs.size() >= settings.jobsInFlight)
+                break;
+            TerrainSettings jobSettings = settings;
+            jobs.emplace(key, pool.submit([jobSettings, key] { return buildTerrainChunk(jobSettings, key); }));
+        }
+        lastStats.pending = jobs.size();
+        lastStats.resident = resident.size();
+    }
+
+    // every selected chunk is resident (used to hold the loading screen until the first view is complete)
+    bool ready() const { return allResident; }
+
+    // frustum culls what update() picked and prepares the draw
+    void cull(const Frustum &frustum, CullStats &stats)
+    {
+        boxes.clear();
+        for (const DrawItem &item : visible)
+            boxes.push_back(slots[item.slot].bounds);
+        culled.clear();
+        cullBoxes(frustum, boxes, culled, stats);
+
+        counts.clear();
+        offsets.clear();
+        baseVertices.clear();
+        for (uint32_t index : culled)
+        {
+            const DrawItem &item = visible[index];
+            counts.push_back(variantCount[item.coarserEdges]);
+            offsets.push_back((const void*)variantOffset[item.coarserEdges]);
+            baseVertices.push_back(static_cast<GLint>(item.slot) * slotVertices);
+        }
+        lastStats.drawn = counts.size();
+    }
+
+    // one glMultiDrawElementsBaseVertex for every chunk left after cull(); the shader must be bound
+    void draw()
+    {
+        if (counts.empty())
+            return;
+        glBindVertexArray(vertexArray);
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts.data(), GL_UNSIGNED_INT, offsets.data(),
+                                      static_cast<GLsizei>(counts.size()), baseVertices.data());
+        glBindVertexArray(0);
+    }
+
+    const TerrainStats &stats() const { return lastStats; }
+
+    // height of the surface under a point, same function the chunks are built from
+    float heightAt(float x, float z) const { return terrainHeight(settings, x, z); }
+
+private:
+    struct Slot
+    {
+        TerrainChunkKey key;
+        Aabb bounds;
+        uint64_t lastUsed = 0;
+        bool used = false;
+    };
+
+    struct DrawItem
+    {
+        size_t slot;
+        int coarserEdges;
+        TerrainChunkKey key;
+    };
+
+    ThreadPool &pool;
+    TerrainSettings settings;
+    TerrainSelection selection;
+    uint64_t frame = 0;
+    bool allResident = false;
+
+    unsigned int vertexArray = 0;
+    unsigned int vertexBuffer = 0;
+    unsigned int indexBuffer = 0;
+    GLint slotVertices = 0;
+    size_t variantOffset[16];
+    GLsizei variantCount[16];
+
+    std::vector<Slot> slots;
+    std::unordered_map<TerrainChunkKey, size_t, TerrainChunkKeyHash> resident;
+    std::unordered_map<TerrainChunkKey, std::future<TerrainChunkData>, TerrainChunkKeyHash> jobs;
+    std::unordered_set<TerrainChunkKey, TerrainChunkKeyHash> fallbackKeys;
+    std::vector<TerrainChunkKey> missing;
+    std::vector<DrawItem> visible;
+    std::vector<Aabb> boxes;
+    std::vector<uint32_t> culled;
+    std::vector<GLsizei> counts;
+    std::vector<const void*> offsets;
+    std::vector<GLint> baseVertices;
+    TerrainStats lastStats;
+
+    // least recently used slot that nothing drawn this frame depends on; a linear scan, the pool is a
+    // few hundred slots and this runs at most uploadsPerFrame times
+    bool takeSlot(size_t &result)
+    {
+        size_t best = slots.size();
+        for (size_t i = 0; i < slots.size(); ++i)
+        {
+            if (!slots[i].used)
+            {
+                best = i;
+                break;
+            }
+            if (slots[i].lastUsed < frame && (best == slots.size() || slots[i].lastUsed < slots[best].lastUsed))
+                best = i;
+        }
+        if (best == slots.size())
+            return false;
+        if (slots[best].used)
+        {
+            resident.erase(slots[best].key);
+            lastStats.evictions++;
+        }
+        result = best;
+        return true;
+    }
+
+    void uploadFinished()
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        for (auto job = jobs.begin(); job != jobs.end() && lastStats.uploads < settings.uploadsPerFrame;)
+        {
+            if (job->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+                ++job;
+                continue;
+            }
+            size_t slot;
+            if (!takeSlot(slot))
+                break; // the budget is smaller than one frame's chunks; the rest waits
+            TerrainChunkData chunk = job->second.get();
+            glBufferSubData(GL_ARRAY_BUFFER, slot * slotVertices * sizeof(TerrainVertex),
+                            chunk.vertices.size() * sizeof(TerrainVertex), chunk.vertices.data());
+            slots[slot].key = chunk.key;
+            slots[slot].bounds = chunk.bounds;
+            slots[slot].lastUsed = frame;
+            slots[slot].used = true;
+            resident[chunk.key] = slot;
+            lastStats.uploads++;
+            job = jobs.erase(job);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+};
+
+#endif
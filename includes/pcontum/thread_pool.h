@@ -0,0 +1,123 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <type_traits>
+#include <vector>
+
+// A fixed set of worker threads pulling jobs from one queue.
+// submit() hands back a std::future; parallelFor() splits an index range into chunks and blocks until
+// every chunk is done, with the calling thread working on chunks too.
+class ThreadPool
+{
+public:
+    // 0 picks one worker per hardware thread
+    explicit ThreadPool(size_t threadCount = 0)
+    {
+        if (threadCount == 0)
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t i = 0; i < threadCount; ++i)
+            workers.emplace_back([this] { workerLoop(); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    template <typename F>
+    std::future<typename std::invoke_result<F>::type> submit(F &&job)
+    {
+        typedef typename std::invoke_result<F>::type Result;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+        std::future<Result> result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.emplace([task] { (*task)(); });
+        }
+        wake.notify_one();
+        return result;
+    }
+
+    // calls body(begin, end) on disjoint sub-ranges of [0, count) and waits for all of them.
+    // grain is the smallest chunk worth a queue round trip. Don't call it from inside a pool job:
+    // the helpers it queues could end up waiting behind the job that waits for them.
+    template <typename F>
+    void parallelFor(size_t count, size_t grain, F &&body)
+    {
+        if (count == 0)
+            return;
+        grain = std::max<size_t>(grain, 1);
+        size_t chunks = std::min((count + grain - 1) / grain, workers.size() * 4);
+        if (chunks <= 1)
+        {
+            body(size_t(0), count);
+            return;
+        }
+
+        std::atomic<size_t> next(0);
+        size_t chunkSize = (count + chunks - 1) / chunks;
+        auto runChunks = [&] {
+            for (size_t chunk = next++; chunk < chunks; chunk = next++)
+            {
+                size_t begin = chunk * chunkSize;
+                size_t end = std::min(begin + chunkSize, count);
+                if (begin < end)
+                    body(begin, end);
+            }
+        };
+
+        std::vector<std::future<void>> helpers;
+        size_t helperCount = std::min(workers.size(), chunks - 1);
+        for (size_t i = 0; i < helperCount; ++i)
+            helpers.push_back(submit(runChunks));
+        runChunks();
+        for (std::future<void> &helper : helpers)
+            helper.get();
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    void workerLoop()
+    {
+        for (;;)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (stopping && jobs.empty())
+                    return;
+                job = std::move(jobs.front());
+                jobs.pop();
+            }
+            job();
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef UNIFORM_CACHE_H
+#define UNIFORM_CACHE_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Every active uniform of a linked program, read once, so setting a uniform is a binary
+// search in a sorted table instead of a glGetUniformLocation round trip into the driver. Names are taken
+// as const char *, so string literals don't allocate a std::string on every call. Array elements are in the
+// table one by one ("lights[2]"), and the bare array name points at element 0. Uniforms inside a block
+// (see frame_uniforms.h) have no location and are not listed. Every ShaderProgram carries one, filled by
+// ProgramCache once the program is linked or loaded from a binary.
+class UniformCache
+{
+public:
+    UniformCache() {}
+    explicit UniformCache(GLuint program) { load(program); }
+
+    void load(GLuint program)
+    {
+        entries.clear();
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<GLchar> buffer(static_cast<size_t>(maxLength) + 1);
+        for (GLint i = 0; i < count; ++i)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(program, static_cast<GLuint>(i), maxLength, &length, &size, &type, buffer.data());
+            std::string name(buffer.data(), static_cast<size_t>(length));
+            GLint location = glGetUniformLocation(program, name.c_str());
+            if (location < 0)
+                continue;
+            // arrays are reported once, as "name[0]"
+            if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+            {
+                std::string base = name.substr(0, name.size() - 3);
+                entries.push_back(std::make_pair(base, location));
+                for (GLint element = 0; element < size; ++element)
+                {
+                    std::string elementName = base + "[" + std::to_string(element) + "]";
+                    entries.push_back(std::make_pair(elementName, glGetUniformLocation(program, elementName.c_str())));
+                }
+            }
+            else
+                entries.push_back(std::make_pair(name, location));
+        }
+        std::sort(entries.begin(), entries.end());
+    }
+
+    // -1 (ignored by glUniform*) if the program has no such active uniform
+    GLint location(const char *name) const
+    {
+        auto found = std::lower_bound(entries.begin(), entries.end(), name,
+                                      [](const std::pair<std::string, GLint> &entry, const char *key) {
+                                          return std::strcmp(entry.first.c_str(), key) < 0;
+                                      });
+        if (found == entries.end() || found->first != name)
+            return -1;
+        return found->second;
+    }
+
+    size_t size() const { return entries.size(); }
+
+    // like learnopengl's Shader setters, they write to the program in use
+    void setBool(const char *name, bool value) const { glUniform1i(location(name), static_cast<int>(value)); }
+    void setInt(const char *name, int value) const { glUniform1i(location(name), value); }
+    void setFloat(const char *name, float value) const { glUniform1f(location(name), value); }
+    void setVec2(const char *name, const glm::vec2 &value) const { glUniform2fv(location(name), 1, &value[0]); }
+    void setVec3(const char *name, const glm::vec3 &value) const { glUniform3fv(location(name), 1, &value[0]); }
+    void setVec4(const char *name, const glm::vec4 &value) const { glUniform4fv(location(name), 1, &value[0]); }
+    void setMat3(const char *name, const glm::mat3 &value) const { glUniformMatrix3fv(location(name), 1, GL_FALSE, &value[0][0]); }
+    void setMat4(const char *name, const glm::mat4 &value) const { glUniformMatrix4fv(location(name), 1, GL_FALSE, &value[0][0]); }
+
+private:
+    std::vector<std::pair<std::string, GLint>> entries; // sorted by name
+};
+
+#endif
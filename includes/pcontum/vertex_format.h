@@ -0,0 +1,175 @@
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+
+#include <pcontum/culling.h>
+#include <pcontum/half_float.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// The GPU copy of a mesh vertex in 28 bytes instead of learnopengl's 88.
+// Positions are 16-bit fractions of the mesh bounds, normals and tangents are octahedral-encoded into two
+// 16-bit values each, texture coordinates are half floats, and the bitangent is rebuilt from the normal,
+// the tangent and a handedness sign. The shaders (2.2.2.pbr.vs, vertex_shader.glsl) decode them; the
+// bounds go in through the model matrix, see VertexQuantization::matrix().
+
+struct PackedVertex
+{
+    uint16_t position[4];   // xyz: unorm16 within the mesh bounds, w: bitangent handedness (0: -1, 65535: +1)
+    int16_t normal[2];      // octahedral, snorm16
+    int16_t tangent[2];     // octahedral, snorm16
+    uint16_t texCoords[2];  // half floats
+    uint8_t boneIds[4];     // 255: no bone
+    uint8_t boneWeights[4]; // unorm8
+};
+
+static_assert(sizeof(PackedVertex) == 28, "PackedVertex is uploaded as is");
+
+const uint8_t PACKED_VERTEX_NO_BONE = 255;
+
+// maps the unorm16 positions (0..1 in the shader) back to model space: offset + position * scale
+struct VertexQuantization
+{
+    glm::vec3 offset = glm::vec3(0.0f);
+    glm::vec3 scale = glm::vec3(1.0f);
+
+    static VertexQuantization fromBounds(const Aabb &bounds)
+    {
+        VertexQuantization quantization;
+        if (bounds.empty())
+            return quantization;
+        quantization.offset = bounds.min;
+        quantization.scale = bounds.max - bounds.min;
+        // a flat axis still needs an invertible matrix; every vertex quantizes to 0 on it anyway
+        for (int axis = 0; axis < 3; ++axis)
+            if (quantization.scale[axis] <= 0.0f)
+                quantization.scale[axis] = 1.0f;
+        return quantization;
+    }
+
+    // model space from the decoded (0..1) position, to go in front of a model matrix
+    glm::mat4 matrix() const
+    {
+        glm::mat4 result(1.0f);
+        result[0][0] = scale.x;
+        result[1][1] = scale.y;
+        result[2][2] = scale.z;
+        result[3] = glm::vec4(offset, 1.0f);
+        return result;
+    }
+
+    Aabb bounds() const
+    {
+        Aabb box;
+        box.min = offset;
+        box.max = offset + scale;
+        return box;
+    }
+};
+
+// unit vector onto the octahedron, unfolded into [-1, 1]^2; zero vectors come out as +z
+inline glm::vec2 octEncode(const glm::vec3 &vector)
+{
+    float length = std::fabs(vector.x) + std::fabs(vector.y) + std::fabs(vector.z);
+    if (length <= 0.0f)
+        return glm::vec2(0.0f);
+    glm::vec3 n = vector * (1.0f / length);
+    if (n.z >= 0.0f)
+        return glm::vec2(n.x, n.y);
+    return glm::vec2((1.0f - std::fabs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+                     (1.0f - std::fabs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+}
+
+inline glm::vec3 octDecode(const glm::vec2 &encoded)
+{
+    glm::vec3 n(encoded.x, encoded.y, 1.0f - std::fabs(encoded.x) - std::fabs(encoded.y));
+    if (n.z < 0.0f)
+    {
+        float x = (1.0f - std::fabs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+        float y = (1.0f - std::fabs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+        n.x = x;
+        n.y = y;
+    }
+    return n * (1.0f / glm::length(n));
+}
+
+inline int16_t packSnorm16(float value)
+{
+    return static_cast<int16_t>(std::lround(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f));
+}
+
+inline uint16_t packUnorm16(float value)
+{
+    return static_cast<uint16_t>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f));
+}
+
+inline PackedVertex packVertex(const Vertex &vertex, const VertexQuantization &quantization)
+{
+    PackedVertex packed;
+    glm::vec3 position = (vertex.Position - quantization.offset) / quantization.scale;
+    for (int axis = 0; axis < 3; ++axis)
+        packed.position[axis] = packUnorm16(position[axis]);
+    float handedness = glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.Bitangent);
+    packed.position[3] = handedness < 0.0f ? 0 : 65535;
+
+    glm::vec2 normal = octEncode(vertex.Normal);
+    glm::vec2 tangent = octEncode(vertex.Tangent);
+    packed.normal[0] = packSnorm16(normal.x);
+    packed.normal[1] = packSnorm16(normal.y);
+    packed.tangent[0] = packSnorm16(tangent.x);
+    packed.tangent[1] = packSnorm16(tangent.y);
+    packed.texCoords[0] = floatToHalf(vertex.TexCoords.x);
+    packed.texCoords[1] = floatToHalf(vertex.TexCoords.y);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        bool used = i < MAX_BONE_INFLUENCE && vertex.m_BoneIDs[i] >= 0 && vertex.m_BoneIDs[i] < PACKED_VERTEX_NO_BONE;
+        packed.boneIds[i] = used ? static_cast<uint8_t>(vertex.m_BoneIDs[i]) : PACKED_VERTEX_NO_BONE;
+        packed.boneWeights[i] = used ? static_cast<uint8_t>(std::lround(std::min(std::max(vertex.m_Weights[i], 0.0f), 1.0f) * 255.0f)) : 0;
+    }
+    return packed;
+}
+
+inline void packVertices(const Vertex *vertices, size_t count, const VertexQuantization &quantization, PackedVertex *packed)
+{
+    for (size_t i = 0; i < count; ++i)
+        packed[i] = packVertex(vertices[i], quantization);
+}
+
+// model-space position of a packed vertex, for CPU code that needs the geometry back (bounds, merging)
+inline glm::vec3 unpackPosition(const PackedVertex &vertex, const VertexQuantization &quantization)
+{
+    glm::vec3 position(vertex.position[0], vertex.position[1], vertex.position[2]);
+    return quantization.offset + position * (1.0f / 65535.0f) * quantization.scale;
+}
+
+// same attribute locations as learnopengl's Mesh, for the VAO and GL_ARRAY_BUFFER that are bound:
+// 0 position (vec4, w = handedness), 1 normal (vec2), 2 texCoords (vec2), 3 tangent (vec2),
+// 5 bone ids (ivec4), 6 weights (vec4). 4 (the bitangent) is rebuilt in the shader and stays off.
+inline void setupPackedVertexAttributes()
+{
+    const GLsizei stride = sizeof(PackedVertex);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, normal));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, texCoords));
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, tangent));
+    glEnableVertexAttribArray(5);
+    glVertexAttribIPointer(5, 4, GL_UNSIGNED_BYTE, stride, (void*)offsetof(PackedVertex, boneIds));
+    glEnableVertexAttribArray(6);
+    glVertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(PackedVertex, boneWeights));
+}
+
+#endif
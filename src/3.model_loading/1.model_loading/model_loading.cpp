@@ -16,6 +16,7 @@
 #include <learnopengl/model.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/shader_m.h>
+#include <pcontum/telemetry.h>
 #include <chrono>
 #include <thread>
 
@@ -37,6 +38,11 @@ float yaw = 0.0f;   // y-axis rotation
 float roll = 180.0f;  // z-axis rotation
 float speed = 10.0f;
 
+// aircraft and camera state of every frame, written in the background (tools__telemetry_to_csv decodes it)
+TelemetryWriter telemetry;
+uint64_t telemetryFrames = 0;
+double telemetryTime = 0.0; // simulated seconds: the sum of the frame steps the flight has advanced by
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
@@ -45,6 +51,9 @@ void updateCamera(); // Prototip eklendi
 
 int main()
 {
+    if (!telemetry.open("model_loading.telemetry"))
+        std::cout << "Failed to open telemetry file" << std::endl;
+
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -132,6 +141,7 @@ int main()
         glfwPollEvents();
     }
 
+    telemetry.close();
     glfwTerminate();
     return 0;
 }
@@ -198,10 +208,21 @@ void processInput(GLFWwindow* window)
     if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS)
         cameraOffset.y += cameraMoveSpeed; // Kamerayı sağa kaydır
 
-    // Debug için uçak ve kamera durumu
-    std::cout << "Airplane Position: " << airplanePosition.x << ", " << airplanePosition.y << ", " << airplanePosition.z
-              << " | Speed: " << speed << " | Pitch: " << pitch << " | Yaw: " << yaw << " | Roll: " << roll
-              << " | Camera Offset: " << cameraOffset.x << ", " << cameraOffset.y << ", " << cameraOffset.z << std::endl;
+    // Uçak ve kamera durumu telemetri günlüğüne
+    telemetryTime += deltaTime;
+    TelemetryRecord record = {};
+    record.tick = telemetryFrames++;
+    record.time = telemetryTime;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        record.position[axis] = airplanePosition[axis];
+        record.cameraOffset[axis] = cameraOffset[axis];
+    }
+    record.pitch = pitch;
+    record.yaw = yaw;
+    record.roll = roll;
+    record.speed = speed;
+    telemetry.record(record);
 }
 
 
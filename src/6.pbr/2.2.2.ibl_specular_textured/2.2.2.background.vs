@@ -1,8 +1,14 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 projection;
-uniform mat4 view;
+// per-frame camera, shared by all programs (frame_uniforms.h)
+layout (std140) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;      // airplanes and sky
+    mat4 worldProjection; // carrier and terrain
+    vec4 camPos;
+};
 
 out vec3 WorldPos;
 
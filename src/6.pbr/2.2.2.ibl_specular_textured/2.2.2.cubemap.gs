@@ -0,0 +1,27 @@
+#version 330 core
+layout (triangles) in;
+layout (triangle_strip, max_vertices = 18) out;
+
+in vec3 CubePos[];
+
+out vec3 WorldPos;
+
+// projection * view of each face, in GL_TEXTURE_CUBE_MAP_POSITIVE_X + face order
+uniform mat4 captureViewProjections[6];
+
+// layered capture: the whole cubemap (one mip of it) is the render target, and every triangle of the
+// cube is emitted once per face with gl_Layer selecting the face
+void main()
+{
+    for (int face = 0; face < 6; ++face)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            gl_Layer = face;
+            WorldPos = CubePos[i];
+            gl_Position = captureViewProjections[face] * vec4(CubePos[i], 1.0);
+            EmitVertex();
+        }
+        EndPrimitive();
+    }
+}
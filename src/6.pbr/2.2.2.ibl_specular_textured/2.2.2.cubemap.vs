@@ -1,13 +1,11 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 
-out vec3 WorldPos;
-
-uniform mat4 projection;
-uniform mat4 view;
+// the cube goes to 2.2.2.cubemap.gs untransformed; it draws it once into every face
+out vec3 CubePos;
 
 void main()
 {
-    WorldPos = aPos;  
-    gl_Position =  projection * view * vec4(WorldPos, 1.0);
+    CubePos = aPos;
+    gl_Position = vec4(aPos, 1.0);
 }
\ No newline at end of file
@@ -13,14 +13,29 @@ uniform sampler2D aoMap;
 
 // IBL
 uniform samplerCube irradianceMap;
+// diffuse IBL from 9 L2 spherical-harmonics coefficients (sh_irradiance.h) instead of irradianceMap
+uniform bool useShIrradiance;
+uniform vec3 shIrradiance[9];
 uniform samplerCube prefilterMap;
 uniform sampler2D brdfLUT;
 
-// lights
-uniform vec3 lightPositions[4];
-uniform vec3 lightColors[4];
-
-uniform vec3 camPos;
+// per-frame camera, shared by all programs (frame_uniforms.h)
+layout (std140) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;      // airplanes and sky
+    mat4 worldProjection; // carrier and terrain
+    vec4 camPos;
+};
+
+// clustered point lights (light_clusters.h): the cluster under this fragment lists the lights reaching it
+uniform samplerBuffer clusterLights;        // per light: position and radius, color
+uniform usamplerBuffer clusterGrid;         // per cluster: first index, count
+uniform usamplerBuffer clusterLightIndices;
+uniform vec2 clusterTileScale;              // tiles per pixel
+uniform vec2 clusterDepthScale;             // slice = log(view depth) * x + y
+// CLUSTER_TILES_X, CLUSTER_TILES_Y and CLUSTER_SLICES are defined by the program cache (lightClusterDefines)
+const ivec3 CLUSTER_COUNTS = ivec3(CLUSTER_TILES_X, CLUSTER_TILES_Y, CLUSTER_SLICES);
 
 const float PI = 3.14159265359;
 // ----------------------------------------------------------------------------
@@ -90,6 +105,21 @@ vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
     return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
 }   
 // ----------------------------------------------------------------------------
+// irradiance / PI from the L2 SH coefficients, same units as irradianceMap
+vec3 evaluateShIrradiance(vec3 n)
+{
+    vec3 result = shIrradiance[0] * 0.282095
+                + shIrradiance[1] * 0.488603 * n.y
+                + shIrradiance[2] * 0.488603 * n.z
+                + shIrradiance[3] * 0.488603 * n.x
+                + shIrradiance[4] * 1.092548 * n.x * n.y
+                + shIrradiance[5] * 1.092548 * n.y * n.z
+                + shIrradiance[6] * 0.315392 * (3.0 * n.z * n.z - 1.0)
+                + shIrradiance[7] * 1.092548 * n.x * n.z
+                + shIrradiance[8] * 0.546274 * (n.x * n.x - n.y * n.y);
+    return max(result, vec3(0.0));
+}
+// ----------------------------------------------------------------------------
 void main()
 {		
     // material properties
@@ -100,7 +130,7 @@ void main()
        
     // input lighting data
     vec3 N = getNormalFromMap();
-    vec3 V = normalize(camPos - WorldPos);
+    vec3 V = normalize(camPos.xyz - WorldPos);
     vec3 R = reflect(-V, N); 
 
     // calculate reflectance at normal incidence; if dia-electric (like plastic) use F0 
@@ -108,16 +138,28 @@ void main()
     vec3 F0 = vec3(0.04); 
     F0 = mix(F0, albedo, metallic);
 
+    // this fragment's cluster
+    float viewDepth = -(view * vec4(WorldPos, 1.0)).z;
+    ivec3 cluster = ivec3(ivec2(gl_FragCoord.xy * clusterTileScale), int(log(viewDepth) * clusterDepthScale.x + clusterDepthScale.y));
+    cluster = clamp(cluster, ivec3(0), CLUSTER_COUNTS - 1);
+    uvec2 lightRange = texelFetch(clusterGrid, (cluster.z * CLUSTER_COUNTS.y + cluster.y) * CLUSTER_COUNTS.x + cluster.x).xy;
+
     // reflectance equation
     vec3 Lo = vec3(0.0);
-    for(int i = 0; i < 4; ++i) 
+    for(uint i = 0u; i < lightRange.y; ++i) 
     {
+        int light = int(texelFetch(clusterLightIndices, int(lightRange.x + i)).r);
+        vec4 positionRadius = texelFetch(clusterLights, 2 * light);
+        vec3 lightColor = texelFetch(clusterLights, 2 * light + 1).rgb;
+
         // calculate per-light radiance
-        vec3 L = normalize(lightPositions[i] - WorldPos);
+        vec3 L = normalize(positionRadius.xyz - WorldPos);
         vec3 H = normalize(V + L);
-        float distance = length(lightPositions[i] - WorldPos);
-        float attenuation = 1.0 / (distance * distance);
-        vec3 radiance = lightColors[i] * attenuation;
+        float distance = length(positionRadius.xyz - WorldPos);
+        // inverse square, faded to 0 at the light's radius so the cluster cut-off doesn't show
+        float fade = clamp(1.0 - pow(distance / positionRadius.w, 4.0), 0.0, 1.0);
+        float attenuation = fade * fade / (distance * distance);
+        vec3 radiance = lightColor * attenuation;
 
         // Cook-Torrance BRDF
         float NDF = DistributionGGX(N, H, roughness);   
@@ -153,7 +195,7 @@ void main()
     vec3 kD = 1.0 - kS;
     kD *= 1.0 - metallic;	  
     
-    vec3 irradiance = texture(irradianceMap, N).rgb;
+    vec3 irradiance = useShIrradiance ? evaluateShIrradiance(N) : texture(irradianceMap, N).rgb;
     vec3 diffuse      = irradiance * albedo;
     
     // sample both the pre-filter map and the BRDF lut and combine them together as per the Split-Sum approximation to get the IBL specular part.
@@ -1,17 +1,80 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
+#extension GL_ARB_shader_draw_parameters : enable
+layout (location = 0) in vec4 aPos;    // 0..1 within the mesh bounds; w is the tangent handedness
+layout (location = 1) in vec2 aNormal; // octahedral
 layout (location = 2) in vec2 aTexCoords;
+// skinning, as in anim_model.vs: up to four joints per vertex, 255 for an unused slot
+layout (location = 5) in ivec4 aBoneIds;
+layout (location = 6) in vec4 aBoneWeights;
+// instanced draws: per-instance matrices from a vertex buffer (InstancedModel), locations 7-10 and 11-13
+layout (location = 7) in mat4 aInstanceModel;
+layout (location = 11) in mat3 aInstanceNormalMatrix;
 
 out vec2 TexCoords;
 out vec3 WorldPos;
 out vec3 FragPos;
 out vec3 Normal;
 
-uniform mat4 projection;
-uniform mat4 view;
+// per-frame camera, shared by all programs (frame_uniforms.h)
+layout (std140) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;      // airplanes and sky
+    mat4 worldProjection; // carrier and terrain
+    vec4 camPos;
+};
 uniform mat4 model;
 uniform mat3 normalMatrix; // Kullanım isteğe bağlı
+uniform bool instanced;
+// multi-draw: per-draw transforms from texture buffers (MultiDrawList), 7 texels per instance
+uniform bool multiDraw;
+uniform int drawIdBase;
+uniform samplerBuffer drawTransforms;
+uniform isamplerBuffer drawRecords;
+// skinned multi-draw instances: world-space palettes (skeletal_animation.h), 3 texels (matrix rows) per
+// matrix. Slot 0 of a palette is the bare model matrix, joint j is slot 1 + j.
+uniform samplerBuffer bonePalettes;
+// mesh bounds for draws outside MultiDrawList; there they are already part of the per-draw model matrix
+uniform mat4 positionDequantize;
+
+int drawId()
+{
+#ifdef GL_ARB_shader_draw_parameters
+    return drawIdBase + gl_DrawIDARB;
+#else
+    return drawIdBase;
+#endif
+}
+
+mat4 paletteMatrix(int index)
+{
+    int texel = index * 3;
+    return transpose(mat4(texelFetch(bonePalettes, texel), texelFetch(bonePalettes, texel + 1),
+                          texelFetch(bonePalettes, texel + 2), vec4(0.0, 0.0, 0.0, 1.0)));
+}
+
+// weighted sum of the vertex's joint matrices; renormalized, since the weights went through unorm8
+mat4 skinMatrix(int paletteBase)
+{
+    mat4 skin = mat4(0.0);
+    float total = 0.0;
+    for (int i = 0; i < 4; ++i) {
+        if (aBoneIds[i] == 255)
+            continue;
+        skin += paletteMatrix(paletteBase + 1 + aBoneIds[i]) * aBoneWeights[i];
+        total += aBoneWeights[i];
+    }
+    return total > 0.0 ? skin * (1.0 / total) : paletteMatrix(paletteBase);
+}
+
+// packed vertices (vertex_format.h): octahedral normal in [-1, 1]^2 back to a unit vector
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
 
 void main()
 {
@@ -19,14 +82,40 @@ void main()
     TexCoords = aTexCoords;
 
     // Pozisyonları hesapla
-    WorldPos = vec3(model * vec4(aPos, 1.0));
+    mat4 worldModel = instanced ? aInstanceModel : model;
+    vec4 position = positionDequantize * vec4(aPos.xyz, 1.0);
+    vec3 normal = octDecode(aNormal);
+    int transform = 0;
+    int paletteBase = -1;
+    mat4 skin = mat4(1.0);
+    if (multiDraw) {
+        transform = (texelFetch(drawRecords, drawId()).r + gl_InstanceID) * 7;
+        worldModel = mat4(texelFetch(drawTransforms, transform), texelFetch(drawTransforms, transform + 1),
+                          texelFetch(drawTransforms, transform + 2), texelFetch(drawTransforms, transform + 3));
+        position = vec4(aPos.xyz, 1.0);
+        // skinned: the four texels are the quantization alone, the palette takes model space to world space
+        paletteBase = int(texelFetch(drawTransforms, transform + 4).w);
+        if (paletteBase >= 0) {
+            skin = skinMatrix(paletteBase);
+            worldModel = skin * worldModel;
+        }
+    }
+    WorldPos = vec3(worldModel * position);
     FragPos = WorldPos; // Aynı veriyi tekrar hesaplamamak için yeniden kullanıyoruz
 
     // Normal hesaplaması (model matrisine göre)
-    if (normalMatrix != mat3(0.0)) {
-        Normal = normalMatrix * aNormal;
+    if (paletteBase >= 0) {
+        // joints are expected to scale uniformly, so the rotation part is good enough for normals
+        Normal = normalize(mat3(skin) * normal);
+    } else if (multiDraw) {
+        Normal = mat3(texelFetch(drawTransforms, transform + 4).xyz, texelFetch(drawTransforms, transform + 5).xyz,
+                      texelFetch(drawTransforms, transform + 6).xyz) * normal;
+    } else if (instanced) {
+        Normal = aInstanceNormalMatrix * normal;
+    } else if (normalMatrix != mat3(0.0)) {
+        Normal = normalMatrix * normal;
     } else {
-        Normal = mat3(transpose(inverse(model))) * aNormal;
+        Normal = mat3(transpose(inverse(model))) * normal;
     }
 
     // Nihai pozisyonu hesapla
@@ -1,6 +1,7 @@
 #version 330 core
 struct Material {
     sampler2D texture_diffuse1;
+    sampler2DArray texture_array;
     vec3 diffuse;
     vec3 specular;
     float shininess;
@@ -17,22 +18,28 @@ struct Light {
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
+flat in int TextureLayer;
 
 out vec4 FragColor;
 
 uniform Material material;
 uniform Light light;
 uniform vec3 viewPos;
+uniform bool useTextureArray; // PackedModel: doku, texture_array'in TextureLayer katmanından okunur
 
 void main()
 {
     vec3 ambient, diffuse, specular;
 
     // Texture RGB değerini al
-    vec3 textureColor = texture(material.texture_diffuse1, TexCoords).rgb;
+    vec3 textureColor;
+    if (useTextureArray)
+        textureColor = TextureLayer >= 0 ? texture(material.texture_array, vec3(TexCoords, float(TextureLayer))).rgb : vec3(0.0);
+    else
+        textureColor = texture(material.texture_diffuse1, TexCoords).rgb;
 
     // Eğer doku varsa (dokunun r değeri sıfır değilse), sadece dokuyu kullan.
-    if (texture(material.texture_diffuse1, TexCoords).r != 0.0) {
+    if (textureColor.r != 0.0) {
         // Doku varsa, aydınlatma uygulanmadan doğrudan dokuyu göster
         FragColor = vec4(textureColor, 1.0);
     } else {
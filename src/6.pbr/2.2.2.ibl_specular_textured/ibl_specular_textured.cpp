@@ -9,9 +9,29 @@
 #include <glm/gtc/quaternion.hpp>
 
 #include <learnopengl/filesystem.h>
-#include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <pcontum/flight_model.h>
+#include <pcontum/collision_mesh.h>
+#include <pcontum/culling.h>
+#include <pcontum/geometry_buffer.h>
+#include <pcontum/mesh_lod.h>
+#include <pcontum/multi_draw.h>
+#include <pcontum/thread_pool.h>
+#include <pcontum/asset_loader.h>
+#include <pcontum/ibl_cache.h>
+#include <pcontum/ibl_cache_gl.h>
+#include <pcontum/sh_irradiance.h>
+#include <pcontum/render_queue.h>
+#include <pcontum/frame_uniforms.h>
+#include <pcontum/light_clusters.h>
+#include <pcontum/light_clusters_gl.h>
+#include <pcontum/skeletal_animation_gl.h>
+#include <pcontum/program_cache.h>
+#include <pcontum/profiler.h>
+#include <pcontum/telemetry.h>
+#include <pcontum/flight_recorder.h>
+#include <pcontum/terrain.h>
 #include <fstream>
 #include <sstream>
 #include <vector>
@@ -31,41 +51,73 @@ void processInput(GLFWwindow *window);
 unsigned int loadTexturef(const char *path);
 void renderSphere();
 void renderCube();
-void renderQuad(float width);
+void renderQuad();
+void renderLoadingFrame(GLFWwindow *window, float progress);
 void updateCamera(); // Prototip eklendi
+void stepSimulation(GLFWwindow *window);
+void updateGroundHeights(FlightTickInput &input);
+FlightInput readFlightInput(GLFWwindow *window);
 
 // settings
 const unsigned int SCR_WIDTH = 1920;
 const unsigned int SCR_HEIGHT = 1020;
 
-// camera
+// framebuffer size in pixels, kept current by framebuffer_size_callback; the light clusters and the LOD
+// selection read it every frame
+int scrWidth = SCR_WIDTH, scrHeight = SCR_HEIGHT;
+
+// airplane state (position, attitude, speed, cobra flags, camera orbit)
+FlightState flight;
 
-glm::vec3 airplanePosition(-102.815, 1, -59.034); // Start higher in the air
-glm::vec3 cameraOffset(0.0f, 8.0f, 0.0f); // Camera is slightly above and behind the airplane
-Camera camera(airplanePosition + cameraOffset);
+// camera
+Camera camera(flight.position + flight.cameraOffset);
 
-bool isPlaneTouchGround;
-bool pressingS;
 // timing
 float deltaTime = 0.0f;	
-float lastFrame = 0.0f;
+double lastFrame = 0.0;
 
-// airplane control variables
-float pitch = 0.0f; // x-axis rotation
-float yaw = 0.0f;   // y-axis rotation
-float roll = 0.0f;  // z-axis rotation
-float speed = 1.0f;
+// fixed-step simulation: the flight model always advances in SIM_DT ticks, rendering interpolates between them
+const double SIM_DT = 1.0 / 240.0;
+const double MAX_FRAME_TIME = 0.25; // clamp long frames (window drag, breakpoints) so the sim doesn't spiral
+float simTimeScale = 1.0f;          // > 1.0 runs the simulation faster than real time
+double simAccumulator = 0.0;
 
-float groundscale = 0.3f;
-float airplanescale = 0.15f;
+// previous tick's state, used to interpolate the rendered airplane between ticks
+glm::vec3 prevAirplanePosition = flight.position;
+glm::quat prevAirplaneRotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+
+// baked IBL maps of newport_loft.hdr, written next to the executable after the first bake
+const char *IBL_CACHE_FILE = "newport_loft.iblcache";
+
+// linked shader programs as driver binaries, rewritten whenever one had to be compiled
+const char *PROGRAM_CACHE_FILE = "shaders.progcache";
+
+// diffuse IBL: 9 SH coefficients evaluated in the shader, or the convolution cubemap (H toggles)
+bool useShIrradiance = true;
+
+// F9 writes the profiler's last frames as a Chrome trace next to the executable
+const char *PROFILE_TRACE_FILE = "frame_trace.json";
+bool profileTraceRequested = false;
 
-bool cobra = false;
+// flight state of every simulation tick, written in the background (tools__telemetry_to_csv decodes it)
+const char *TELEMETRY_FILE = "flight.telemetry";
 
-float lastPitch = 0.0f;
-float lastPitchUpdateTime = 0.0f;
-float cobraEndTime = 0.0f;
-float pitchRate;
-float cobraStartTime = 0.0f;
+// every tick's input and state, for an exact replay with tools__flight_replay
+const char *FLIGHT_RECORDING_FILE = "flight.flightrec";
+FlightRecorder flightRecorder;
+
+// mouse motion since the last tick; it goes into the next tick's input so recordings replay exactly
+glm::vec2 pendingMouse = glm::vec2(0.0f);
+
+// surface under each airplane before a tick: the sea or the terrain, or the carrier's deck where a ray cast
+// down from just above the airplane hits it. The deck only matters within reach of the landing gear, so the
+// rays are short.
+const float GROUND_RAY_LENGTH = 50.0f;
+const CollisionMesh *carrierCollision = nullptr;
+const TerrainStreamer *groundTerrain = nullptr;
+
+float groundscale = 0.3f;
+float airplanescale = 0.15f;
 
 
 
@@ -96,6 +148,7 @@ int main()
         glfwTerminate();
         return -1;
     }
+    glfwSwapInterval(1); // pace frames with vsync instead of sleeping
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
 glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED); // Mouse imlecini gizle ve kontrolü al.
@@ -112,6 +165,23 @@ glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED); // Mouse imlecini g
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    // glMultiDrawElementsIndirect is past glad's GL 3.3; without it MultiDrawList loops over its commands
+    bool indirectDraws = loadMultiDrawIndirect((GLADloadproc)glfwGetProcAddress);
+    // program binaries and parallel shader compilation are past it as well; ProgramCache works without them
+    loadProgramBinary((GLADloadproc)glfwGetProcAddress);
+
+    // per-pass CPU and GPU timings; the IBL bake is profiled as a frame of its own
+    FrameProfiler profiler;
+    ProfileHistory profileHistory;
+    std::future<bool> profileTraceWrite; // the F9 trace being written, reported by the render loop
+    size_t profileTraceFrames = 0;
+
+    TelemetryWriter telemetry;
+    if (!telemetry.open(TELEMETRY_FILE))
+        std::cout << "Failed to open telemetry file " << TELEMETRY_FILE << std::endl;
+    uint64_t simTicks = 0;
+    if (!flightRecorder.open(FLIGHT_RECORDING_FILE, SIM_DT))
+        std::cout << "Failed to open flight recording " << FLIGHT_RECORDING_FILE << std::endl;
 
     // configure global opengl state
     // -----------------------------
@@ -123,19 +193,32 @@ glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED); // Mouse imlecini g
 
     // build and compile shaders
     // -------------------------
-    Shader pbrShader("2.2.2.pbr.vs", "2.2.2.pbr.fs");
-    Shader equirectangularToCubemapShader("2.2.2.cubemap.vs", "2.2.2.equirectangular_to_cubemap.fs");
-    Shader irradianceShader("2.2.2.cubemap.vs", "2.2.2.irradiance_convolution.fs");
-    Shader prefilterShader("2.2.2.cubemap.vs", "2.2.2.prefilter.fs");
-    Shader brdfShader("2.2.2.brdf.vs", "2.2.2.brdf.fs");
-    Shader backgroundShader("2.2.2.background.vs", "2.2.2.background.fs");
+    ProgramCache programs(PROGRAM_CACHE_FILE);
+    ShaderProgram &pbrShader = programs.add("2.2.2.pbr.vs", "2.2.2.pbr.fs", "", lightClusterDefines());
+    ShaderProgram &equirectangularToCubemapShader = programs.add("2.2.2.cubemap.vs", "2.2.2.equirectangular_to_cubemap.fs", "2.2.2.cubemap.gs");
+    ShaderProgram &irradianceShader = programs.add("2.2.2.cubemap.vs", "2.2.2.irradiance_convolution.fs", "2.2.2.cubemap.gs");
+    ShaderProgram &prefilterShader = programs.add("2.2.2.cubemap.vs", "2.2.2.prefilter.fs", "2.2.2.cubemap.gs");
+    ShaderProgram &brdfShader = programs.add("2.2.2.brdf.vs", "2.2.2.brdf.fs");
+    ShaderProgram &backgroundShader = programs.add("2.2.2.background.vs", "2.2.2.background.fs");
+    ShaderProgram &ourShader = programs.add("vertex_shader.glsl", "fragment_shader.glsl");
+    ShaderProgram &terrainShader = programs.add("terrain.vs", "terrain.fs");
+    // cached binaries where the driver still takes them, everything else compiled side by side
+    if (!programs.build())
+        std::cout << "Some shader programs failed to build" << std::endl;
+    std::cout << "Shader programları: " << programs.loadedBinaries() << " önbellekten, " << programs.compiledPrograms()
+              << " derlendi, " << programs.rejectedBinaries() << " ikili reddedildi"
+              << (programBinaryProcs().parallelCompile ? " (paralel derleme)" : "") << std::endl;
 
     
-    Shader ourShader("vertex_shader.glsl", "fragment_shader.glsl");
+    // start loading models and textures on worker threads; the IBL bake below runs meanwhile
+    // ----------------------------------------------------------------------------------------
+    ThreadPool workers;
+    AssetLoader assets(workers);
+    SceneModel &airplaneModel = *assets.loadModel(FileSystem::getPath("resources/objects/kaan/kaan.dae"));
+    // gemi ~100 küçük dokudan oluşuyor: dokular texture array'lere paketlenir, meshler dizi başına tek çizime birleşir
+    PackedModel &groundModel = *assets.loadPackedModel(FileSystem::getPath("resources/objects/ettayyariyyetul_gemiyye/ettayyariyyetul_gemiyye.dae"));
 
-    
-    Model airplaneModel(FileSystem::getPath("resources/objects/kaan/kaan.dae"));
-    Model groundModel(FileSystem::getPath("resources/objects/ettayyariyyetul_gemiyye/ettayyariyyetul_gemiyye.dae"));
+    std::vector<glm::mat4> airplaneMatrices;
 
     pbrShader.use();
     pbrShader.setInt("irradianceMap", 0);
@@ -146,6 +229,13 @@ glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED); // Mouse imlecini g
     pbrShader.setInt("metallicMap", 5);
     pbrShader.setInt("roughnessMap", 6);
     pbrShader.setInt("aoMap", 7);
+    // the buffer samplers must never share unit 0 with the cube map, even when multiDraw is off
+    pbrShader.setInt("drawTransforms", MultiDrawList::TRANSFORM_UNIT);
+    pbrShader.setInt("drawRecords", MultiDrawList::RECORD_UNIT);
+    pbrShader.setInt("bonePalettes", SkinPaletteBuffer::PALETTE_UNIT);
+    ourShader.use();
+    ourShader.setInt("drawTransforms", MultiDrawList::TRANSFORM_UNIT);
+    ourShader.setInt("drawRecords", MultiDrawList::RECORD_UNIT);
 
     backgroundShader.use();
     backgroundShader.setInt("environmentMap", 0);
@@ -154,11 +244,11 @@ glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED); // Mouse imlecini g
     // --------------------------
 
     // gold
-    unsigned int airplaneAlbedoMap = loadTexturef(FileSystem::getPath("resources/objects/kaan/kaan.png").c_str());
-    unsigned int airplaneNormalMap = loadTexturef(FileSystem::getPath("resources/textures/pbr/gold/normal.png").c_str());
-    unsigned int airplaneMetalicMap = loadTexturef(FileSystem::getPath("resources/textures/pbr/gold/metallic.png").c_str());
-    unsigned int airplaneRoughnessMap = loadTexturef(FileSystem::getPath("resources/textures/pbr/gold/roughness.png").c_str());
-    unsigned int airplaneAOMap = loadTexturef(FileSystem::getPath("resources/textures/pbr/gold/ao.png").c_str());
+    unsigned int airplaneAlbedoMap = assets.loadTexture(FileSystem::getPath("resources/objects/kaan/kaan.png"));
+    unsigned int airplaneNormalMap = assets.loadTexture(FileSystem::getPath("resources/textures/pbr/gold/normal.png"));
+    unsigned int airplaneMetalicMap = assets.loadTexture(FileSystem::getPath("resources/textures/pbr/gold/metallic.png"));
+    unsigned int airplaneRoughnessMap = assets.loadTexture(FileSystem::getPath("resources/textures/pbr/gold/roughness.png"));
+    unsigned int airplaneAOMap = assets.loadTexture(FileSystem::getPath("resources/textures/pbr/gold/ao.png"));
 
 
     // lights
@@ -176,223 +266,439 @@ glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED); // Mouse imlecini g
         glm::vec3(300.0f, 300.0f, 300.0f)
     };
 
-    // pbr: setup framebuffer
-    // ----------------------
-    unsigned int captureFBO;
-    unsigned int captureRBO;
-    glGenFramebuffers(1, &captureFBO);
-    glGenRenderbuffers(1, &captureRBO);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
-
-    // pbr: load the HDR environment map
-    // ---------------------------------
-    stbi_set_flip_vertically_on_load(true);
-    int width, height, nrComponents;
-    float *data = stbi_loadf(FileSystem::getPath("resources/textures/hdr/newport_loft.hdr").c_str(), &width, &height, &nrComponents, 0);
-    unsigned int hdrTexture;
-    if (data)
-    {
-        glGenTextures(1, &hdrTexture);
-        glBindTexture(GL_TEXTURE_2D, hdrTexture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, data); // note how we specify the texture's data value to be float
+    // pbr: IBL maps are baked once per HDR and bake settings, then loaded from the on-disk cache
+    // -------------------------------------------------------------------------------------------
+    IblBakeSettings bakeSettings;
+    std::string hdrPath = FileSystem::getPath("resources/textures/hdr/newport_loft.hdr");
+    uint64_t iblKey = iblCacheKey(hdrPath, bakeSettings);
+    unsigned int envCubemap, irradianceMap, prefilterMap, brdfLUTTexture;
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
+    IblCache iblCache;
+    if (iblKey != 0 && readIblCache(IBL_CACHE_FILE, iblKey, iblCache))
+    {
+        envCubemap = uploadIblImage(iblCache.environment);
+        irradianceMap = uploadIblImage(iblCache.irradiance);
+        prefilterMap = uploadIblImage(iblCache.prefilter);
+        brdfLUTTexture = uploadIblImage(iblCache.brdfLUT);
+        std::cout << "IBL önbelleği yüklendi: " << IBL_CACHE_FILE << std::endl;
     }
     else
     {
-        std::cout << "Failed to load HDR image." << std::endl;
-    }
+        profiler.beginFrame();
+
+        // pbr: setup framebuffer. Cubemaps are captured layered: a whole cubemap mip is attached at once and
+        // 2.2.2.cubemap.gs sends the cube to all six faces, so every cubemap mip is one draw. A layered
+        // framebuffer can't have a plain depth renderbuffer, and the cube seen from its center needs none.
+        // -----------------------------------------------------------------------------------------------------
+        unsigned int captureFBO;
+        glGenFramebuffers(1, &captureFBO);
+
+        // pbr: load the HDR environment map
+        // ---------------------------------
+        stbi_set_flip_vertically_on_load(true);
+        int width, height, nrComponents;
+        float *data = stbi_loadf(hdrPath.c_str(), &width, &height, &nrComponents, 0);
+        // without the HDR the bake below still runs, from texture 0, so the maps exist, but they are black
+        // and must not end up in the cache
+        unsigned int hdrTexture = 0;
+        const bool hdrLoaded = data != nullptr;
+        if (data)
+        {
+            glGenTextures(1, &hdrTexture);
+            glBindTexture(GL_TEXTURE_2D, hdrTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, data); // note how we specify the texture's data value to be float
 
-    // pbr: setup cubemap to render to and attach to framebuffer
-    // ---------------------------------------------------------
-    unsigned int envCubemap;
-    glGenTextures(1, &envCubemap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
-    for (unsigned int i = 0; i < 6; ++i)
-    {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 512, 512, 0, GL_RGB, GL_FLOAT, nullptr);
-    }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // enable pre-filter mipmap sampling (combatting visible dots artifact)
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    // pbr: set up projection and view matrices for capturing data onto the 6 cubemap face directions
-    // ----------------------------------------------------------------------------------------------
-    glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
-    glm::mat4 captureViews[] =
-    {
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
-    };
+            stbi_image_free(data);
+        }
+        else
+        {
+            std::cout << "Failed to load HDR image." << std::endl;
+        }
 
-    // pbr: convert HDR equirectangular environment map to cubemap equivalent
-    // ----------------------------------------------------------------------
-    equirectangularToCubemapShader.use();
-    equirectangularToCubemapShader.setInt("equirectangularMap", 0);
-    equirectangularToCubemapShader.setMat4("projection", captureProjection);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, hdrTexture);
-
-    glViewport(0, 0, 512, 512); // don't forget to configure the viewport to the capture dimensions.
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    for (unsigned int i = 0; i < 6; ++i)
-    {
-        equirectangularToCubemapShader.setMat4("view", captureViews[i]);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, envCubemap, 0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // pbr: setup cubemap to render to and attach to framebuffer
+        // ---------------------------------------------------------
+        glGenTextures(1, &envCubemap);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+        for (unsigned int i = 0; i < 6; ++i)
+        {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, bakeSettings.environmentSize, bakeSettings.environmentSize, 0, GL_RGB, GL_FLOAT, nullptr);
+        }
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // enable pre-filter mipmap sampling (combatting visible dots artifact)
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        // pbr: set up projection and view matrices for capturing data onto the 6 cubemap face directions
+        // ----------------------------------------------------------------------------------------------
+        glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
+        glm::mat4 captureViews[] =
+        {
+            glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+            glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+            glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)),
+            glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)),
+            glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+            glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
+        };
+        glm::mat4 captureViewProjections[6];
+        for (unsigned int i = 0; i < 6; ++i)
+            captureViewProjections[i] = captureProjection * captureViews[i];
+        auto setCaptureViews = [&captureViewProjections](ShaderProgram &shader) {
+            glUniformMatrix4fv(shader.uniforms.location("captureViewProjections"), 6, GL_FALSE, &captureViewProjections[0][0][0]);
+        };
+
+        // pbr: convert HDR equirectangular environment map to cubemap equivalent
+        // ----------------------------------------------------------------------
+        int bakeZone = profiler.begin("ibl: equirect to cubemap", true);
+        equirectangularToCubemapShader.use();
+        equirectangularToCubemapShader.setInt("equirectangularMap", 0);
+        setCaptureViews(equirectangularToCubemapShader);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, hdrTexture);
 
+        glViewport(0, 0, bakeSettings.environmentSize, bakeSettings.environmentSize); // don't forget to configure the viewport to the capture dimensions.
+        glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, envCubemap, 0);
+        glClear(GL_COLOR_BUFFER_BIT);
         renderCube();
-    }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    // then let OpenGL generate mipmaps from first mip face (combatting visible dots artifact)
-    glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
-    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-
-    // pbr: create an irradiance cubemap, and re-scale capture FBO to irradiance scale.
-    // --------------------------------------------------------------------------------
-    unsigned int irradianceMap;
-    glGenTextures(1, &irradianceMap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
-    for (unsigned int i = 0; i < 6; ++i)
-    {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 32, 32, 0, GL_RGB, GL_FLOAT, nullptr);
-    }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 32, 32);
-
-    // pbr: solve diffuse integral by convolution to create an irradiance (cube)map.
-    // -----------------------------------------------------------------------------
-    irradianceShader.use();
-    irradianceShader.setInt("environmentMap", 0);
-    irradianceShader.setMat4("projection", captureProjection);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
-
-    glViewport(0, 0, 32, 32); // don't forget to configure the viewport to the capture dimensions.
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    for (unsigned int i = 0; i < 6; ++i)
-    {
-        irradianceShader.setMat4("view", captureViews[i]);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceMap, 0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        // then let OpenGL generate mipmaps from first mip face (combatting visible dots artifact)
+        glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+        profiler.end(bakeZone);
 
+        // pbr: create an irradiance cubemap
+        // --------------------------------------------------------------------------------
+        glGenTextures(1, &irradianceMap);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
+        for (unsigned int i = 0; i < 6; ++i)
+        {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, bakeSettings.irradianceSize, bakeSettings.irradianceSize, 0, GL_RGB, GL_FLOAT, nullptr);
+        }
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+
+        // pbr: solve diffuse integral by convolution to create an irradiance (cube)map.
+        // -----------------------------------------------------------------------------
+        bakeZone = profiler.begin("ibl: irradiance", true);
+        irradianceShader.use();
+        irradianceShader.setInt("environmentMap", 0);
+        setCaptureViews(irradianceShader);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+
+        glViewport(0, 0, bakeSettings.irradianceSize, bakeSettings.irradianceSize); // don't forget to configure the viewport to the capture dimensions.
+        glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, irradianceMap, 0);
+        glClear(GL_COLOR_BUFFER_BIT);
         renderCube();
-    }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    // pbr: create a pre-filter cubemap, and re-scale capture FBO to pre-filter scale.
-    // --------------------------------------------------------------------------------
-    unsigned int prefilterMap;
-    glGenTextures(1, &prefilterMap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
-    for (unsigned int i = 0; i < 6; ++i)
-    {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 128, 128, 0, GL_RGB, GL_FLOAT, nullptr);
-    }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // be sure to set minification filter to mip_linear 
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    // generate mipmaps for the cubemap so OpenGL automatically allocates the required memory.
-    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-
-    // pbr: run a quasi monte-carlo simulation on the environment lighting to create a prefilter (cube)map.
-    // ----------------------------------------------------------------------------------------------------
-    prefilterShader.use();
-    prefilterShader.setInt("environmentMap", 0);
-    prefilterShader.setMat4("projection", captureProjection);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    unsigned int maxMipLevels = 5;
-    for (unsigned int mip = 0; mip < maxMipLevels; ++mip)
-    {
-        // reisze framebuffer according to mip-level size.
-        unsigned int mipWidth = static_cast<unsigned int>(128 * std::pow(0.5, mip));
-        unsigned int mipHeight = static_cast<unsigned int>(128 * std::pow(0.5, mip));
-        glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mipWidth, mipHeight);
-        glViewport(0, 0, mipWidth, mipHeight);
-
-        float roughness = (float)mip / (float)(maxMipLevels - 1);
-        prefilterShader.setFloat("roughness", roughness);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        profiler.end(bakeZone);
+
+        // pbr: create a pre-filter cubemap
+        // --------------------------------------------------------------------------------
+        glGenTextures(1, &prefilterMap);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
         for (unsigned int i = 0; i < 6; ++i)
         {
-            prefilterShader.setMat4("view", captureViews[i]);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, prefilterMap, mip);
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, bakeSettings.prefilterSize, bakeSettings.prefilterSize, 0, GL_RGB, GL_FLOAT, nullptr);
+        }
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // be sure to set minification filter to mip_linear 
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        // generate mipmaps for the cubemap so OpenGL automatically allocates the required memory.
+        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+
+        // pbr: run a quasi monte-carlo simulation on the environment lighting to create a prefilter (cube)map.
+        // ----------------------------------------------------------------------------------------------------
+        bakeZone = profiler.begin("ibl: prefilter", true);
+        prefilterShader.use();
+        prefilterShader.setInt("environmentMap", 0);
+        setCaptureViews(prefilterShader);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
 
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+        unsigned int maxMipLevels = bakeSettings.prefilterMipLevels;
+        for (unsigned int mip = 0; mip < maxMipLevels; ++mip)
+        {
+            // one draw per mip: all six faces of the level are attached at once
+            unsigned int mipWidth = static_cast<unsigned int>(bakeSettings.prefilterSize * std::pow(0.5, mip));
+            unsigned int mipHeight = static_cast<unsigned int>(bakeSettings.prefilterSize * std::pow(0.5, mip));
+            glViewport(0, 0, mipWidth, mipHeight);
+
+            float roughness = (float)mip / (float)(maxMipLevels - 1);
+            prefilterShader.setFloat("roughness", roughness);
+            glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, prefilterMap, mip);
+            glClear(GL_COLOR_BUFFER_BIT);
             renderCube();
         }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        profiler.end(bakeZone);
+
+        // pbr: generate a 2D LUT from the BRDF equations used.
+        // ----------------------------------------------------
+        glGenTextures(1, &brdfLUTTexture);
+
+        // pre-allocate enough memory for the LUT texture.
+        glBindTexture(GL_TEXTURE_2D, brdfLUTTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, bakeSettings.brdfSize, bakeSettings.brdfSize, 0, GL_RG, GL_FLOAT, 0);
+        // be sure to set wrapping mode to GL_CLAMP_TO_EDGE
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        // then re-configure capture framebuffer object and render screen-space quad with BRDF shader.
+        glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, brdfLUTTexture, 0);
+
+        bakeZone = profiler.begin("ibl: brdf lut", true);
+        glViewport(0, 0, bakeSettings.brdfSize, bakeSettings.brdfSize);
+        brdfShader.use();
+        glClear(GL_COLOR_BUFFER_BIT);
+        renderQuad();
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &captureFBO);
+        profiler.end(bakeZone);
+
+        // pbr: save every baked mip so the next launch can skip all of the above
+        // -----------------------------------------------------------------------
+        bakeZone = profiler.begin("ibl: download and write");
+        uint32_t environmentLevels = 1 + static_cast<uint32_t>(std::floor(std::log2(static_cast<float>(bakeSettings.environmentSize))));
+        iblCache.key = iblKey;
+        iblCache.environment = downloadIblImage(envCubemap, true, 3, environmentLevels);
+        iblCache.irradiance = downloadIblImage(irradianceMap, true, 3, 1);
+        iblCache.prefilter = downloadIblImage(prefilterMap, true, 3, bakeSettings.prefilterMipLevels);
+        iblCache.brdfLUT = downloadIblImage(brdfLUTTexture, false, 2, 1);
+        if (!hdrLoaded)
+            std::cout << "IBL cache not written: the HDR image didn't load" << std::endl;
+        else if (iblKey == 0 || !writeIblCache(IBL_CACHE_FILE, iblCache))
+            std::cout << "Failed to write IBL cache " << IBL_CACHE_FILE << std::endl;
+        profiler.end(bakeZone);
+        profiler.endFrame();
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    // pbr: generate a 2D LUT from the BRDF equations used.
-    // ----------------------------------------------------
-    unsigned int brdfLUTTexture;
-    glGenTextures(1, &brdfLUTTexture);
-
-    // pre-allocate enough memory for the LUT texture.
-    glBindTexture(GL_TEXTURE_2D, brdfLUTTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, 512, 512, 0, GL_RG, GL_FLOAT, 0);
-    // be sure to set wrapping mode to GL_CLAMP_TO_EDGE
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    // then re-configure capture framebuffer object and render screen-space quad with BRDF shader.
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, brdfLUTTexture, 0);
-
-    glViewport(0, 0, 512, 512);
-    brdfShader.use();
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    renderQuad(1.0f);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+    // pbr: project the environment onto L2 spherical harmonics for the diffuse term; a 32x32 mip is enough
+    // ------------------------------------------------------------------------------------------------------
+    ShIrradiance shIrradiance = projectIrradianceSh(iblCache.environment, mipForFaceSize(iblCache.environment.width, 32));
+    pbrShader.use();
+    for (unsigned int i = 0; i < 9; ++i)
+        pbrShader.setVec3("shIrradiance[" + std::to_string(i) + "]", shIrradiance.coefficients[i]);
 
-    // initialize static shader uniforms before rendering
-    // --------------------------------------------------
+    // camera for the scene programs: one uniform buffer, written once per frame. The projections never
+    // change; view and camPos are filled in by the render loop.
+    // -----------------------------------------------------------------------------------------
     glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-    pbrShader.use();
-    pbrShader.setMat4("projection", projection);
-    backgroundShader.use();
-    backgroundShader.setMat4("projection", projection);
+    FrameUniformBuffer frameUniformBuffer;
+    FrameUniforms frameUniforms;
+    frameUniforms.projection = projection;
+    for (ShaderProgram *shader : { &ourShader, &pbrShader, &backgroundShader, &terrainShader })
+        FrameUniformBuffer::attach(*shader);
 
     // then before rendering, configure the viewport to the original framebuffer's screen dimensions
-    int scrWidth, scrHeight;
     glfwGetFramebufferSize(window, &scrWidth, &scrHeight);
     glViewport(0, 0, scrWidth, scrHeight);
 
+    // finish loading: GL uploads a few milliseconds per frame, with a progress bar in between
+    // ---------------------------------------------------------------------------------------
+    // the terrain around the start position streams in meanwhile, so the first frame has no holes
+    TerrainStreamer terrain(workers);
+    terrain.update(flight.position);
+    while (!(assets.update(0.008) && terrain.ready()) && !glfwWindowShouldClose(window))
+    {
+        renderLoadingFrame(window, assets.progress());
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+        processInput(window);
+        terrain.update(flight.position);
+    }
+    std::cout << "Gemi: " << groundModel.sourceMeshes << " mesh, " << groundModel.sourceTextures << " doku, "
+              << groundModel.arrayCount() << " doku dizisi" << std::endl;
+    std::cout << "Gemi çarpışma ağacı: " << groundModel.collision.triangleCount() << " üçgen, "
+              << groundModel.collision.nodeCount() << " düğüm" << std::endl;
+
+    // Ground model: the carrier never moves, so its matrix (and its world-space bounds) are fixed
+    glm::mat4 groundModelMatrix = glm::mat4(1.0f);
+    groundModelMatrix = glm::scale(groundModelMatrix, glm::vec3(groundscale, groundscale, groundscale));
+
+    groundModelMatrix = glm::translate(groundModelMatrix, glm::vec3(0.0f, 0.0f, 0.0f)); // Pozisyonu uygula.
+
+    groundModelMatrix = glm::rotate(groundModelMatrix, glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f)); // Yaw
+    groundModelMatrix = glm::rotate(groundModelMatrix, glm::radians(360.0f), glm::vec3(1.0f, 0.0f, 0.0f)); // Pitch
+    groundModelMatrix = glm::rotate(groundModelMatrix, glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f)); // Roll
+    // a moving carrier would call setTransform() every tick instead
+    groundModel.collision.setTransform(groundModelMatrix);
+    carrierCollision = &groundModel.collision;
+    groundTerrain = &terrain;
+    glm::mat4 groundProjection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 1000.0f);
+    frameUniforms.worldProjection = groundProjection;
+
+    // static geometry in one megabuffer: airplane meshes and the carrier batches. Each pass is
+    // one multi-draw list rebuilt every frame.
+    // ----------------------------------------------------------------------------------------------------
+    GeometryBuffer geometry;
+    std::vector<GeometryRange> airplaneRanges;
+    for (const SceneMesh &mesh : airplaneModel.meshes)
+        airplaneRanges.push_back(geometry.add(mesh));
+    std::vector<GeometryRange> groundRanges;
+    for (size_t i = 0; i < groundModel.drawCount(); i++)
+        groundRanges.push_back(geometry.add(groundModel.batchMesh(i), groundModel.batchLayers(i)));
+    MultiDrawList airplaneDraws(geometry);
+    // one list per texture array; meshes without a texture go with the first one
+    std::vector<std::unique_ptr<MultiDrawList>> groundDraws;
+    for (size_t i = 0; i < std::max<size_t>(groundModel.arrayCount(), 1); i++)
+        groundDraws.emplace_back(new MultiDrawList(geometry));
+
+    // culling: every source mesh of the carrier is one BVH item (its slice of the merged batch), the
+    // airplanes are boxes tested every frame
+    // ----------------------------------------------------------------------------------------------
+    struct CarrierItem
+    {
+        GeometryRange range;
+        size_t list;
+    };
+    std::vector<CarrierItem> carrierItems;
+    std::vector<Aabb> carrierBoxes;
+    for (size_t i = 0; i < groundRanges.size(); i++)
+    {
+        for (const PackedMeshRange &mesh : groundModel.batchMeshes(i))
+        {
+            CarrierItem item;
+            item.range = groundRanges[i];
+            item.range.firstIndex += mesh.firstIndex;
+            item.range.indexCount = mesh.indexCount;
+            item.list = static_cast<size_t>(std::max(groundModel.batchArray(i), 0));
+            carrierItems.push_back(item);
+            carrierBoxes.push_back(transformAabb(mesh.bounds, groundModelMatrix));
+        }
+    }
+    Bvh4 carrierBvh;
+    carrierBvh.build(carrierBoxes);
+
+    // point lights for the PBR pass, binned into clusters of its view every frame: the four scene lights,
+    // two rows of deck edge lights along the carrier and, added per frame, each airplane's navigation lights
+    // and strobe
+    // ------------------------------------------------------------------------------------------------------
+    std::vector<PointLight> staticLights;
+    for (int i = 0; i < 4; ++i)
+        staticLights.push_back({ lightPositions[i], pointLightRadius(lightColors[i]), lightColors[i] });
+    Aabb carrierBounds;
+    for (const Aabb &box : carrierBoxes)
+        carrierBounds.expand(box);
+    if (!carrierBounds.empty())
+    {
+        // along the longer horizontal side, at deck height
+        int lengthAxis = (carrierBounds.max.x - carrierBounds.min.x) > (carrierBounds.max.z - carrierBounds.min.z) ? 0 : 2;
+        int widthAxis = 2 - lengthAxis;
+        const int DECK_LIGHTS_PER_ROW = 48;
+        const glm::vec3 deckLightColor = glm::vec3(2.0f, 1.6f, 1.0f);
+        for (int side = 0; side < 2; ++side)
+        {
+            for (int i = 0; i < DECK_LIGHTS_PER_ROW; ++i)
+            {
+                glm::vec3 position;
+                position[lengthAxis] = glm::mix(carrierBounds.min[lengthAxis], carrierBounds.max[lengthAxis], (i + 0.5f) / DECK_LIGHTS_PER_ROW);
+                position[widthAxis] = side == 0 ? carrierBounds.min[widthAxis] : carrierBounds.max[widthAxis];
+                position.y = carrierBounds.max.y;
+                staticLights.push_back({ position, pointLightRadius(deckLightColor), deckLightColor });
+            }
+        }
+    }
+    std::vector<PointLight> frameLights;
+    LightClusters lightClusters;
+    lightClusters.setProjection(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+    LightClusterBuffers lightClusterBuffers;
+    Aabb airplaneBounds;
+    for (const SceneMesh &mesh : airplaneModel.meshes)
+        airplaneBounds.expand(mesh.bounds);
+    std::vector<uint32_t> visibleItems;
+    std::vector<Aabb> movingBoxes;
+    CullStats cullStats;
+
+    // airplane LODs: a level per visible airplane from its size on screen, instances grouped by level
+    LodSelector airplaneLods;
+    airplaneLods.setModel(airplaneModel.lodErrors(), glm::length(airplaneBounds.max - airplaneBounds.min) * 0.5f);
+    std::vector<std::vector<glm::mat4>> airplanesByLod(airplaneLods.levels());
+    size_t airplaneTriangles = 0, airplaneFullTriangles = 0;
+
+    // skeletal animation, if the airplane model is rigged: the first clip loops all the time and the second
+    // (control surfaces, say) is blended in by how hard each airplane pitches. Only the visible airplanes
+    // are evaluated, on the workers, and all their palettes go up in one buffer.
+    const ModelAnimation &airplaneAnimation = airplaneModel.animation;
+    const bool airplaneSkinned = !airplaneAnimation.empty();
+    const int airplaneOverlayClip = airplaneAnimation.clips.size() > 1 ? 1 : -1;
+    std::vector<SkinnedInstance> airplaneSkins(1);
+    std::vector<float> airplaneOverlayWeights(1);
+    std::vector<std::vector<int>> paletteBasesByLod(airplaneLods.levels());
+    std::vector<glm::vec4> airplanePalettes;
+    SkinPaletteBuffer skinPalettes;
+    if (airplaneSkinned)
+        std::cout << "Animasyon: " << airplaneAnimation.skeleton.size() << " eklem, " << airplaneAnimation.clips.size()
+                  << " klip" << std::endl;
+    std::cout << "Ayıklama: " << carrierItems.size() << " gemi mesh'i, " << carrierBvh.nodeCount() << " BVH düğümü"
+              << std::endl;
+    std::cout << "Geometri: " << geometry.vertexCount() << " köşe (" << geometry.vertexCount() * sizeof(PackedVertex) / 1024
+              << " KB, float köşelerle " << geometry.vertexCount() * sizeof(Vertex) / 1024 << " KB), "
+              << geometry.indexCount() << " indeks, " << (indirectDraws ? "glMultiDrawElementsIndirect" : "tek tek çizim (MDI yok)") << std::endl;
+
+    // render queue: programs with their per-frame uniforms, and the texture set of every material.
+    // Camera and lights come from the frame uniform buffer; what is left goes through cached locations.
+    // -----------------------------------------------------------------------------------------------
+    RenderQueue renderQueue;
+    glm::mat4 frameView = camera.GetViewMatrix();
+    int groundShaderId = renderQueue.addShader(ourShader, [&](ShaderProgram &shader) {
+        shader.setBool("useTextureArray", true);
+        shader.setInt("material.texture_array", PackedModel::ARRAY_UNIT);
+    });
+    int pbrShaderId = renderQueue.addShader(pbrShader, [&](ShaderProgram &shader) {
+        shader.setBool("useShIrradiance", useShIrradiance);
+        lightClusterBuffers.bind(shader, scrWidth, scrHeight);
+        skinPalettes.bind(shader);
+    });
+    int backgroundShaderId = renderQueue.addShader(backgroundShader);
+    const TerrainSettings terrainSettings;
+    int terrainShaderId = renderQueue.addShader(terrainShader, [&](ShaderProgram &shader) {
+        shader.setVec3("lightDirection", glm::vec3(0.4f, 0.8f, 0.3f));
+        shader.setFloat("seaLevel", terrainSettings.seaLevel);
+        shader.setFloat("fogDistance", terrainSettings.viewDistance);
+    });
+    std::vector<int> groundMaterials;
+    for (size_t i = 0; i < groundDraws.size(); i++)
+    {
+        unsigned int array = i < groundModel.arrayCount() ? groundModel.arrayTexture(i) : 0;
+        groundMaterials.push_back(renderQueue.addMaterial(groundShaderId, { { PackedModel::ARRAY_UNIT, GL_TEXTURE_2D_ARRAY, array } }));
+    }
+    // pre-computed IBL data and the airplane PBR maps; the irradiance map is unused while SH is on
+    int airplaneMaterial = renderQueue.addMaterial(pbrShaderId, {
+        { 0, GL_TEXTURE_CUBE_MAP, irradianceMap },
+        { 1, GL_TEXTURE_CUBE_MAP, prefilterMap },
+        { 2, GL_TEXTURE_2D, brdfLUTTexture },
+        { 3, GL_TEXTURE_2D, airplaneAlbedoMap },
+        { 4, GL_TEXTURE_2D, airplaneNormalMap },
+        { 5, GL_TEXTURE_2D, airplaneMetalicMap },
+        { 6, GL_TEXTURE_2D, airplaneRoughnessMap },
+        { 7, GL_TEXTURE_2D, airplaneAOMap },
+    });
+    int skyMaterial = renderQueue.addMaterial(backgroundShaderId, { { 0, GL_TEXTURE_CUBE_MAP, envCubemap } });
+    int terrainMaterial = renderQueue.addMaterial(terrainShaderId, {});
+    double renderStatsTime = 0.0;
+
     #pragma endregion
    
     // render loop
@@ -401,20 +707,40 @@ glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED); // Mouse imlecini g
     {
         // per-frame time logic
         // --------------------
-        float currentFrame = static_cast<float>(glfwGetTime());
-        deltaTime = currentFrame - lastFrame;
+        double currentFrame = glfwGetTime();
+        double frameTime = std::min(currentFrame - lastFrame, MAX_FRAME_TIME);
         lastFrame = currentFrame;
+        profiler.beginFrame();
+
+        // advance the flight model in fixed ticks, independent of the frame rate
+        // -----------------------------------------------------------------------
+        simAccumulator += frameTime * simTimeScale;
+        deltaTime = static_cast<float>(SIM_DT);
+        int simulationZone = profiler.begin("simulation");
+        while (simAccumulator >= SIM_DT)
+        {
+            prevAirplanePosition = flight.position;
+            prevAirplaneRotation = flightRotation(flight);
+            stepSimulation(window);
+            telemetry.record(telemetryRecord(flight, simTicks++));
+            simAccumulator -= SIM_DT;
+        }
+        profiler.end(simulationZone);
+        // how far we are between the last two ticks
+        float alpha = static_cast<float>(simAccumulator / SIM_DT);
+        glm::vec3 renderPosition = glm::mix(prevAirplanePosition, flight.position, alpha);
+        glm::quat renderRotation = glm::slerp(prevAirplaneRotation, flightRotation(flight), alpha);
 
-        float currentTime = static_cast<float>(glfwGetTime()); // Mevcut zaman
-        float pitchChange = pitch - lastPitch; // Pitch değişimi hesapla
-        float timeSinceLastUpdate = currentTime - lastPitchUpdateTime; // Son güncellemeden geçen süre
-
-
-         std::this_thread::sleep_for(std::chrono::milliseconds(8)); // Removed to improve airplane movement smoothness
-
-        // -----
-        processInput(window);
-
+        // Update camera position to follow the airplane
+        float baseDistance = 10.0f; float baseHeight = 3.0f; // cameraOffset.x ve cameraOffset.y'yi orbit açılar olarak kullanıyoruz.
+        float angleX = glm::radians(flight.cameraOffset.x);
+        float angleY = glm::radians(flight.cameraOffset.y);
+        float x = baseDistance * sin(angleX) * cos(angleY);
+        float y = baseDistance * sin(angleY) + baseHeight;
+        float z = baseDistance * cos(angleX) * cos(angleY);
+        camera.Position = renderPosition + glm::vec3(x, y, z);
+        camera.Front = glm::normalize(renderPosition - camera.Position);
+        camera.Up = glm::vec3(0,1,0);
 
         // render
         // ------
@@ -424,189 +750,186 @@ glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED); // Mouse imlecini g
         // render scene, supplying the convoluted irradiance map to the final shader.
         // ------------------------------------------------------------------------------------------
 
-        ourShader.use();
-        // Ground model
-
-        glm::mat4 groundModelMatrix = glm::mat4(1.0f);
-        groundModelMatrix = glm::scale(groundModelMatrix, glm::vec3(groundscale, groundscale, groundscale));
-                
-        groundModelMatrix = glm::translate(groundModelMatrix, glm::vec3(0.0f, 0.0f, 0.0f)); // Pozisyonu uygula.
-        
-        groundModelMatrix = glm::rotate(groundModelMatrix, glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f)); // Yaw
-        groundModelMatrix = glm::rotate(groundModelMatrix, glm::radians(360.0f), glm::vec3(1.0f, 0.0f, 0.0f)); // Pitch
-        groundModelMatrix = glm::rotate(groundModelMatrix, glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f)); // Roll
-
-        glm::mat4 viewxz = camera.GetViewMatrix();
-        glm::mat4 projectionxz = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 1000.0f);
-        ourShader.setMat4("model", groundModelMatrix);
-        ourShader.setMat4("view", viewxz);
-        ourShader.setMat4("projection", projectionxz);
-        groundModel.Draw(ourShader);
-
-        
-
-        pbrShader.use();
-        glm::mat4 model = glm::mat4(1.0f);
-        glm::mat4 view = camera.GetViewMatrix();
-        pbrShader.setMat4("view", view);
-        pbrShader.setVec3("camPos", camera.Position);
-
-       // bind pre-computed IBL data
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
-         
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, brdfLUTTexture);
-
-        glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_2D, airplaneAlbedoMap);
-        glActiveTexture(GL_TEXTURE4);
-        glBindTexture(GL_TEXTURE_2D, airplaneNormalMap);
-        glActiveTexture(GL_TEXTURE5);
-        glBindTexture(GL_TEXTURE_2D, airplaneMetalicMap);
-        glActiveTexture(GL_TEXTURE6);
-        glBindTexture(GL_TEXTURE_2D, airplaneRoughnessMap);
-        glActiveTexture(GL_TEXTURE7);
-        glBindTexture(GL_TEXTURE_2D, airplaneAOMap);
-        
-        pbrShader.use();
-
-        if (airplanePosition.y <= 1.0f) {
-            airplanePosition.y = 1.0f;
-            isPlaneTouchGround = true;
-        } else {
-            isPlaneTouchGround = false;
+        // Ground model: only the carrier meshes inside the view go out. Items are numbered in index buffer
+        // order, so sorted neighbours that are adjacent in the buffer merge back into one command.
+        frameView = camera.GetViewMatrix();
+        frameUniforms.view = frameView;
+        frameUniforms.camPos = glm::vec4(camera.Position, 1.0f);
+        frameUniformBuffer.update(frameUniforms);
+        renderQueue.begin(camera.Position);
+        int cullZone = profiler.begin("ground cull");
+        cullStats = CullStats();
+        visibleItems.clear();
+        carrierBvh.cull(extractFrustum(groundProjection * frameView), visibleItems, cullStats);
+        std::sort(visibleItems.begin(), visibleItems.end());
+        for (size_t i = 0; i < groundDraws.size(); i++)
+            groundDraws[i]->clear();
+        for (size_t i = 0; i < visibleItems.size();)
+        {
+            CarrierItem run = carrierItems[visibleItems[i]];
+            for (++i; i < visibleItems.size(); ++i)
+            {
+                const CarrierItem &next = carrierItems[visibleItems[i]];
+                if (next.list != run.list || next.range.baseVertex != run.range.baseVertex ||
+                    next.range.firstIndex != run.range.firstIndex + run.range.indexCount)
+                    break;
+                run.range.indexCount += next.range.indexCount;
+            }
+            groundDraws[run.list]->add(run.range, groundModelMatrix);
         }
-
-        if ((airplanePosition.y < 1.5f && airplanePosition.y > 1.0f) && pressingS == false) {
-            roll = 0.0f;
-            pitch = 0.0f;
+        profiler.end(cullZone);
+        for (size_t i = 0; i < groundDraws.size(); i++)
+        {
+            MultiDrawList &draws = *groundDraws[i];
+            renderQueue.submit(RENDER_PASS_OPAQUE, groundMaterials[i], nullptr, [&draws, &profiler](ShaderProgram &shader) {
+                ProfileScope zone(profiler, "ground", true);
+                draws.submit(shader);
+            });
         }
-        // Update camera position to follow the airplane
-        float baseDistance = 10.0f; float baseHeight = 3.0f; // cameraOffset.x ve cameraOffset.y'yi orbit açılar olarak kullanıyoruz.
-        float angleX = glm::radians(cameraOffset.x);
-        float angleY = glm::radians(cameraOffset.y);
-        float x = baseDistance * sin(angleX) * cos(angleY);
-        float y = baseDistance * sin(angleY) + baseHeight;
-        float z = baseDistance * cos(angleX) * cos(angleY);
-        camera.Position = airplanePosition + glm::vec3(x, y, z);
-        camera.Front = glm::normalize(airplanePosition - camera.Position);
-        camera.Up = glm::vec3(0,1,0);
-
-
-        glm::mat4 modelx = glm::mat4(1.0f);
-
-        // Uçağın pozisyonunu uygula
-        modelx = glm::translate(modelx, airplanePosition);
 
+        // Oyuncunun uçağı: pozisyon, quaternion, en sonda ölçekleme
+        auto airplaneMatrix = [](const glm::vec3 &position, const glm::quat &rotation) {
+            glm::mat4 modelx = glm::translate(glm::mat4(1.0f), position);
+            modelx *= glm::mat4_cast(rotation);
+            return glm::scale(modelx, glm::vec3(airplanescale, airplanescale, airplanescale));
+        };
+        int airplaneZone = profiler.begin("aircraft cull and lod");
+        airplaneMatrices.clear();
+        airplaneMatrices.push_back(airplaneMatrix(renderPosition, renderRotation));
+        // airplanes against the PBR camera
+        movingBoxes.clear();
+        for (const glm::mat4 &matrix : airplaneMatrices)
+            movingBoxes.push_back(transformAabb(airplaneBounds, matrix));
+        visibleItems.clear();
+        cullBoxes(extractFrustum(projection * frameView), movingBoxes, visibleItems, cullStats);
+        for (std::vector<glm::mat4> &bucket : airplanesByLod)
+            bucket.clear();
+        for (std::vector<int> &bucket : paletteBasesByLod)
+            bucket.clear();
+        // a skinned airplane's palette is its place in the visible list
+        const size_t paletteSize = skinPaletteSize(airplaneAnimation.skeleton);
+        for (size_t k = 0; k < visibleItems.size(); k++)
+        {
+            uint32_t item = visibleItems[k];
+            float distance = glm::length(glm::vec3(airplaneMatrices[item][3]) - camera.Position);
+            float size = airplaneLods.screenSize(distance, airplanescale, glm::radians(camera.Zoom), (float)scrHeight);
+            int level = airplaneLods.select(item, size);
+            airplanesByLod[level].push_back(airplaneMatrices[item]);
+            paletteBasesByLod[level].push_back(static_cast<int>(k * paletteSize));
+        }
 
-        // Zaman farkı 0'dan büyükse, saniyelik pitch değişimini hesapla
-        pitchRate = (timeSinceLastUpdate > 0) ? (pitch - lastPitch) / timeSinceLastUpdate : 0.0f;
-
-
-        std::cout << "Pitch değişim hızı: " << pitchRate << " derece/saniye" << std::endl;
-
-        // Pitch değerlerini güncelle
-        lastPitch = pitch;
-        lastPitchUpdateTime = currentTime;
-
-
-        // Pitch değerlerini güncelle
-        lastPitch = pitch;
-        lastPitchUpdateTime = currentTime;
-
-        // Quaternion dönüşümleri ayrı ayrı uygula
-        glm::quat yawQuat = glm::angleAxis(glm::radians(yaw), glm::vec3(0, 1, 0));  // Yaw (yön)
-        glm::quat pitchQuat = glm::angleAxis(glm::radians(pitch), glm::vec3(1, 0, 0)); // Pitch (burun yukarı/aşağı)
-        glm::quat rollQuat = glm::angleAxis(glm::radians(roll), glm::vec3(0, 0, 1)); // Roll (yan yatma)
-
-
-        glm::quat cobraPitchQuat = glm::angleAxis(glm::radians(10.0f), glm::vec3(1, 0, 0)); // Cobra manevrası için pitch
-
-
-        glm::quat finalRotation = yawQuat * pitchQuat * rollQuat;
-        glm::quat cobrafinalRotation = yawQuat * cobraPitchQuat * rollQuat;
-        
-
-        
-        // Quaternion'ü model matrisine uygula
-        modelx *= glm::mat4_cast(finalRotation);
-
-     
-        cobrafinalRotation = glm::normalize(cobrafinalRotation); // Bozulmaları önlemek için normalize et
-
-        finalRotation = glm::normalize(finalRotation); // Bozulmaları önlemek için normalize et
-
-        
-        glm::vec3 forward = ((cobra) ? cobrafinalRotation : finalRotation) * glm::vec3(0.0f, 0.0f, -1.0f);
-
-
-        airplanePosition += forward * (speed * deltaTime);
-
-        
-        // Ölçekleme en sonda uygulanmalı
-        modelx = glm::scale(modelx, glm::vec3(airplanescale, airplanescale, airplanescale));
-
-        // Shader'a model matrisini gönder
-        pbrShader.setMat4("model", modelx);
-        pbrShader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(modelx))));
-
-        // Modeli çiz
-        airplaneModel.Draw(pbrShader);
-
-
-
-
-
-
-        glm::mat4 modely = glm::mat4(1.0f);
-        glm::mat4 viewy = camera.GetViewMatrix();
-        pbrShader.setMat4("view", viewy);
-        pbrShader.setVec3("camPos", camera.Position);
-
-        modely = glm::mat4(1.0f);
-        modely = glm::translate(modely, glm::vec3(-5.0, 0.0, 0.0));
-
-        modely = glm::rotate(modely, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f)); //Pitch
-        modely = glm::rotate(modely, glm::radians(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)); // Yaw
-        modely = glm::rotate(modely, glm::radians(0.0f), glm::vec3(0.0f, 0.0f, 1.0f)); // Roll
-
-        
-        modely = glm::scale(modely, glm::vec3(30.0f, 30.0f, 30.0f));
-
-        pbrShader.setMat4("model", modely);
-        pbrShader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(modely))));
-        renderQuad(100.0f);   
+        // Modelleri tek seferde çiz: her mesh ve LOD seviyesi bir komut, o seviyedeki uçaklar onun instance'ları
+        airplaneDraws.clear();
+        airplaneTriangles = 0;
+        airplaneFullTriangles = 0;
+        for (size_t i = 0; i < airplaneRanges.size(); i++)
+        {
+            for (size_t level = 0; level < airplanesByLod.size(); level++)
+            {
+                const std::vector<glm::mat4> &instances = airplanesByLod[level];
+                GeometryRange range = GeometryBuffer::lodRange(airplaneRanges[i], airplaneModel.meshes[i], static_cast<int>(level));
+                airplaneDraws.add(range, instances.data(), instances.size(),
+                                  airplaneSkinned ? paletteBasesByLod[level].data() : nullptr);
+                airplaneTriangles += range.indexCount / 3 * instances.size();
+                airplaneFullTriangles += airplaneRanges[i].indexCount / 3 * instances.size();
+            }
+        }
+        profiler.end(airplaneZone);
 
-        // render light source (simply re-render sphere at light positions)
-        // this looks a bit off as we use the same shader, but it'll make their positions obvious and 
-        // keeps the codeprint small.
-        for (unsigned int i = 0; i < sizeof(lightPositions) / sizeof(lightPositions[0]); ++i)
+        if (airplaneSkinned)
         {
-            glm::vec3 newPos = lightPositions[i] + glm::vec3(sin(glfwGetTime() * 5.0) * 5.0, 0.0, 0.0);
-            newPos = lightPositions[i];
-            pbrShader.setVec3("lightPositions[" + std::to_string(i) + "]", newPos);
-            pbrShader.setVec3("lightColors[" + std::to_string(i) + "]", lightColors[i]);
-
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, newPos);
-            model = glm::scale(model, glm::vec3(0.5f));
-            pbrShader.setMat4("model", model);
-            pbrShader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(model))));
-            //renderSphere();
+            int skinZone = profiler.begin("skinning");
+            airplaneOverlayWeights[0] = std::min(std::fabs(flight.pitchRate) / 90.0f, 1.0f);
+            airplanePalettes.resize(visibleItems.size() * paletteSize * SKIN_PALETTE_TEXELS);
+            workers.parallelFor(visibleItems.size(), 1, [&](size_t begin, size_t end) {
+                for (size_t k = begin; k < end; k++)
+                {
+                    uint32_t item = visibleItems[k];
+                    // each airplane a little out of step, like the strobes
+                    airplaneSkins[item].evaluate(airplaneAnimation, 0, airplaneOverlayClip, static_cast<float>(flight.time + 0.37 * item),
+                                                 airplaneOverlayWeights[item], airplaneMatrices[item],
+                                                 airplanePalettes.data() + k * paletteSize * SKIN_PALETTE_TEXELS);
+                }
+            });
+            skinPalettes.upload(airplanePalettes);
+            profiler.end(skinZone);
         }
 
-        // render skybox (render as last to prevent overdraw)
-        backgroundShader.use();
+        // this frame's lights into the PBR camera's clusters: red and green at the wing tips, and a strobe
+        // that flashes for a tenth of a second every second, each airplane a little out of step
+        int lightZone = profiler.begin("light clusters");
+        frameLights = staticLights;
+        const glm::vec3 navigationRed = glm::vec3(1.5f, 0.05f, 0.05f), navigationGreen = glm::vec3(0.05f, 1.5f, 0.05f);
+        const glm::vec3 strobeWhite = glm::vec3(6.0f);
+        glm::vec3 wingCenter = airplaneBounds.center();
+        for (size_t i = 0; i < airplaneMatrices.size(); i++)
+        {
+            const glm::mat4 &matrix = airplaneMatrices[i];
+            glm::vec3 leftTip = glm::vec3(matrix * glm::vec4(airplaneBounds.min.x, wingCenter.y, wingCenter.z, 1.0f));
+            glm::vec3 rightTip = glm::vec3(matrix * glm::vec4(airplaneBounds.max.x, wingCenter.y, wingCenter.z, 1.0f));
+            frameLights.push_back({ leftTip, pointLightRadius(navigationRed), navigationRed });
+            frameLights.push_back({ rightTip, pointLightRadius(navigationGreen), navigationGreen });
+            if (std::fmod(currentFrame + 0.13 * i, 1.0) < 0.1)
+                frameLights.push_back({ glm::vec3(matrix[3]), pointLightRadius(strobeWhite), strobeWhite });
+        }
+        lightClusters.assign(frameLights, frameView, &workers);
+        lightClusterBuffers.upload(lightClusters);
+        profiler.end(lightZone);
+
+        renderQueue.submit(RENDER_PASS_OPAQUE, airplaneMaterial, nullptr, [&](ShaderProgram &shader) {
+            ProfileScope zone(profiler, "aircraft", true);
+            airplaneDraws.submit(shader);
+        });
+
+        // terrain and sea around the airplane: streamed chunks, culled with the carrier's camera
+        int terrainZone = profiler.begin("terrain update");
+        terrain.update(renderPosition);
+        terrain.cull(extractFrustum(groundProjection * frameView), cullStats);
+        profiler.end(terrainZone);
+        renderQueue.submit(RENDER_PASS_OPAQUE, terrainMaterial, nullptr, [&terrain, &profiler](ShaderProgram &) {
+            ProfileScope zone(profiler, "terrain", true);
+            terrain.draw();
+        });
+
+        // render skybox (the sky pass sorts after everything else to prevent overdraw)
+        renderQueue.submit(RENDER_PASS_SKY, skyMaterial, nullptr, [&profiler](ShaderProgram &) {
+            ProfileScope zone(profiler, "sky", true);
+            renderCube();
+        });
 
-        backgroundShader.setMat4("view", view);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
-        //glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap); // display irradiance map
-        //glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap); // display prefilter map
-        renderCube();
+        int flushZone = profiler.begin("render queue flush");
+        renderQueue.flush();
+        profiler.end(flushZone);
+        if (currentFrame - renderStatsTime > 5.0)
+        {
+            const RenderQueueStats &stats = renderQueue.stats();
+            std::cout << "Render kuyruğu: " << stats.packets << " paket, " << stats.stateChanges()
+                      << " durum değişikliği (" << stats.savedStateChanges() << " tasarruf), PBR "
+                      << airplaneDraws.commandCount() << " komut -> " << airplaneDraws.drawCalls() << " çizim çağrısı"
+                      << std::endl;
+            std::cout << "Ayıklama: " << cullStats.boxesTested << " kutu testi, " << cullStats.items << " nesneden "
+                      << cullStats.culled << " tanesi elendi" << std::endl;
+            const LightClusterStats &lightStats = lightClusters.stats();
+            std::cout << "Işıklar: " << lightStats.lights << " ışık, " << lightStats.visibleLights << " görüşte, "
+                      << lightStats.assignments << " küme ataması, kümede en çok " << lightStats.maxPerCluster
+                      << (lightStats.overflow > 0 ? ", " + std::to_string(lightStats.overflow) + " atama sığmadı" : std::string())
+                      << std::endl;
+            std::cout << "LOD: seviye başına uçak";
+            for (const std::vector<glm::mat4> &bucket : airplanesByLod)
+                std::cout << " " << bucket.size();
+            std::cout << ", " << airplaneTriangles << " üçgen (tam detay " << airplaneFullTriangles << ")" << std::endl;
+            const TerrainStats &terrainStats = terrain.stats();
+            std::cout << "Arazi: " << terrainStats.selected << " parça seçili, " << terrainStats.drawn << " çizildi, "
+                      << terrainStats.fallbacks << " yedek, " << terrainStats.resident << "/" << terrainStats.slots
+                      << " yuvada (" << terrainStats.memory / (1024 * 1024) << " MB), " << terrainStats.pending
+                      << " iş bekliyor" << std::endl;
+            profileHistory.printSummary(std::cout);
+            std::cout << "Telemetri: " << telemetry.writtenRecords() << " kayıt yazıldı, " << telemetry.droppedRecords()
+                      << " atlandı" << std::endl;
+            if (profiler.droppedFrames() > 0)
+                std::cout << "Profil: " << profiler.droppedFrames() << " kare halka dolu olduğu için atlandı" << std::endl;
+            renderStatsTime = currentFrame;
+        }
 
         // render BRDF map to screen
         //brdfShader.Use();
@@ -615,166 +938,129 @@ glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED); // Mouse imlecini g
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
+        int swapZone = profiler.begin("swap");
         glfwSwapBuffers(window);
+        profiler.end(swapZone);
         glfwPollEvents();
+        profiler.endFrame();
+        profileHistory.drain(profiler.frames());
+
+        // the trace is written from a copy of the history, off the render thread. The result is printed
+        // here once the job is done, so it doesn't cut into this thread's console output; a request made
+        // while a trace is still being written waits for it.
+        if (profileTraceRequested && !profileTraceWrite.valid())
+        {
+            profileTraceRequested = false;
+            ProfileHistory trace = profileHistory;
+            profileTraceFrames = trace.size();
+            profileTraceWrite = workers.submit([trace]() { return trace.writeChromeTrace(PROFILE_TRACE_FILE); });
+        }
+        if (profileTraceWrite.valid() && profileTraceWrite.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            if (profileTraceWrite.get())
+                std::cout << "Profil izi yazıldı: " << PROFILE_TRACE_FILE << " (" << profileTraceFrames << " kare)" << std::endl;
+            else
+                std::cout << "Failed to write profile trace " << PROFILE_TRACE_FILE << std::endl;
+        }
     }
 
+    // the recording's last chunk and index
+    flightRecorder.close();
+
+    // GL objects have to go while the context is still there
+    assets.release();
+    airplaneDraws.release();
+    for (std::unique_ptr<MultiDrawList> &draws : groundDraws)
+        draws->release();
+    geometry.release();
+    terrain.release();
+    profiler.release();
+    frameUniformBuffer.release();
+    lightClusterBuffers.release();
+    skinPalettes.release();
+
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
     glfwTerminate();
     return 0;
 }
 
+// advances the flight model by exactly one fixed tick (deltaTime == SIM_DT)
+// --------------------------------------------------------------------------
+void stepSimulation(GLFWwindow* window)
+{
+    processInput(window);
+    FlightTickInput input;
+    input.controls = readFlightInput(window);
+    input.mouseX = pendingMouse.x;
+    input.mouseY = pendingMouse.y;
+    pendingMouse = glm::vec2(0.0f);
+    updateGroundHeights(input);
+
+    FlightState before = flight;
+    stepFlightTick(flight, input, deltaTime);
+    flightRecorder.record(before, input, flight);
+}
+
+// ground height under the player, into its tick input so the recording carries it: the terrain or,
+// where a ray cast straight down hits the carrier, the deck
+// --------------------------------------------------------------------------------------------------
+void updateGroundHeights(FlightTickInput &input)
+{
+    CollisionRay ray;
+    ray.origin = flight.position + glm::vec3(0.0f, FLIGHT_GROUND_CLEARANCE, 0.0f);
+    ray.direction = glm::vec3(0.0f, -1.0f, 0.0f);
+    ray.maxDistance = GROUND_RAY_LENGTH;
+    CollisionHit hit;
+    if (carrierCollision)
+        carrierCollision->raycast(ray, hit);
+
+    float height = groundTerrain ? groundTerrain->heightAt(ray.origin.x, ray.origin.z) : 0.0f;
+    if (hit.hit())
+        height = std::max(height, hit.point.y);
+    input.groundHeight = height;
+}
+
+// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+// ---------------------------------------------------------------------------------------------------------
 void processInput(GLFWwindow* window)
 {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 
-    float movementSpeed = speed * deltaTime;
-    float rotationSpeed = 50.0f * deltaTime;
-    (cobra) ? movementSpeed *= 0.05f : movementSpeed;
-    float cameraMoveSpeed = 50.0f * deltaTime; // Kamera hareket hızı
-
-    // Hızlandırma ve yavaşlatma
-    if (glfwGetKey(window, GLFW_KEY_KP_ADD) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_EQUAL) == GLFW_PRESS) // '+' tuşu
-        speed += 10.0f * deltaTime;
-    if (glfwGetKey(window, GLFW_KEY_KP_SUBTRACT) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_MINUS) == GLFW_PRESS)
-        speed = glm::max(speed - 10.0f * deltaTime, 0.0f);
-
-    // Uçağı durdurma
-    if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS) {
-        speed = 0.0f;
-    }
-
-    float zroll = fmod(roll, 360.0f);
-    float zpitch = fmod(pitch + 180.0f, 360.0f) - 180.0f;
-    float zyaw = fmod(yaw, 360.0f);
-
-
-    float pitchcalc = (rotationSpeed * (1.0f - (fabs(zroll) / 90.0f)));
-    float yawcalc = (rotationSpeed * ((zroll) / 90.0f));
-
-    int wscalc;
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
-        wscalc = 1;//w
-        pressingS = false;
-    }
-    else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
-        wscalc = -1;//s
-        pressingS = true;
-    }
-    else {
-        wscalc = 0;//none
-        pressingS = false;
-    }
-
-    // Uçağın yönlendirilmesi
-    if (wscalc == 1) {
-        if (zroll == 0.0f) {
-            zpitch -= rotationSpeed;
-        } else if (zroll < 90.0f || zroll > 0.0f) {
-            zpitch -= pitchcalc;
-            zyaw -= yawcalc;
-
-
-        } else if (zroll > -90.0f || zroll < 0.0f) {
-            zpitch -= pitchcalc;
-            zyaw -= yawcalc;
-
-
-        } else if (zroll < 180.0f || zroll > 90.0f) {
-            zpitch -= pitchcalc;
-            zyaw -= yawcalc;
-
-
-        } else if (zroll > -180.0f || zroll < -90.0f) {
-            zpitch -= pitchcalc;
-            zyaw -= yawcalc;
-        }} else if (wscalc == -1) {
-        if (zroll == 0.0f) {
-            zpitch += rotationSpeed;
-        } else if (zroll < 90.0f || zroll > 0.0f) {
-            zpitch += pitchcalc;
-            zyaw += yawcalc;
-
-        } else if (zroll > -90.0f || zroll < 0.0f) {
-            zpitch += pitchcalc;
-            zyaw += yawcalc;
-        }
-        else if (zroll < 180.0f || zroll > 90.0f) {
-            zpitch += pitchcalc;
-            zyaw += yawcalc;
-
-
-        } else if (zroll > -180.0f || zroll < -90.0f) {
-            zpitch += pitchcalc;
-            zyaw += yawcalc;
-        }
-
-    }
-    
-    zpitch = std::clamp(zpitch, -179.0f, 179.0f);
-
-    pitch = zpitch;
-    yaw = zyaw;
-
-    roll = zroll;
-
-    if ((((pitch > 89.0f && pitch < 129.0f) && pitchRate >=40.0f) || glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS) && cobra == false) {
-        cobra = true;
-        cobraStartTime = static_cast<float>(glfwGetTime());
-    }
-    else if ((pitch < 89.0f && pitch > 10.0f && cobra == true) || (pitch > 130.0f && cobra == true)) {
-        cobra = false;
-    }
-
-    if (cobra && (glfwGetTime() - cobraStartTime >= 3.0f)) {
-        cobra = false;
-        std::cout << glfwGetTime() - cobraStartTime << std::endl;
-    }
-    
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
-        if(isPlaneTouchGround) {
-            yaw -= (rotationSpeed);
-        } else {
-            roll -= (rotationSpeed * 1.5f);
-        }
-    }
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
-        if(isPlaneTouchGround) {
-            yaw += (rotationSpeed);
-        } else {
-            roll += (rotationSpeed * 1.5f);
-        }
-    }
-
-
-    // Pozisyon güncelle
-        glm::mat4 rotationMatrix = glm::rotate(glm::mat4(1.0f), glm::radians(yaw), glm::vec3(0.0f, 1.0f, 0.0f));
-        rotationMatrix = glm::rotate(rotationMatrix, glm::radians(pitch), glm::vec3(1.0f, 0.0f, 0.0f));
-        rotationMatrix = glm::rotate(rotationMatrix, glm::radians(roll), glm::vec3(0.0f, 0.0f, 1.0f));
-        if (speed > 0.0f) {
-            airplanePosition.y -= (9.8f * deltaTime * 0.5f); // Yerçekimi etkisi
-        }
-        glm::vec3 forward = glm::vec3(rotationMatrix * glm::vec4(0.0f, 0.0f, -1.0f, 0.0f)); 
-        airplanePosition += forward * movementSpeed;
-
-
-    // Kamera offsetini uçak konumundan bağımsız değiştir
-    glm::vec3 newOffset = cameraOffset;
-
-    if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)
-        newOffset.y += cameraMoveSpeed;
-    if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS)
-        newOffset.y -= cameraMoveSpeed;
-    if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS)
-        newOffset.x -= cameraMoveSpeed;
-    if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS)
-        newOffset.x += cameraMoveSpeed;
-    
+    // H: switch the diffuse IBL between spherical harmonics and the irradiance cubemap
+    static bool hWasPressed = false;
+    bool hPressed = glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS;
+    if (hPressed && !hWasPressed)
+        useShIrradiance = !useShIrradiance;
+    hWasPressed = hPressed;
+
+    // F9: dump the profiler's history as a Chrome trace
+    static bool f9WasPressed = false;
+    bool f9Pressed = glfwGetKey(window, GLFW_KEY_F9) == GLFW_PRESS;
+    if (f9Pressed && !f9WasPressed)
+        profileTraceRequested = true;
+    f9WasPressed = f9Pressed;
+}
 
-    // Değişiklikleri uygula
-    cameraOffset = newOffset;
+// samples the keyboard into the flight model's input for this tick
+// ----------------------------------------------------------------
+FlightInput readFlightInput(GLFWwindow* window)
+{
+    FlightInput in;
+    in.throttleUp = glfwGetKey(window, GLFW_KEY_KP_ADD) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_EQUAL) == GLFW_PRESS; // '+' tuşu
+    in.throttleDown = glfwGetKey(window, GLFW_KEY_KP_SUBTRACT) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_MINUS) == GLFW_PRESS;
+    in.stop = glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS;
+    in.pitchDown = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
+    in.pitchUp = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
+    in.cobra = glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS;
+    in.rollRight = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
+    in.rollLeft = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
+    in.cameraUp = glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS;
+    in.cameraDown = glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS;
+    in.cameraLeft = glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS;
+    in.cameraRight = glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS;
+    return in;
 }
 
 
@@ -785,17 +1071,17 @@ void updateCamera()
     float cameraHeight = 3.0f;     // Kamera yüksekliği
 
     // **Kameranın uçağın arkasına otomatik geçmesi için matris hesapla**
-    glm::mat4 rotationMatrix = glm::rotate(glm::mat4(1.0f), glm::radians(yaw), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 rotationMatrix = glm::rotate(glm::mat4(1.0f), glm::radians(flight.yaw), glm::vec3(0.0f, 1.0f, 0.0f));
 
     // Kamera pozisyonunu hesapla (uçağın arkasında belirli bir mesafede olacak)
     glm::vec3 cameraOffset = glm::vec3(0.0f, cameraHeight, cameraDistance);
     glm::vec3 rotatedOffset = glm::vec3(rotationMatrix * glm::vec4(cameraOffset, 1.0f));
 
     // Kamera, her zaman uçağın arkasında duracak
-    camera.Position = airplanePosition - rotatedOffset;
+    camera.Position = flight.position - rotatedOffset;
 
     // Kamera, uçağa bakacak şekilde hizalanmalı
-    camera.Front = glm::normalize(airplanePosition - camera.Position);
+    camera.Front = glm::normalize(flight.position - camera.Position);
     camera.Up = glm::vec3(0.0f, 1.0f, 0.0f);
 }
 
@@ -806,6 +1092,12 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
     // make sure the viewport matches the new window dimensions; note that width and 
     // height will be significantly larger than specified on retina displays.
     glViewport(0, 0, width, height);
+    // a minimized window reports 0 x 0; keep the last real size so the per-pixel scales stay finite
+    if (width > 0 && height > 0)
+    {
+        scrWidth = width;
+        scrHeight = height;
+    }
 }
 
 // glfw: whenever the mouse moves, this callback is called
@@ -827,87 +1119,12 @@ void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
     float xoffset = (xposIn - lastX) * sensitivity;
     float yoffset = (yposIn - lastY) * sensitivity; // Y ekseni ters çevrildiği için çıkartıyoruz.
 
-    float zroll = fmod(roll, 360.0f);
-    float zpitch = fmod(pitch + 180.0f, 360.0f) - 180.0f;
-    float zyaw = fmod(yaw, 360.0f);
-
-    float rotationSpeed = fabs(yoffset);
-
-    float pitchcalc = (rotationSpeed * (1.0f - (fabs(zroll) / 90.0f)));
-    float yawcalc = (rotationSpeed * ((zroll) / 90.0f));
-
-    int wscalc;
-    if (yoffset > 0.0f) {
-        wscalc = 1;//w
-    }
-    else if (yoffset < 0.0f) {
-        wscalc = -1;//s
-    }
-    else {
-        wscalc = 0;//none
-    }
-
-    // Uçağın yönlendirilmesi
-    if (wscalc == 1) {
-        if (zroll == 0.0f) {
-            zpitch -= rotationSpeed;
-        } else if (zroll < 90.0f || zroll > 0.0f) {
-            zpitch -= pitchcalc;
-            zyaw -= yawcalc;
-
-
-        } else if (zroll > -90.0f || zroll < 0.0f) {
-            zpitch -= pitchcalc;
-            zyaw -= yawcalc;
-
-
-        } else if (zroll < 180.0f || zroll > 90.0f) {
-            zpitch -= pitchcalc;
-            zyaw -= yawcalc;
-
-
-        } else if (zroll > -180.0f || zroll < -90.0f) {
-            zpitch -= pitchcalc;
-            zyaw -= yawcalc;
-        }} else if (wscalc == -1) {
-        if (zroll == 0.0f) {
-            zpitch += rotationSpeed;
-        } else if (zroll < 90.0f || zroll > 0.0f) {
-            zpitch += pitchcalc;
-            zyaw += yawcalc;
-
-        } else if (zroll > -90.0f || zroll < 0.0f) {
-            zpitch += pitchcalc;
-            zyaw += yawcalc;
-        }
-        else if (zroll < 180.0f || zroll > 90.0f) {
-            zpitch += pitchcalc;
-            zyaw += yawcalc;
-
-
-        } else if (zroll > -180.0f || zroll < -90.0f) {
-            zpitch += pitchcalc;
-            zyaw += yawcalc;
-        }
-
-    }
-
-    
-
-    pitch = zpitch;
-    yaw = zyaw;
-    //roll = zroll;
-
     lastX = xposIn;
     lastY = yposIn;
 
-    // Mouse ile uçağın yönünü değiştir
-    roll += xoffset;   // Mouse sağa/sola hareket edince uçak yön değiştirir.
-    //pitch += yoffset; // Mouse yukarı/aşağı hareket edince uçak burnu yukarı/aşağı gider.
-
-    // Pitch açılarını sınırlayarak uçağın ters dönmesini engelleyelim.
-
-
+    // applied by the next simulation tick, see stepSimulation()
+    pendingMouse.x += xoffset;
+    pendingMouse.y += yoffset;
 }
 
 
@@ -1016,18 +1233,21 @@ void renderSphere()
     glDrawElements(GL_TRIANGLE_STRIP, indexCount, GL_UNSIGNED_INT, 0);
 }
 
+// renderQuad() renders a 1x1 XY quad in NDC; the VAO is built on the first call, so anything larger
+// scales it with its model matrix
+// -----------------------------------------------------------------------------------------------------
 unsigned int quadVAO = 0;
 unsigned int quadVBO;
-void renderQuad(float width)
+void renderQuad()
 {
     if (quadVAO == 0)
     {
         float quadVertices[] = {
             // positions        // texture Coords
-            -width,  width, 0.0f, 0.0f, width,
-            -width, -width, 0.0f, 0.0f, 0.0f,
-             width,  width, 0.0f, width, width,
-             width, -width, 0.0f, width, 0.0f,
+            -1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
+            -1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
+             1.0f,  1.0f, 0.0f, 1.0f, 1.0f,
+             1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
         };
         // setup plane VAO
         glGenVertexArrays(1, &quadVAO);
@@ -1120,6 +1340,30 @@ void renderCube()
     glBindVertexArray(0);
 }
 
+// progress bar drawn with scissored clears only, so it needs no shader or geometry
+// --------------------------------------------------------------------------------
+void renderLoadingFrame(GLFWwindow* window, float progress)
+{
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+    int barWidth = width / 2;
+    int barHeight = height / 40;
+    int barX = (width - barWidth) / 2;
+    int barY = (height - barHeight) / 2;
+
+    glClearColor(0.05f, 0.05f, 0.08f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(barX, barY, barWidth, barHeight);
+    glClearColor(0.2f, 0.2f, 0.25f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glScissor(barX, barY, static_cast<int>(barWidth * progress), barHeight);
+    glClearColor(0.2f, 0.6f, 0.9f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+}
+
 // utility function for loading a 2D texture from file
 // ---------------------------------------------------
 unsigned int loadTexturef(char const * path)
@@ -0,0 +1,49 @@
+#version 330 core
+out vec4 FragColor;
+in vec3 WorldPos;
+in vec3 Normal;
+
+// per-frame camera, shared by all programs (frame_uniforms.h)
+layout (std140) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;      // airplanes and sky
+    mat4 worldProjection; // carrier and terrain
+    vec4 camPos;
+};
+uniform vec3 lightDirection; // towards the sun
+uniform float seaLevel;
+uniform float fogDistance;
+
+const vec3 fogColor = vec3(0.62, 0.70, 0.78);
+
+void main()
+{
+    vec3 N = normalize(Normal);
+    vec3 V = normalize(camPos.xyz - WorldPos);
+    vec3 L = normalize(lightDirection);
+    float height = WorldPos.y - seaLevel;
+
+    // deniz, kum, çimen, kaya, kar
+    vec3 albedo;
+    float shininess = 0.0;
+    if (height < 0.05)
+    {
+        albedo = vec3(0.03, 0.13, 0.22);
+        shininess = 128.0;
+    }
+    else
+    {
+        float slope = 1.0 - N.y;
+        albedo = mix(vec3(0.76, 0.70, 0.50), vec3(0.22, 0.38, 0.15), smoothstep(2.0, 8.0, height));
+        albedo = mix(albedo, vec3(0.42, 0.38, 0.34), smoothstep(0.25, 0.45, slope));
+        albedo = mix(albedo, vec3(0.92, 0.93, 0.95), smoothstep(110.0, 140.0, height) * (1.0 - smoothstep(0.4, 0.6, slope)));
+    }
+
+    vec3 color = albedo * (0.25 + 0.75 * max(dot(N, L), 0.0));
+    if (shininess > 0.0)
+        color += vec3(0.8) * pow(max(dot(N, normalize(L + V)), 0.0), shininess);
+
+    float fog = smoothstep(0.3 * fogDistance, fogDistance, length(camPos.xyz - WorldPos));
+    FragColor = vec4(mix(color, fogColor, fog), 1.0);
+}
@@ -0,0 +1,23 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+
+// per-frame camera, shared by all programs (frame_uniforms.h)
+layout (std140) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;      // airplanes and sky
+    mat4 worldProjection; // carrier and terrain
+    vec4 camPos;
+};
+
+out vec3 WorldPos;
+out vec3 Normal;
+
+void main()
+{
+    // chunk vertices are already in world space
+    WorldPos = aPos;
+    Normal = aNormal;
+    gl_Position = worldProjection * view * vec4(aPos, 1.0);
+}
@@ -1,25 +1,71 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
+#extension GL_ARB_shader_draw_parameters : enable
+layout (location = 0) in vec4 aPos;    // 0..1 within the mesh bounds; w is the tangent handedness
+layout (location = 1) in vec2 aNormal; // octahedral
 layout (location = 2) in vec2 aTexCoords;
+layout (location = 14) in int aTextureLayer; // PackedModel: doku dizisindeki katman, -1 dokusuz
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
+flat out int TextureLayer;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// per-frame camera, shared by all programs (frame_uniforms.h)
+layout (std140) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;      // airplanes and sky
+    mat4 worldProjection; // carrier and terrain
+    vec4 camPos;
+};
+
+// multi-draw: per-draw transforms from texture buffers (MultiDrawList), 7 texels per instance
+uniform bool multiDraw;
+uniform int drawIdBase;
+uniform samplerBuffer drawTransforms;
+uniform isamplerBuffer drawRecords;
+// mesh bounds for draws outside MultiDrawList; there they are already part of the per-draw model matrix
+uniform mat4 positionDequantize;
+
+int drawId()
+{
+#ifdef GL_ARB_shader_draw_parameters
+    return drawIdBase + gl_DrawIDARB;
+#else
+    return drawIdBase;
+#endif
+}
+
+// packed vertices (vertex_format.h): octahedral normal in [-1, 1]^2 back to a unit vector
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
 
 void main()
 {
     // Dünya koordinatındaki pozisyon ve normal
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    vec3 normal = octDecode(aNormal);
+    if (multiDraw) {
+        int transform = (texelFetch(drawRecords, drawId()).r + gl_InstanceID) * 7;
+        mat4 drawModel = mat4(texelFetch(drawTransforms, transform), texelFetch(drawTransforms, transform + 1),
+                              texelFetch(drawTransforms, transform + 2), texelFetch(drawTransforms, transform + 3));
+        FragPos = vec3(drawModel * vec4(aPos.xyz, 1.0));
+        Normal = mat3(texelFetch(drawTransforms, transform + 4).xyz, texelFetch(drawTransforms, transform + 5).xyz,
+                      texelFetch(drawTransforms, transform + 6).xyz) * normal;
+    } else {
+        FragPos = vec3(model * positionDequantize * vec4(aPos.xyz, 1.0));
+        Normal = mat3(transpose(inverse(model))) * normal;
+    }
 
     // Doku koordinatlarını geçir
     TexCoords = aTexCoords;
+    TextureLayer = aTextureLayer;
 
     // Nihai pozisyonu hesapla
-    gl_Position = projection * view * vec4(FragPos, 1.0);
+    gl_Position = worldProjection * view * vec4(FragPos, 1.0);
 }
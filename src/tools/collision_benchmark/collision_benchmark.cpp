@@ -0,0 +1,211 @@
+#include <learnopengl/filesystem.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <pcontum/collision_mesh.h>
+#include <pcontum/mesh_cache.h>
+#include <pcontum/thread_pool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+// Headless collision benchmark: builds the collision tree of a model (the carrier by default), places it
+// like the game does and times batches of downward ray casts (landing gear, tailhook), random ray casts
+// and closest-point queries, on one thread and on the pool. A sample of every batch is checked against
+// testing each triangle.
+
+const size_t CHECKED_QUERIES = 256;
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct WorldTriangle
+{
+    glm::vec3 a, b, c;
+};
+
+std::vector<WorldTriangle> worldTriangles(const ModelData &model, const glm::mat4 &world)
+{
+    std::vector<WorldTriangle> triangles;
+    for (const MeshData &mesh : model.meshes)
+    {
+        for (size_t i = 0; i + 2 < mesh.indexCount; i += 3)
+        {
+            glm::vec3 corners[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                glm::vec3 position = unpackPosition(mesh.vertexData[mesh.indexData[i + k]], mesh.quantization);
+                corners[k] = glm::vec3(world * glm::vec4(position, 1.0f));
+            }
+            triangles.push_back({ corners[0], corners[1], corners[2] });
+        }
+    }
+    return triangles;
+}
+
+float bruteRaycast(const std::vector<WorldTriangle> &triangles, const CollisionRay &ray)
+{
+    float best = ray.maxDistance;
+    bool found = false;
+    for (const WorldTriangle &t : triangles)
+    {
+        glm::vec3 edge1 = t.b - t.a, edge2 = t.c - t.a;
+        glm::vec3 p = glm::cross(ray.direction, edge2);
+        float determinant = glm::dot(edge1, p);
+        if (std::fabs(determinant) < 1e-12f)
+            continue;
+        glm::vec3 s = ray.origin - t.a;
+        float u = glm::dot(s, p) / determinant;
+        glm::vec3 q = glm::cross(s, edge1);
+        float v = glm::dot(ray.direction, q) / determinant;
+        float distance = glm::dot(edge2, q) / determinant;
+        if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && distance >= 0.0f && distance < best)
+        {
+            best = distance;
+            found = true;
+        }
+    }
+    return found ? best : -1.0f;
+}
+
+float bruteClosest(const std::vector<WorldTriangle> &triangles, const glm::vec3 &point)
+{
+    float best = std::numeric_limits<float>::max();
+    for (const WorldTriangle &t : triangles)
+        best = std::min(best, glm::length(closestPointOnTriangle(point, t.a, t.b, t.c) - point));
+    return best;
+}
+
+// distances differ by the float rounding of the two spaces, relative to the size of the scene
+bool sameDistance(float a, float b, float extent)
+{
+    return std::fabs(a - b) <= 1e-4f * extent + 1e-4f;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string source = argc > 1 ? argv[1]
+                                  : FileSystem::getPath("resources/objects/ettayyariyyetul_gemiyye/ettayyariyyetul_gemiyye.dae");
+    size_t queries = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100000;
+
+    ModelData model = loadModelData(source);
+    if (!model.loaded)
+    {
+        std::printf("can't load %s\n", source.c_str());
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    CollisionMesh collision = buildCollisionMesh(model);
+    double buildSeconds = secondsSince(start);
+    if (collision.empty())
+    {
+        std::printf("%s has no triangles\n", source.c_str());
+        return 1;
+    }
+
+    // same placement as the carrier in the game
+    glm::mat4 world = glm::scale(glm::mat4(1.0f), glm::vec3(0.3f));
+    world = glm::rotate(world, glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    world = glm::rotate(world, glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    collision.setTransform(world);
+    Aabb bounds = transformAabb(collision.modelBounds(), world);
+    glm::vec3 size = bounds.max - bounds.min;
+    float extent = std::max(size.x, std::max(size.y, size.z));
+
+    std::printf("%s: %zu triangles, %zu nodes, built in %.1f ms\n", source.c_str(), collision.triangleCount(),
+                collision.nodeCount(), buildSeconds * 1000.0);
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    auto inside = [&] {
+        return bounds.min + size * glm::vec3(unit(random), unit(random), unit(random));
+    };
+
+    // straight down from above the deck, like the gear and tailhook probes
+    std::vector<CollisionRay> downRays(queries);
+    for (CollisionRay &ray : downRays)
+    {
+        ray.origin = inside();
+        ray.origin.y = bounds.max.y + 1.0f;
+        ray.maxDistance = size.y + 2.0f;
+    }
+    // any direction from anywhere around the model, like terrain avoidance probes
+    std::vector<CollisionRay> randomRays(queries);
+    for (CollisionRay &ray : randomRays)
+    {
+        ray.origin = inside();
+        glm::vec3 direction(unit(random) - 0.5f, unit(random) - 0.5f, unit(random) - 0.5f);
+        ray.direction = glm::length(direction) > 1e-3f ? glm::normalize(direction) : glm::vec3(0.0f, -1.0f, 0.0f);
+        ray.maxDistance = extent;
+    }
+    std::vector<glm::vec3> points(queries);
+    for (glm::vec3 &point : points)
+        point = inside();
+
+    ThreadPool pool;
+    std::vector<WorldTriangle> triangles = worldTriangles(model, world);
+    size_t checked = std::min(CHECKED_QUERIES, queries);
+    int result = 0;
+
+    struct RayBatch
+    {
+        const char *name;
+        const std::vector<CollisionRay> *rays;
+    };
+    for (const RayBatch &batch : { RayBatch{ "down rays", &downRays }, RayBatch{ "random rays", &randomRays } })
+    {
+        std::vector<CollisionHit> hits(queries);
+        start = std::chrono::steady_clock::now();
+        collision.raycast(batch.rays->data(), queries, hits.data());
+        double single = secondsSince(start);
+        start = std::chrono::steady_clock::now();
+        collision.raycast(batch.rays->data(), queries, hits.data(), &pool);
+        double parallel = secondsSince(start);
+
+        size_t hitCount = 0, mismatches = 0;
+        for (size_t i = 0; i < queries; ++i)
+            hitCount += hits[i].hit() ? 1 : 0;
+        for (size_t i = 0; i < checked; ++i)
+        {
+            float expected = bruteRaycast(triangles, (*batch.rays)[i]);
+            if ((expected >= 0.0f) != hits[i].hit() || (hits[i].hit() && !sameDistance(expected, hits[i].distance, extent)))
+                mismatches++;
+        }
+        std::printf("  %zu %s: %zu hits, %.2f M/s on 1 thread, %.2f M/s on %zu threads; %zu of %zu checked differ\n", queries,
+                    batch.name, hitCount, queries / single / 1e6, queries / parallel / 1e6, pool.size() + 1, mismatches,
+                    checked);
+        if (mismatches)
+            result = 1;
+    }
+
+    std::vector<CollisionPoint> nearest(queries);
+    float maxDistance = std::numeric_limits<float>::max();
+    start = std::chrono::steady_clock::now();
+    collision.closestPoint(points.data(), queries, maxDistance, nearest.data());
+    double single = secondsSince(start);
+    start = std::chrono::steady_clock::now();
+    collision.closestPoint(points.data(), queries, maxDistance, nearest.data(), &pool);
+    double parallel = secondsSince(start);
+    size_t mismatches = 0;
+    for (size_t i = 0; i < checked; ++i)
+    {
+        if (!nearest[i].found() || !sameDistance(bruteClosest(triangles, points[i]), nearest[i].distance, extent))
+            mismatches++;
+    }
+    std::printf("  %zu closest points: %.2f M/s on 1 thread, %.2f M/s on %zu threads; %zu of %zu checked differ\n", queries,
+                queries / single / 1e6, queries / parallel / 1e6, pool.size() + 1, mismatches, checked);
+    if (mismatches)
+        result = 1;
+    return result;
+}
@@ -0,0 +1,79 @@
+#include <pcontum/flight_recorder.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// Headless flight replay: feeds a recording's inputs back through stepFlightTick(), as fast as it goes,
+// and checks every tick against the recorded checksum. Then seeks through the file from its keyframes
+// and checks those states too. Usage: tools__flight_replay [flight.flightrec] [tick]; with a tick, the
+// state before that tick is printed.
+
+const char *DEFAULT_RECORDING = "flight.flightrec";
+const int SEEK_SAMPLES = 64;
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void printState(const char *label, const FlightState &s)
+{
+    std::printf("  %s: t %.3f s, pos (%.3f, %.3f, %.3f) pitch %.3f yaw %.3f roll %.3f speed %.3f%s%s\n", label, s.time,
+                s.position.x, s.position.y, s.position.z, s.pitch, s.yaw, s.roll, s.speed, s.cobra ? " cobra" : "",
+                s.touchingGround ? " ground" : "");
+}
+
+int main(int argc, char *argv[])
+{
+    std::string path = argc > 1 ? argv[1] : DEFAULT_RECORDING;
+    FlightRecording recording;
+    if (!recording.open(path))
+    {
+        std::printf("can't read %s\n", path.c_str());
+        return 1;
+    }
+    uint64_t ticks = recording.tickCount();
+    float dt = static_cast<float>(recording.tickSeconds());
+    std::printf("%s: %llu ticks (%.1f s), %zu chunks of %u ticks, %s\n", path.c_str(), static_cast<unsigned long long>(ticks),
+                ticks * recording.tickSeconds(), recording.chunkCount(), recording.chunkTicks(),
+                recording.indexed() ? "indexed" : "no index, chunks walked");
+
+    // 1. the whole flight from the first keyframe
+    auto start = std::chrono::steady_clock::now();
+    FlightState state = recording.seek(0);
+    uint64_t firstMismatch = ticks;
+    for (uint64_t tick = 0; tick < ticks; ++tick)
+    {
+        stepFlightTick(state, recording.input(tick), dt);
+        if (firstMismatch == ticks && flightChecksum(state) != recording.tick(tick).checksum)
+            firstMismatch = tick;
+    }
+    double seconds = secondsSince(start);
+    std::printf("replay: %.3f ms, %.0f ticks/s (%.0fx real time), %s", seconds * 1000.0, ticks / seconds,
+                ticks * recording.tickSeconds() / seconds, firstMismatch == ticks ? "bit-exact\n" : "");
+    if (firstMismatch != ticks)
+        std::printf("diverges at tick %llu\n", static_cast<unsigned long long>(firstMismatch));
+    printState("final", state);
+
+    // 2. seeks spread over the file, each checked against the tick before it
+    size_t seekMismatches = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 1; i <= SEEK_SAMPLES; ++i)
+    {
+        uint64_t tick = ticks * i / SEEK_SAMPLES;
+        FlightState seeked = recording.seek(tick);
+        if (tick > 0 && flightChecksum(seeked) != recording.tick(tick - 1).checksum)
+            seekMismatches++;
+    }
+    seconds = secondsSince(start);
+    std::printf("seek: %d seeks, %.3f ms each, %zu mismatches\n", SEEK_SAMPLES, seconds * 1000.0 / SEEK_SAMPLES, seekMismatches);
+
+    if (argc > 2)
+    {
+        uint64_t tick = std::strtoull(argv[2], nullptr, 10);
+        printState(("tick " + std::to_string(std::min(tick, ticks))).c_str(), recording.seek(tick));
+    }
+    return firstMismatch == ticks && seekMismatches == 0 ? 0 : 1;
+}
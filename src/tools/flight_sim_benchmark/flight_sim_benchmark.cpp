@@ -0,0 +1,231 @@
+#include <pcontum/flight_model.h>
+#include <pcontum/aircraft_soa.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Headless flight model benchmark: no window, no GL context.
+// Drives the same stepFlight() the game uses from a scripted input track and reports
+// throughput plus a checksum of the final state, so regressions in speed or behaviour show up as numbers.
+
+const double SIM_DT = 1.0 / 240.0;           // same tick as the game loop
+const uint64_t DEFAULT_TICKS = 5000000;
+const uint64_t DEFAULT_SOA_TICKS = 2400;      // 10 simulated seconds for the whole fleet
+const uint64_t SOA_VERIFY_TICKS = 2400;
+const uint64_t TRACK_LENGTH = 20 * 240;       // the input track repeats every 20 simulated seconds
+
+// cheap integer hash, so the mouse jitter is reproducible without any RNG state
+uint32_t hashTick(uint64_t tick)
+{
+    uint32_t h = static_cast<uint32_t>(tick) * 2654435761u;
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    return h;
+}
+
+// scripted pilot: take off, climb, bank both ways, pull a cobra, throttle back and jiggle the mouse
+FlightInput scriptedInput(uint64_t tick, float &mouseX, float &mouseY)
+{
+    FlightInput in;
+    mouseX = 0.0f;
+    mouseY = 0.0f;
+
+    uint64_t t = tick % TRACK_LENGTH;
+    const uint64_t second = 240;
+    if (t < 2 * second)
+        in.throttleUp = true;
+    else if (t < 4 * second)
+        in.pitchUp = true;
+    else if (t < 5 * second)
+        in.rollLeft = true;
+    else if (t < 7 * second)
+        in.pitchDown = true;
+    else if (t < 8 * second)
+        in.rollRight = true;
+    else if (t < 8 * second + 10)
+        in.cobra = true;
+    else if (t < 11 * second)
+        in.throttleDown = true;
+    else if (t < 12 * second)
+    {
+        in.pitchUp = true;
+        in.rollRight = true;
+        in.cameraLeft = true;
+    }
+    else if (t < 15 * second)
+    {
+        uint32_t h = hashTick(tick);
+        mouseX = (static_cast<float>(h & 0xffff) / 65535.0f - 0.5f) * 2.0f;
+        mouseY = (static_cast<float>(h >> 16) / 65535.0f - 0.5f) * 2.0f;
+    }
+    else if (t < 16 * second)
+    {
+        in.throttleUp = true;
+        in.cameraRight = true;
+    }
+    return in;
+}
+
+// input for aircraft i of a fleet: the same track, phase-shifted per aircraft, without mouse or camera
+FlightInput fleetInput(uint64_t tick, size_t aircraft)
+{
+    float mouseX, mouseY;
+    FlightInput in = scriptedInput(tick + aircraft * 97, mouseX, mouseY);
+    in.cameraUp = in.cameraDown = in.cameraLeft = in.cameraRight = false;
+    return in;
+}
+
+FlightState fleetStart(size_t aircraft)
+{
+    FlightState s;
+    s.position.x += static_cast<float>(aircraft % 64) * 5.0f;
+    s.position.z += static_cast<float>(aircraft / 64) * 5.0f;
+    return s;
+}
+
+double elapsedSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// AircraftStateSoA: verifies the scalar path bit-for-bit, measures the SIMD error and times both paths
+int runFleet(size_t aircraft, uint64_t ticks)
+{
+    const float dt = static_cast<float>(SIM_DT);
+
+    // 1. scalar SoA path against independent single-aircraft FlightStates
+    std::vector<FlightState> singles;
+    AircraftStateSoA reference;
+    for (size_t i = 0; i < aircraft; ++i)
+    {
+        singles.push_back(fleetStart(i));
+        reference.add(fleetStart(i));
+    }
+    uint64_t verifyTicks = std::min(ticks, SOA_VERIFY_TICKS);
+    for (uint64_t tick = 0; tick < verifyTicks; ++tick)
+    {
+        for (size_t i = 0; i < aircraft; ++i)
+        {
+            FlightInput in = fleetInput(tick, i);
+            stepFlight(singles[i], in, dt);
+            reference.inputs[i] = in;
+        }
+        reference.stepScalar(dt);
+    }
+    size_t mismatches = 0;
+    for (size_t i = 0; i < aircraft; ++i)
+    {
+        FlightState s = reference.get(i);
+        s.cameraOffset = singles[i].cameraOffset;
+        if (flightChecksum(s) != flightChecksum(singles[i]))
+            ++mismatches;
+    }
+    std::printf("fleet: %zu aircraft, scalar SoA vs single path over %llu ticks: %s (%zu mismatches)\n",
+                aircraft, static_cast<unsigned long long>(verifyTicks), mismatches == 0 ? "bit-exact" : "MISMATCH", mismatches);
+
+    // 2. SIMD step error, re-synchronised to the reference every tick so divergence cannot compound
+    AircraftStateSoA batch = reference;
+    float maxPositionError = 0.0f, maxAngleError = 0.0f;
+    size_t flagMismatches = 0;
+    for (uint64_t tick = 0; tick < verifyTicks; ++tick)
+    {
+        for (size_t i = 0; i < aircraft; ++i)
+            reference.inputs[i] = fleetInput(tick, i);
+        batch = reference;
+        reference.stepScalar(dt);
+        batch.step(dt);
+        for (size_t i = 0; i < aircraft; ++i)
+        {
+            maxPositionError = std::max({ maxPositionError, std::fabs(batch.posX[i] - reference.posX[i]),
+                                          std::fabs(batch.posY[i] - reference.posY[i]), std::fabs(batch.posZ[i] - reference.posZ[i]) });
+            maxAngleError = std::max({ maxAngleError, std::fabs(batch.pitch[i] - reference.pitch[i]), std::fabs(batch.roll[i] - reference.roll[i]) });
+            if (batch.touchingGround[i] != reference.touchingGround[i])
+                ++flagMismatches;
+        }
+    }
+    std::printf("fleet: %s step vs scalar, per tick: max position error %.3g, max angle error %.3g, ground flag mismatches %zu\n",
+                AircraftStateSoA::simdName(), maxPositionError, maxAngleError, flagMismatches);
+
+    // 3. throughput of both paths from the same starting fleet
+    AircraftStateSoA scalarFleet, simdFleet;
+    for (size_t i = 0; i < aircraft; ++i)
+    {
+        scalarFleet.add(fleetStart(i));
+        simdFleet.add(fleetStart(i));
+    }
+    double scalarSeconds = 0.0, simdSeconds = 0.0;
+    for (uint64_t tick = 0; tick < ticks; ++tick)
+    {
+        for (size_t i = 0; i < aircraft; ++i)
+            scalarFleet.inputs[i] = simdFleet.inputs[i] = fleetInput(tick, i);
+
+        auto start = std::chrono::steady_clock::now();
+        scalarFleet.stepScalar(dt);
+        scalarSeconds += elapsedSince(start);
+
+        start = std::chrono::steady_clock::now();
+        simdFleet.step(dt);
+        simdSeconds += elapsedSince(start);
+    }
+    double aircraftTicks = static_cast<double>(aircraft) * ticks;
+    std::printf("fleet: %llu ticks x %zu aircraft\n", static_cast<unsigned long long>(ticks), aircraft);
+    std::printf("  scalar   : %.2f ns/aircraft-tick, %.0f aircraft-ticks/s\n", scalarSeconds * 1e9 / aircraftTicks, aircraftTicks / scalarSeconds);
+    std::printf("  %-8s : %.2f ns/aircraft-tick, %.0f aircraft-ticks/s (%.2fx)\n", AircraftStateSoA::simdName(),
+                simdSeconds * 1e9 / aircraftTicks, aircraftTicks / simdSeconds, scalarSeconds / simdSeconds);
+    return mismatches == 0 ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 2 && std::strcmp(argv[1], "--fleet") == 0)
+    {
+        size_t aircraft = std::strtoull(argv[2], nullptr, 10);
+        uint64_t ticks = (argc > 3) ? std::strtoull(argv[3], nullptr, 10) : DEFAULT_SOA_TICKS;
+        if (aircraft == 0 || ticks == 0)
+        {
+            std::printf("usage: %s --fleet <aircraft> [ticks]\n", argv[0]);
+            return 1;
+        }
+        return runFleet(aircraft, ticks);
+    }
+
+    uint64_t ticks = DEFAULT_TICKS;
+    if (argc > 1)
+        ticks = std::strtoull(argv[1], nullptr, 10);
+    if (ticks == 0)
+    {
+        std::printf("usage: %s [ticks]\n       %s --fleet <aircraft> [ticks]\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    FlightState state;
+    const float dt = static_cast<float>(SIM_DT);
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t tick = 0; tick < ticks; ++tick)
+    {
+        float mouseX, mouseY;
+        FlightInput in = scriptedInput(tick, mouseX, mouseY);
+        if (mouseX != 0.0f || mouseY != 0.0f)
+            applyMouseInput(state, mouseX, mouseY);
+        stepFlight(state, in, dt);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::printf("flight_sim_benchmark: %llu ticks (%.1f s simulated) in %.3f s\n",
+                static_cast<unsigned long long>(ticks), state.time, seconds);
+    std::printf("  ticks/s  : %.0f\n", ticks / seconds);
+    std::printf("  ns/tick  : %.2f\n", seconds * 1e9 / ticks);
+    std::printf("  final    : pos (%.3f, %.3f, %.3f) pitch %.3f yaw %.3f roll %.3f speed %.3f\n",
+                state.position.x, state.position.y, state.position.z, state.pitch, state.yaw, state.roll, state.speed);
+    std::printf("  checksum : %016llx\n", static_cast<unsigned long long>(flightChecksum(state)));
+    return 0;
+}
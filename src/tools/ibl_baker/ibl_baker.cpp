@@ -0,0 +1,194 @@
+#include <stb_image.h>
+
+#include <learnopengl/filesystem.h>
+
+#include <pcontum/ibl_bake_cpu.h>
+#include <pcontum/ibl_cache.h>
+#include <pcontum/thread_pool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Headless IBL baker: runs the four bake passes of ibl_specular_textured on the CPU and writes the same
+// .iblcache the game writes after a GPU bake, so environments can be baked on machines without a GPU.
+// --compare reads two caches (typically GPU vs CPU) and reports the largest differences per texture and mip.
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int bake(const std::string &hdrPath, const std::string &outPath, size_t threads)
+{
+    IblBakeSettings settings;
+    uint64_t key = iblCacheKey(hdrPath, settings);
+    if (key == 0)
+    {
+        std::printf("can't read %s\n", hdrPath.c_str());
+        return 1;
+    }
+
+    ThreadPool pool(threads);
+    std::printf("ibl_baker: %s, %zu threads, %s\n", hdrPath.c_str(), pool.size(),
+#ifdef PCONTUM_IBL_SSE2
+                "SSE2 BRDF"
+#else
+                "scalar BRDF"
+#endif
+    );
+
+    auto start = std::chrono::steady_clock::now();
+    stbi_set_flip_vertically_on_load(true); // same orientation as the GPU upload
+    int width, height, components;
+    float *hdr = stbi_loadf(hdrPath.c_str(), &width, &height, &components, 0);
+    if (!hdr)
+    {
+        std::printf("Failed to load HDR image.\n");
+        return 1;
+    }
+    std::printf("  decode      : %8.3f s\n", secondsSince(start));
+
+    start = std::chrono::steady_clock::now();
+    CpuCubemap environment = equirectangularToCubemap(hdr, width, height, components, settings.environmentSize, pool);
+    stbi_image_free(hdr);
+    std::printf("  environment : %8.3f s\n", secondsSince(start));
+
+    start = std::chrono::steady_clock::now();
+    CpuCubemap irradiance = convolveIrradiance(environment, settings.irradianceSize, pool);
+    std::printf("  irradiance  : %8.3f s\n", secondsSince(start));
+
+    start = std::chrono::steady_clock::now();
+    CpuCubemap prefilter = prefilterEnvironment(environment, settings.prefilterSize, settings.prefilterMipLevels, pool);
+    std::printf("  prefilter   : %8.3f s\n", secondsSince(start));
+
+    start = std::chrono::steady_clock::now();
+    std::vector<float> brdf = integrateBrdfLut(settings.brdfSize, pool);
+    std::printf("  brdf lut    : %8.3f s\n", secondsSince(start));
+
+    IblCache cache;
+    cache.key = key;
+    cache.environment = cubemapToIblImage(environment, environment.levelCount());
+    cache.irradiance = cubemapToIblImage(irradiance, 1);
+    cache.prefilter = cubemapToIblImage(prefilter, settings.prefilterMipLevels);
+    cache.brdfLUT = brdfLutToIblImage(brdf, settings.brdfSize);
+    if (!writeIblCache(outPath, cache))
+    {
+        std::printf("Failed to write IBL cache %s\n", outPath.c_str());
+        return 1;
+    }
+    std::printf("  wrote %s\n", outPath.c_str());
+    return 0;
+}
+
+// largest absolute and relative difference of one texture, mip by mip; returns the worst relative error
+float compareImage(const char *name, const IblImage &reference, const IblImage &other)
+{
+    if (reference.cubemap != other.cubemap || reference.channels != other.channels ||
+        reference.width != other.width || reference.height != other.height)
+    {
+        std::printf("  %-12s layout differs (%ux%u x%u vs %ux%u x%u)\n", name, reference.width, reference.height,
+                    reference.channels, other.width, other.height, other.channels);
+        return INFINITY;
+    }
+
+    float worst = 0.0f;
+    size_t levels = std::min(reference.levels.size(), other.levels.size());
+    for (uint32_t mip = 0; mip < levels; ++mip)
+    {
+        float maxAbs = 0.0f, maxRel = 0.0f, peak = 0.0f;
+        double sumSquared = 0.0;
+        const std::vector<uint16_t> &a = reference.levels[mip];
+        const std::vector<uint16_t> &b = other.levels[mip];
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            float x = halfToFloat(a[i]);
+            float y = halfToFloat(b[i]);
+            float diff = std::fabs(x - y);
+            maxAbs = std::max(maxAbs, diff);
+            // relative to the value, with a floor so near-black texels don't dominate
+            maxRel = std::max(maxRel, diff / std::max(std::fabs(x), 0.05f));
+            peak = std::max(peak, std::fabs(x));
+            sumSquared += double(diff) * diff;
+        }
+        std::printf("  %-12s mip %u %4ux%-4u  max abs %10.5f  max rel %8.4f  rms %10.6f  (peak %.3f)\n", name, mip,
+                    reference.levelWidth(mip), reference.levelHeight(mip), maxAbs, maxRel,
+                    std::sqrt(sumSquared / std::max<size_t>(a.size(), 1)), peak);
+        worst = std::max(worst, maxRel);
+    }
+    if (reference.levels.size() != other.levels.size())
+        std::printf("  %-12s mip count differs (%zu vs %zu), compared the first %zu\n", name, reference.levels.size(),
+                    other.levels.size(), levels);
+    return worst;
+}
+
+int compare(const std::string &referencePath, const std::string &otherPath, float tolerance)
+{
+    IblCache reference, other;
+    if (!readIblCache(referencePath, 0, reference))
+    {
+        std::printf("can't read IBL cache %s\n", referencePath.c_str());
+        return 1;
+    }
+    if (!readIblCache(otherPath, 0, other))
+    {
+        std::printf("can't read IBL cache %s\n", otherPath.c_str());
+        return 1;
+    }
+    if (reference.key != other.key)
+        std::printf("  warning: cache keys differ, the files come from different HDRs or bake settings\n");
+
+    float worst = 0.0f;
+    worst = std::max(worst, compareImage("environment", reference.environment, other.environment));
+    worst = std::max(worst, compareImage("irradiance", reference.irradiance, other.irradiance));
+    worst = std::max(worst, compareImage("prefilter", reference.prefilter, other.prefilter));
+    worst = std::max(worst, compareImage("brdf lut", reference.brdfLUT, other.brdfLUT));
+    std::printf("  worst relative error: %.4f\n", worst);
+
+    if (tolerance > 0.0f && !(worst <= tolerance))
+    {
+        std::printf("  FAILED: above tolerance %.4f\n", tolerance);
+        return 2;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 3 && std::strcmp(argv[1], "--compare") == 0)
+    {
+        float tolerance = (argc > 4) ? std::strtof(argv[4], nullptr) : 0.0f;
+        return compare(argv[2], argv[3], tolerance);
+    }
+
+    std::string hdrPath = FileSystem::getPath("resources/textures/hdr/newport_loft.hdr");
+    std::string outPath = "newport_loft.iblcache";
+    size_t threads = 0;
+    int positional = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = std::strtoull(argv[++i], nullptr, 10);
+        else if (argv[i][0] == '-')
+            positional = -1;
+        else if (positional == 0)
+            hdrPath = argv[i], positional++;
+        else if (positional == 1)
+            outPath = argv[i], positional++;
+        else
+            positional = -1;
+
+        if (positional < 0)
+        {
+            std::printf("usage: %s [hdr] [out.iblcache] [--threads n]\n"
+                        "       %s --compare <reference.iblcache> <other.iblcache> [max relative error]\n",
+                        argv[0], argv[0]);
+            return 1;
+        }
+    }
+    return bake(hdrPath, outPath, threads);
+}
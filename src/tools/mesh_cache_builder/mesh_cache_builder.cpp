@@ -0,0 +1,88 @@
+#include <learnopengl/filesystem.h>
+
+#include <pcontum/mesh_cache.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Offline mesh cache converter: parses the game's models with Assimp and writes the .meshcache files the
+// game would otherwise write on its first run. Also times the Assimp parse against mapping the cache.
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int convert(const std::string &sourcePath)
+{
+    uint64_t key = meshCacheKey(sourcePath);
+    if (key == 0)
+    {
+        std::printf("can't read %s\n", sourcePath.c_str());
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    ModelData parsed = parseModel(sourcePath);
+    double parseSeconds = secondsSince(start);
+    if (!parsed.loaded)
+        return 1;
+
+    std::string cachePath = meshCachePath(sourcePath);
+    if (!writeMeshCache(cachePath, key, parsed))
+    {
+        std::printf("can't write %s\n", cachePath.c_str());
+        return 1;
+    }
+
+    start = std::chrono::steady_clock::now();
+    ModelData mapped;
+    bool ok = readMeshCache(cachePath, key, sourcePath, mapped);
+    double mapSeconds = secondsSince(start);
+    if (!ok)
+    {
+        std::printf("can't read back %s\n", cachePath.c_str());
+        return 1;
+    }
+
+    size_t vertices = 0, indices = 0;
+    double misses = 0.0;
+    std::vector<size_t> lodIndices(MESH_LOD_LEVELS - 1, 0);
+    for (const MeshData &mesh : mapped.meshes)
+    {
+        vertices += mesh.vertexCount;
+        indices += mesh.indexCount;
+        misses += vertexCacheMissRatio(mesh.indexData, mesh.indexCount, mesh.vertexCount) * (mesh.indexCount / 3);
+        for (size_t level = 0; level < mesh.lods.size() && level < lodIndices.size(); ++level)
+            lodIndices[level] += mesh.lods[level].indexCount;
+    }
+    std::printf("%s: %zu meshes, %zu vertices, %zu indices, %zu bytes\n", cachePath.c_str(), mapped.meshes.size(),
+                vertices, indices, mapped.mapping->size());
+    std::printf("  LOD triangles:");
+    for (size_t level = 0; level < lodIndices.size(); ++level)
+        std::printf(" %zu", lodIndices[level] / 3);
+    std::printf(" (full %zu)\n", indices / 3);
+    std::printf("  vertices %zu KB (float layout %zu KB), ACMR %.3f\n", vertices * sizeof(PackedVertex) / 1024,
+                vertices * sizeof(Vertex) / 1024, indices ? misses / (indices / 3) : 0.0);
+    std::printf("  assimp %.1f ms, mapped %.3f ms\n", parseSeconds * 1000.0, mapSeconds * 1000.0);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::string> sources;
+    for (int i = 1; i < argc; ++i)
+        sources.push_back(argv[i]);
+    if (sources.empty())
+    {
+        sources.push_back(FileSystem::getPath("resources/objects/kaan/kaan.dae"));
+        sources.push_back(FileSystem::getPath("resources/objects/ettayyariyyetul_gemiyye/ettayyariyyetul_gemiyye.dae"));
+    }
+
+    int result = 0;
+    for (const std::string &source : sources)
+        result |= convert(source);
+    return result;
+}
@@ -0,0 +1,46 @@
+#include <pcontum/telemetry.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Offline telemetry decoder: turns the binary flight.telemetry the game writes into CSV, one row per
+// simulation tick. Usage: tools__telemetry_to_csv [input.telemetry] [output.csv]; without an output the
+// CSV goes to stdout.
+
+const char *DEFAULT_INPUT = "flight.telemetry";
+
+int main(int argc, char *argv[])
+{
+    std::string inputPath = argc > 1 ? argv[1] : DEFAULT_INPUT;
+    std::vector<TelemetryRecord> records;
+    if (!readTelemetry(inputPath, records))
+    {
+        std::fprintf(stderr, "can't read %s\n", inputPath.c_str());
+        return 1;
+    }
+
+    FILE *out = stdout;
+    if (argc > 2)
+    {
+        out = std::fopen(argv[2], "w");
+        if (!out)
+        {
+            std::fprintf(stderr, "can't write %s\n", argv[2]);
+            return 1;
+        }
+    }
+
+    std::fprintf(out, "tick,time,x,y,z,pitch,yaw,roll,speed,pitch_rate,camera_x,camera_y,camera_z,cobra,touching_ground\n");
+    for (const TelemetryRecord &r : records)
+    {
+        std::fprintf(out, "%llu,%.6f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%d,%d\n",
+                     static_cast<unsigned long long>(r.tick), r.time, r.position[0], r.position[1], r.position[2],
+                     r.pitch, r.yaw, r.roll, r.speed, r.pitchRate, r.cameraOffset[0], r.cameraOffset[1],
+                     r.cameraOffset[2], (r.flags & TELEMETRY_COBRA) ? 1 : 0, (r.flags & TELEMETRY_TOUCHING_GROUND) ? 1 : 0);
+    }
+    if (out != stdout)
+        std::fclose(out);
+    std::fprintf(stderr, "%s: %zu records\n", inputPath.c_str(), records.size());
+    return 0;
+}